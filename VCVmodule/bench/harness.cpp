@@ -0,0 +1,228 @@
+#include "harness.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <pmmintrin.h>
+
+void init(Plugin* p);
+
+namespace harness {
+
+Plugin* loadPlugin() {
+    static Plugin plugin;
+    if (plugin.models.empty()) {
+        plugin.slug = "MADZINE";
+        init(&plugin);
+    }
+    return &plugin;
+}
+
+// Scripted patches: a 120 BPM sixteenth-note clock (8 Hz) wherever a module
+// takes a clock, slow LFOs on CV inputs so pattern/frequency code paths keep
+// moving, and audio-rate saws on audio inputs.
+const std::vector<Scenario>& defaultScenarios() {
+    static std::vector<Scenario> scenarios;
+    if (!scenarios.empty())
+        return scenarios;
+
+    Scenario swingLFO;
+    swingLFO.slug = "SwingLFO";
+    swingLFO.cables.push_back({"Frequency CV", lfoSignal(0.1f, 2.f)});
+    swingLFO.cables.push_back({"Shape CV", lfoSignal(0.07f, 5.f)});
+    swingLFO.params.push_back({"Freq CV Attenuverter", 0.5f});
+    swingLFO.params.push_back({"Shape CV Attenuverter", 0.5f});
+    scenarios.push_back(swingLFO);
+
+    Scenario euclidean;
+    euclidean.slug = "EuclideanRhythm";
+    euclidean.cables.push_back({"Global Clock", clockSignal(8.f)});
+    euclidean.cables.push_back({"T1 Fill CV", lfoSignal(0.1f, 5.f)});
+    euclidean.cables.push_back({"T2 Length CV", lfoSignal(0.05f, 5.f)});
+    euclidean.params.push_back({"T1 Fill CV", 1.f});
+    euclidean.params.push_back({"T2 Length CV", 1.f});
+    euclidean.params.push_back({"T3 Div/Mult", 2.f});
+    scenarios.push_back(euclidean);
+
+    Scenario adGenerator;
+    adGenerator.slug = "ADGenerator";
+    adGenerator.cables.push_back({"Track 1 Trigger", clockSignal(4.f)});
+    adGenerator.cables.push_back({"Track 2 Trigger", clockSignal(6.f)});
+    adGenerator.cables.push_back({"Track 3 Trigger", clockSignal(8.f)});
+    adGenerator.params.push_back({"Track 1 BPF Enable", 1.f});
+    adGenerator.params.push_back({"Track 3 BPF Enable", 1.f});
+    scenarios.push_back(adGenerator);
+
+    Scenario pinpple;
+    pinpple.slug = "Pinpple";
+    pinpple.cables.push_back({"Trigger", clockSignal(4.f)});
+    pinpple.cables.push_back({"1V/Oct Frequency CV", lfoSignal(0.2f, 1.f)});
+    pinpple.cables.push_back({"FM", sawSignal(110.f, 5.f)});
+    pinpple.params.push_back({"Freq CV Attenuverter", 1.f});
+    pinpple.params.push_back({"FM Amount", 0.2f});
+    scenarios.push_back(pinpple);
+
+    Scenario ppattterning;
+    ppattterning.slug = "PPaTTTerning";
+    ppattterning.cables.push_back({"Clock", clockSignal(8.f)});
+    ppattterning.params.push_back({"Chaos", 0.3f});
+    ppattterning.params.push_back({"CVD Time/Attenuation", 0.5f});
+    scenarios.push_back(ppattterning);
+
+    Scenario maddy;
+    maddy.slug = "MADDY";
+    maddy.params.push_back({"Frequency", 3.f});
+    maddy.params.push_back({"Chaos", 0.3f});
+    scenarios.push_back(maddy);
+
+    Scenario twnc;
+    twnc.slug = "TWNC";
+    twnc.cables.push_back({"Global Clock", clockSignal(8.f)});
+    twnc.cables.push_back({"Drum Frequency CV", lfoSignal(0.1f, 1.f)});
+    twnc.cables.push_back({"Hats Decay CV", lfoSignal(0.13f, 3.f)});
+    twnc.params.push_back({"Track 2 Noise FM", 0.5f});
+    scenarios.push_back(twnc);
+
+    Scenario twncLight;
+    twncLight.slug = "TWNCLight";
+    twncLight.cables.push_back({"Global Clock", clockSignal(8.f)});
+    twncLight.cables.push_back({"Drum Decay CV", lfoSignal(0.1f, 3.f)});
+    scenarios.push_back(twncLight);
+
+    Scenario qq;
+    qq.slug = "QQ";
+    qq.cables.push_back({"Track 1 Trigger", clockSignal(2.f)});
+    qq.cables.push_back({"Track 2 Trigger", clockSignal(3.f)});
+    qq.cables.push_back({"Track 3 Trigger", clockSignal(5.f)});
+    qq.cables.push_back({"Track 1 Decay CV", lfoSignal(0.2f, 5.f)});
+    scenarios.push_back(qq);
+
+    Scenario observer;
+    observer.slug = "Observer";
+    for (int i = 0; i < 8; i++) {
+        std::string name = string::f("Track %d", i + 1);
+        if (i % 2 == 0)
+            observer.cables.push_back({name, lfoSignal(0.5f * (i + 1), 5.f)});
+        else
+            observer.cables.push_back({name, sawSignal(55.f * (i + 1), 5.f)});
+    }
+    scenarios.push_back(observer);
+
+    return scenarios;
+}
+
+const Scenario* findScenario(const std::string& slug) {
+    for (const Scenario& scenario : defaultScenarios()) {
+        if (scenario.slug == slug)
+            return &scenario;
+    }
+    return NULL;
+}
+
+void setFlushDenormals(bool enabled) {
+    if (enabled)
+        _mm_setcsr(_mm_getcsr() | 0x8040);
+    else
+        _mm_setcsr(_mm_getcsr() & ~0x8040);
+}
+
+Rig::Rig(const Scenario& scenario, float sampleRate, uint64_t seed) {
+    model = loadPlugin()->getModel(scenario.slug);
+    if (!model) {
+        std::fprintf(stderr, "harness: unknown module %s\n", scenario.slug.c_str());
+        std::exit(1);
+    }
+    // Fixed seed per instance so noise and chaos render identically run to run.
+    random::local().seed(seed, 0x6861726e657373ULL);
+    module = model->createModule();
+    APP->engine->addModule(module);
+    scopeModule = dynamic_cast<ScopeModule*>(module);
+
+    // Every output is treated as patched, the way it would be in a real rack.
+    for (Output& output : module->outputs)
+        output.channels = 1;
+
+    for (const ParamSetting& setting : scenario.params) {
+        bool found = false;
+        for (ParamQuantity* pq : module->paramQuantities) {
+            if (pq && pq->name == setting.param) {
+                pq->setValue(setting.value);
+                found = true;
+                break;
+            }
+        }
+        if (!found) {
+            std::fprintf(stderr, "harness: %s has no param \"%s\"\n", scenario.slug.c_str(), setting.param.c_str());
+            std::exit(1);
+        }
+    }
+
+    for (const Cable& cable : scenario.cables) {
+        Input* input = NULL;
+        for (size_t i = 0; i < module->inputInfos.size(); i++) {
+            if (module->inputInfos[i] && module->inputInfos[i]->name == cable.input) {
+                input = &module->inputs[i];
+                break;
+            }
+        }
+        if (!input) {
+            std::fprintf(stderr, "harness: %s has no input \"%s\"\n", scenario.slug.c_str(), cable.input.c_str());
+            std::exit(1);
+        }
+        int channels = clamp(cable.signal.channels, 1, PORT_MAX_CHANNELS);
+        input->channels = channels;
+        for (int c = 0; c < channels; c++) {
+            Drive drive;
+            drive.input = input;
+            drive.channel = c;
+            drive.signal = cable.signal;
+            drive.phase = (double) c / channels;
+            drives.push_back(drive);
+        }
+    }
+    block.resize(drives.size() * BLOCK_SIZE);
+
+    setSampleRate(sampleRate);
+}
+
+Rig::~Rig() {
+    APP->engine->removeModule(module);
+    delete module;
+}
+
+void Rig::setSampleRate(float sampleRate) {
+    APP->engine->sampleRate = sampleRate;
+    args.sampleRate = sampleRate;
+    args.sampleTime = 1.f / sampleRate;
+
+    Module::SampleRateChangeEvent e;
+    e.sampleRate = sampleRate;
+    e.sampleTime = 1.f / sampleRate;
+    module->onSampleRateChange(e);
+}
+
+void Rig::fillBlock() {
+    if (scopeModule)
+        scopeModule->growScope();
+    const double sampleTime = 1.0 / args.sampleRate;
+    for (size_t d = 0; d < drives.size(); d++) {
+        Drive& drive = drives[d];
+        const Signal& s = drive.signal;
+        float* out = &block[d * BLOCK_SIZE];
+        const double delta = s.rate * sampleTime;
+        const double pulseWidth = s.rate * 1e-3;
+        for (int i = 0; i < BLOCK_SIZE; i++) {
+            float v = s.offset;
+            switch (s.kind) {
+                case CLOCK: v = (drive.phase < pulseWidth) ? 10.f : 0.f; break;
+                case LFO: v = s.offset + s.amplitude * (float) std::sin(2.0 * M_PI * drive.phase); break;
+                case SAW: v = s.offset + s.amplitude * (float) (2.0 * drive.phase - 1.0); break;
+                case CONSTANT: break;
+            }
+            out[i] = v;
+            drive.phase += delta;
+            if (drive.phase >= 1.0)
+                drive.phase -= 1.0;
+        }
+    }
+}
+
+} // namespace harness
@@ -0,0 +1,105 @@
+#pragma once
+#include "plugin.hpp"
+#include "scope.hpp"
+#include <string>
+#include <vector>
+
+// Shared pieces of the headless harness: loading the plugin, describing a
+// scripted patch for each module and stepping one instance sample by sample.
+
+namespace harness {
+
+enum SignalKind {
+    CLOCK,      // 10V pulses, 1 ms wide, `rate` per second
+    LFO,        // sine, `offset` +/- `amplitude`
+    SAW,        // rising saw, `offset` +/- `amplitude`
+    CONSTANT    // `offset`
+};
+
+struct Signal {
+    SignalKind kind = CONSTANT;
+    float rate = 0.f;
+    float amplitude = 0.f;
+    float offset = 0.f;
+    // Polyphonic cables carry the same signal on every channel, channel c
+    // starting c / channels of a cycle later.
+    int channels = 1;
+};
+
+inline Signal clockSignal(float rate) { Signal s; s.kind = CLOCK; s.rate = rate; return s; }
+inline Signal lfoSignal(float rate, float amplitude, float offset = 0.f) { Signal s; s.kind = LFO; s.rate = rate; s.amplitude = amplitude; s.offset = offset; return s; }
+inline Signal sawSignal(float rate, float amplitude, float offset = 0.f) { Signal s; s.kind = SAW; s.rate = rate; s.amplitude = amplitude; s.offset = offset; return s; }
+inline Signal constantSignal(float value) { Signal s; s.kind = CONSTANT; s.offset = value; return s; }
+inline Signal polySignal(Signal s, int channels) { s.channels = channels; return s; }
+
+// Inputs and params are addressed by the names given to configInput() and
+// configParam(), so scenarios don't depend on each module's enum layout.
+struct Cable {
+    std::string input;
+    Signal signal;
+};
+
+struct ParamSetting {
+    std::string param;
+    float value;
+};
+
+struct Scenario {
+    std::string slug;
+    std::vector<Cable> cables;
+    std::vector<ParamSetting> params;
+};
+
+Plugin* loadPlugin();
+const std::vector<Scenario>& defaultScenarios();
+const Scenario* findScenario(const std::string& slug);
+
+// Mirrors what Rack's engine does for its worker threads (flush denormals to
+// zero, treat denormal inputs as zero).
+void setFlushDenormals(bool enabled);
+
+struct Rig {
+    static constexpr int BLOCK_SIZE = 256;
+
+    Model* model = NULL;
+    Module* module = NULL;
+    // `module` again if it keeps a scope, which fillBlock() lets grow.
+    ScopeModule* scopeModule = NULL;
+    Module::ProcessArgs args;
+
+    // One per patched input channel.
+    struct Drive {
+        Input* input;
+        int channel;
+        Signal signal;
+        double phase;
+    };
+    std::vector<Drive> drives;
+    std::vector<float> block;  // drives.size() x BLOCK_SIZE, drive-major
+
+    double checksum = 0.0;
+
+    static constexpr uint64_t DEFAULT_SEED = 0x4d41445a494e45ULL;
+
+    Rig(const Scenario& scenario, float sampleRate, uint64_t seed = DEFAULT_SEED);
+    ~Rig();
+
+    void setSampleRate(float sampleRate);
+    // Renders the next BLOCK_SIZE frames of every scripted input into `block`.
+    // Also stands in for the UI thread, which builds the storage a scope
+    // module asks for.
+    void fillBlock();
+    // Applies frame `i` of the current block and runs process() once.
+    void step(int i) {
+        for (size_t d = 0; d < drives.size(); d++)
+            drives[d].input->setVoltage(block[d * BLOCK_SIZE + i], drives[d].channel);
+        module->process(args);
+        args.frame++;
+        for (Output& output : module->outputs) {
+            for (int c = 0; c < output.getChannels(); c++)
+                checksum += std::fabs(output.getVoltage(c));
+        }
+    }
+};
+
+} // namespace harness
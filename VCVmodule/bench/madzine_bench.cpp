@@ -0,0 +1,183 @@
+// Offline throughput benchmark for every MADZINE module.
+//
+// Each module is patched with its scripted scenario (see harness.cpp), then
+// process() is driven for a fixed amount of audio time at each sample rate.
+// The best of several repeats is reported as ns/sample, share of one core and
+// real-time factor, together with an output checksum so that accidental
+// behaviour changes are visible next to the timing. Built with
+// MADZINE_DENORMAL_STATS (make denormals) it also reports how many denormal
+// state values each module flushed during the timed run.
+
+#include "harness.hpp"
+#include "denormal.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+struct BenchOptions {
+    float seconds = 10.f;
+    int repeats = 3;
+    bool flushDenormals = true;
+    bool csv = false;
+    int polyChannels = 1;
+    std::vector<float> sampleRates = {44100.f, 48000.f, 96000.f, 192000.f};
+    std::vector<std::string> slugs;
+};
+
+#ifdef MADZINE_DENORMAL_STATS
+static const bool kDenormalStats = true;
+#else
+static const bool kDenormalStats = false;
+#endif
+
+struct BenchResult {
+    double nsPerSample = 0.0;
+    double checksum = 0.0;
+    uint64_t denormals = 0;
+};
+
+static BenchResult runBench(const harness::Scenario& scenario, float sampleRate, const BenchOptions& options) {
+    BenchResult best;
+    for (int r = 0; r < options.repeats; r++) {
+        harness::Rig rig(scenario, sampleRate);
+
+        // Let start-up transients (pattern generation, filter warm-up) settle
+        // before timing.
+        const int64_t warmupBlocks = (int64_t) (0.1f * sampleRate) / harness::Rig::BLOCK_SIZE + 1;
+        for (int64_t b = 0; b < warmupBlocks; b++) {
+            rig.fillBlock();
+            for (int i = 0; i < harness::Rig::BLOCK_SIZE; i++)
+                rig.step(i);
+        }
+        rig.checksum = 0.0;
+#ifdef MADZINE_DENORMAL_STATS
+        denormalFlushCount() = 0;
+#endif
+
+        const int64_t blocks = (int64_t) (options.seconds * sampleRate) / harness::Rig::BLOCK_SIZE;
+        std::chrono::steady_clock::duration elapsed(0);
+        for (int64_t b = 0; b < blocks; b++) {
+            rig.fillBlock();
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < harness::Rig::BLOCK_SIZE; i++)
+                rig.step(i);
+            elapsed += std::chrono::steady_clock::now() - start;
+        }
+
+        double ns = std::chrono::duration<double, std::nano>(elapsed).count();
+        double nsPerSample = ns / (double) (blocks * harness::Rig::BLOCK_SIZE);
+        if (r == 0 || nsPerSample < best.nsPerSample)
+            best.nsPerSample = nsPerSample;
+        best.checksum = rig.checksum;
+#ifdef MADZINE_DENORMAL_STATS
+        best.denormals = denormalFlushCount();
+#endif
+    }
+    return best;
+}
+
+static std::vector<float> parseRates(const char* arg) {
+    std::vector<float> rates;
+    std::stringstream ss(arg);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty())
+            rates.push_back(std::atof(item.c_str()));
+    }
+    return rates;
+}
+
+static void printUsage() {
+    std::printf(
+        "usage: madzine-bench [options]\n"
+        "  --seconds S       audio seconds rendered per run (default 10)\n"
+        "  --rates A,B,...   sample rates in Hz (default 44100,48000,96000,192000)\n"
+        "  --module SLUG     only benchmark SLUG (repeatable)\n"
+        "  --repeat N        runs per case, best is reported (default 3)\n"
+        "  --poly N          patch every scripted input with N channels\n"
+        "  --no-ftz          leave denormals enabled (Rack flushes them)\n"
+        "  --csv             machine-readable output\n"
+        "  --list            list module slugs\n");
+}
+
+int main(int argc, char** argv) {
+    BenchOptions options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = (i + 1 < argc);
+        if (arg == "--seconds" && hasValue) {
+            options.seconds = std::atof(argv[++i]);
+        }
+        else if (arg == "--rates" && hasValue) {
+            options.sampleRates = parseRates(argv[++i]);
+        }
+        else if (arg == "--module" && hasValue) {
+            options.slugs.push_back(argv[++i]);
+        }
+        else if (arg == "--repeat" && hasValue) {
+            options.repeats = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (arg == "--poly" && hasValue) {
+            options.polyChannels = clamp(std::atoi(argv[++i]), 1, PORT_MAX_CHANNELS);
+        }
+        else if (arg == "--no-ftz") {
+            options.flushDenormals = false;
+        }
+        else if (arg == "--csv") {
+            options.csv = true;
+        }
+        else if (arg == "--list") {
+            for (const harness::Scenario& scenario : harness::defaultScenarios())
+                std::printf("%s\n", scenario.slug.c_str());
+            return 0;
+        }
+        else {
+            printUsage();
+            return (arg == "--help" || arg == "-h") ? 0 : 1;
+        }
+    }
+
+    if (options.slugs.empty()) {
+        for (const harness::Scenario& scenario : harness::defaultScenarios())
+            options.slugs.push_back(scenario.slug);
+    }
+
+    harness::setFlushDenormals(options.flushDenormals);
+
+    if (options.csv)
+        std::printf("module,sample_rate,ns_per_sample,core_percent,realtime_factor,checksum%s\n", kDenormalStats ? ",denormals" : "");
+    else
+        std::printf("%-16s %8s %12s %8s %12s %16s%s\n", "module", "rate", "ns/sample", "core%", "x realtime", "checksum", kDenormalStats ? "    denormals" : "");
+
+    for (const std::string& slug : options.slugs) {
+        const harness::Scenario* found = harness::findScenario(slug);
+        if (!found) {
+            std::fprintf(stderr, "madzine-bench: unknown module %s\n", slug.c_str());
+            return 1;
+        }
+        harness::Scenario scenario = *found;
+        for (harness::Cable& cable : scenario.cables)
+            cable.signal.channels = options.polyChannels;
+        for (float sampleRate : options.sampleRates) {
+            BenchResult result = runBench(scenario, sampleRate, options);
+            double budgetNs = 1e9 / sampleRate;
+            double corePercent = 100.0 * result.nsPerSample / budgetNs;
+            double realtimeFactor = budgetNs / result.nsPerSample;
+            if (options.csv) {
+                std::printf("%s,%.0f,%.3f,%.4f,%.1f,%.6e", slug.c_str(), sampleRate, result.nsPerSample, corePercent, realtimeFactor, result.checksum);
+                if (kDenormalStats)
+                    std::printf(",%llu", (unsigned long long) result.denormals);
+            }
+            else {
+                std::printf("%-16s %8.0f %12.1f %8.3f %12.0f %16.6e", slug.c_str(), sampleRate, result.nsPerSample, corePercent, realtimeFactor, result.checksum);
+                if (kDenormalStats)
+                    std::printf(" %12llu", (unsigned long long) result.denormals);
+            }
+            std::printf("\n");
+            std::fflush(stdout);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,180 @@
+// Accuracy and speed check for madzine_dsp/fastmath.hpp.
+//
+// Every function is swept over its documented range and compared with libm
+// in double precision. The float and float_4 versions are both checked
+// against the bound documented in fastmath.hpp, so a change to either one
+// that loosens the error fails here. Each function is also timed against
+// the libm call it replaces. All three timings include a std::function
+// call (per value, or per four for float_4), so compare them with each other.
+//
+//   madzine-fastmath [--points N]
+
+#include <rack.hpp>
+#include "fastmath.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <vector>
+
+using namespace rack;
+
+typedef simd::float_4 float_4;
+
+struct Check {
+    std::string name;
+    // Inputs
+    float lo, hi;
+    bool logSpaced;
+    std::function<float(float)> scalar;
+    std::function<float_4(float_4)> vector;
+    std::function<float(float)> libm;
+    std::function<double(double)> exact;
+    // Error allowed at x with the exact value y.
+    std::function<double(double x, double y)> bound;
+};
+
+static std::vector<float> sweep(const Check& check, int points) {
+    std::vector<float> xs(points);
+    for (int i = 0; i < points; i++) {
+        double t = (double) i / (points - 1);
+        xs[i] = check.logSpaced ? (float) (check.lo * std::pow((double) check.hi / check.lo, t)) : (float) (check.lo + (check.hi - check.lo) * t);
+    }
+    return xs;
+}
+
+// Worst error as a multiple of the bound, for one version over all inputs.
+static double worstRatio(const Check& check, const std::vector<float>& xs, const std::vector<float>& ys, double* worstX) {
+    double worst = 0.0;
+    for (size_t i = 0; i < xs.size(); i++) {
+        double exact = check.exact(xs[i]);
+        double ratio = std::fabs(ys[i] - exact) / check.bound(xs[i], exact);
+        if (!(ratio <= worst)) {
+            worst = ratio;
+            *worstX = xs[i];
+        }
+    }
+    return worst;
+}
+
+template <typename F>
+static double nsPerValue(const std::vector<float>& xs, F f) {
+    volatile float sink = 0.f;
+    double best = 1e30;
+    for (int r = 0; r < 5; r++) {
+        auto start = std::chrono::steady_clock::now();
+        float sum = 0.f;
+        for (size_t i = 0; i + 4 <= xs.size(); i += 4)
+            sum += f(&xs[i]);
+        sink = sink + sum;
+        best = std::min(best, std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / xs.size());
+    }
+    return best;
+}
+
+static bool runCheck(const Check& check, int points) {
+    std::vector<float> xs = sweep(check, points);
+    xs.resize(xs.size() / 4 * 4);
+
+    std::vector<float> scalarYs(xs.size()), vectorYs(xs.size());
+    for (size_t i = 0; i < xs.size(); i++)
+        scalarYs[i] = check.scalar(xs[i]);
+    for (size_t i = 0; i < xs.size(); i += 4)
+        check.vector(float_4::load(&xs[i])).store(&vectorYs[i]);
+
+    double scalarX = 0.0, vectorX = 0.0;
+    double scalarRatio = worstRatio(check, xs, scalarYs, &scalarX);
+    double vectorRatio = worstRatio(check, xs, vectorYs, &vectorX);
+
+    double libmNs = nsPerValue(xs, [&](const float* x) {
+        return check.libm(x[0]) + check.libm(x[1]) + check.libm(x[2]) + check.libm(x[3]);
+    });
+    double scalarNs = nsPerValue(xs, [&](const float* x) {
+        return check.scalar(x[0]) + check.scalar(x[1]) + check.scalar(x[2]) + check.scalar(x[3]);
+    });
+    double vectorNs = nsPerValue(xs, [&](const float* x) {
+        float_4 y = check.vector(float_4::load(x));
+        return y[0] + y[1] + y[2] + y[3];
+    });
+
+    bool pass = scalarRatio <= 1.0 && vectorRatio <= 1.0;
+    std::printf("%-12s %10.3f %10.3f %12g %8.2f %8.2f %8.2f  %s\n", check.name.c_str(), scalarRatio, vectorRatio,
+                scalarRatio >= vectorRatio ? scalarX : vectorX, libmNs, scalarNs, vectorNs, pass ? "ok" : "FAIL");
+    return pass;
+}
+
+static std::function<double(double, double)> relative(double e) {
+    return [=](double x, double y) { return e * std::fabs(y); };
+}
+
+static std::function<double(double, double)> phase() {
+    return [](double x, double y) { return 5e-6 + 4e-7 * std::fabs(x); };
+}
+
+int main(int argc, char** argv) {
+    int points = 1 << 20;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--points" && i + 1 < argc) {
+            points = std::max(8, std::atoi(argv[++i]));
+        }
+        else {
+            std::printf(
+                "usage: madzine-fastmath [options]\n"
+                "  --points N        inputs swept per function (default 1048576)\n");
+            return (arg == "--help" || arg == "-h") ? 0 : 1;
+        }
+    }
+
+    const double TWO_PI = 2.0 * M_PI;
+    std::vector<Check> checks = {
+        {"exp2", -126.f, 126.f, false,
+         [](float x) { return fastExp2(x); }, [](float_4 x) { return fastExp2(x); },
+         [](float x) { return std::exp2(x); }, [](double x) { return std::exp2(x); }, relative(3e-7)},
+        {"exp", -87.f, 87.f, false,
+         [](float x) { return fastExp(x); }, [](float_4 x) { return fastExp(x); },
+         [](float x) { return std::exp(x); }, [](double x) { return std::exp(x); },
+         [](double x, double y) { return (3e-7 + 8e-8 * std::fabs(x)) * y; }},
+        {"pow10", -37.f, 37.f, false,
+         [](float x) { return fastPow10(x); }, [](float_4 x) { return fastPow10(x); },
+         [](float x) { return std::pow(10.f, x); }, [](double x) { return std::pow(10.0, x); },
+         [](double x, double y) { return (3e-7 + 2e-7 * std::fabs(x)) * y; }},
+        {"log2", 1.2e-38f, 3e38f, true,
+         [](float x) { return fastLog2(x); }, [](float_4 x) { return fastLog2(x); },
+         [](float x) { return std::log2(x); }, [](double x) { return std::log2(x); },
+         [](double x, double y) { return 3e-7 + 6e-8 * std::fabs(y); }},
+        {"sin2pi", -64.f, 64.f, false,
+         [](float x) { return fastSin2pi(x); }, [](float_4 x) { return fastSin2pi(x); },
+         [=](float x) { return std::sin((float) TWO_PI * x); }, [=](double x) { return std::sin(TWO_PI * x); }, phase()},
+        {"cos2pi", -64.f, 64.f, false,
+         [](float x) { return fastCos2pi(x); }, [](float_4 x) { return fastCos2pi(x); },
+         [=](float x) { return std::cos((float) TWO_PI * x); }, [=](double x) { return std::cos(TWO_PI * x); }, phase()},
+    };
+    // pow(x, y) for a spread of exponents, including the -1.5 .. 1.5 of
+    // ADGenerator's curve.
+    const float exponents[] = {-4.f, -1.5f, 0.3f, 0.5f, 1.5f, 4.f};
+    for (float y : exponents) {
+        checks.push_back({"pow y=" + std::to_string(y).substr(0, 4), 1e-3f, 1e3f, true,
+                          [=](float x) { return fastPow(x, y); }, [=](float_4 x) { return fastPow(x, float_4(y)); },
+                          [=](float x) { return std::pow(x, y); }, [=](double x) { return std::pow(x, (double) y); },
+                          [=](double x, double r) { return 3e-7 * (1.0 + std::fabs(y * std::log2(x))) * r; }});
+    }
+
+    std::printf("%-12s %10s %10s %12s %8s %8s %8s\n", "", "err/bound", "float_4", "worst at", "libm ns", "ns", "float_4");
+    int failures = 0;
+    for (const Check& check : checks) {
+        if (!runCheck(check, points))
+            failures++;
+    }
+
+    // Edges the sweeps don't reach.
+    bool edges = fastPow(0.f, 0.3f) == 0.f && fastPow(-1.f, 2.f) == 0.f && fastExp2(-1000.f) > 0.f && std::isfinite(fastExp2(1000.f)) && fastPow(float_4(0.f), float_4(0.3f))[0] == 0.f;
+    std::printf("%-12s %s\n", "edges", edges ? "ok" : "FAIL");
+    failures += !edges;
+
+    std::printf("%d/%d within their documented bounds\n", (int) checks.size() + 1 - failures, (int) checks.size() + 1);
+    return failures ? 1 : 0;
+}
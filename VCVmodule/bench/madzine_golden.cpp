@@ -0,0 +1,478 @@
+// Golden-output regression suite.
+//
+// Every case fixes a module, its patch (inputs and params), the sample rate,
+// the RNG seed and the render length. The rendered outputs and lights are
+// reduced to min/max/mean per 16-sample block and compared against the
+// reference stored in golden/<case>.golden, within the case's tolerance.
+//
+//   madzine-golden             compare every case against its reference
+//   madzine-golden --record    (re)write the references from the current code
+//
+// Cases marked `scope` record the last scope frame the module published
+// instead: one trace per drawn channel, with the min/max of each of its
+// points (mean is their midpoint, 0 for points not drawn yet).
+//
+// A block summary keeps the corpus small while still catching one-sample
+// timing shifts on gates (they move the block mean by 1/16 of the gate
+// height) and any audible change in amplitude or waveform.
+
+#include "harness.hpp"
+#include "scope.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+static const int GOLDEN_BLOCK = 16;
+// Reference values are stored as int16 over +/-12V (0.37 mV resolution).
+static const float GOLDEN_RANGE = 12.f;
+static const char GOLDEN_MAGIC[4] = {'M', 'Z', 'G', '1'};
+
+struct GoldenCase {
+    std::string name;
+    harness::Scenario scenario;
+    float sampleRate;
+    float seconds;
+    // Largest allowed difference in volts on any block min/max/mean.
+    float tolerance;
+    uint64_t seed;
+    // Output channels recorded per output; left out (0) for mono cases.
+    int channels;
+    // Records the last published ScopeFrame rather than outputs and lights.
+    bool scope;
+};
+
+// Gate/trigger and CV sequencers must match to quantisation precision. Audio
+// engines get a little headroom for compiler and libm differences.
+static const float EXACT = 2e-3f;
+static const float AUDIO = 2e-2f;
+
+static std::vector<GoldenCase> goldenCases() {
+    using namespace harness;
+    std::vector<GoldenCase> cases;
+
+    {
+        GoldenCase c = {"SwingLFO_48k", Scenario(), 48000.f, 0.5f, EXACT, 1};
+        c.scenario.slug = "SwingLFO";
+        c.scenario.cables.push_back({"Swing CV", lfoSignal(2.f, 5.f)});
+        c.scenario.cables.push_back({"Shape CV", lfoSignal(1.3f, 5.f)});
+        c.scenario.params.push_back({"Frequency", 3.f});
+        c.scenario.params.push_back({"Swing CV Attenuverter", 1.f});
+        c.scenario.params.push_back({"Shape CV Attenuverter", 0.5f});
+        cases.push_back(c);
+    }
+    {
+        GoldenCase c = {"EuclideanRhythm_triggers_48k", Scenario(), 48000.f, 1.f, EXACT, 1};
+        c.scenario.slug = "EuclideanRhythm";
+        c.scenario.cables.push_back({"Global Clock", clockSignal(32.f)});
+        c.scenario.cables.push_back({"T1 Fill CV", lfoSignal(1.f, 5.f)});
+        c.scenario.params.push_back({"T1 Fill CV", 1.f});
+        c.scenario.params.push_back({"T2 Div/Mult", -1.f});
+        c.scenario.params.push_back({"T2 Length", 12.f});
+        c.scenario.params.push_back({"T2 Fill", 50.f});
+        c.scenario.params.push_back({"T3 Div/Mult", 2.f});
+        c.scenario.params.push_back({"T3 Length", 7.f});
+        c.scenario.params.push_back({"T3 Fill", 40.f});
+        c.scenario.params.push_back({"T3 Shift", 3.f});
+        cases.push_back(c);
+    }
+    {
+        GoldenCase c = {"ADGenerator_bpf_48k", Scenario(), 48000.f, 0.5f, AUDIO, 1};
+        c.scenario.slug = "ADGenerator";
+        c.scenario.cables.push_back({"Track 1 Trigger", clockSignal(8.f)});
+        c.scenario.cables.push_back({"Track 2 Trigger", clockSignal(12.f)});
+        c.scenario.cables.push_back({"Track 3 Trigger", clockSignal(16.f)});
+        c.scenario.params.push_back({"Track 1 BPF Enable", 1.f});
+        c.scenario.params.push_back({"Track 2 Curve", 0.6f});
+        c.scenario.params.push_back({"Track 3 BPF Enable", 1.f});
+        cases.push_back(c);
+    }
+    {
+        GoldenCase c = {"Pinpple_pings_48k", Scenario(), 48000.f, 0.5f, AUDIO, 1};
+        c.scenario.slug = "Pinpple";
+        c.scenario.cables.push_back({"Trigger", clockSignal(8.f)});
+        c.scenario.cables.push_back({"1V/Oct Frequency CV", lfoSignal(1.f, 2.f)});
+        c.scenario.params.push_back({"Freq CV Attenuverter", 1.f});
+        c.scenario.params.push_back({"Decay", 0.9f});
+        cases.push_back(c);
+    }
+    {
+        GoldenCase c = {"Pinpple_fm_96k", Scenario(), 96000.f, 0.25f, AUDIO, 2};
+        c.scenario.slug = "Pinpple";
+        c.scenario.cables.push_back({"Trigger", clockSignal(12.f)});
+        c.scenario.cables.push_back({"FM", sawSignal(220.f, 5.f)});
+        c.scenario.params.push_back({"FM Amount", 0.4f});
+        c.scenario.params.push_back({"Noise Mix", 0.5f});
+        c.scenario.params.push_back({"Decay", 0.8f});
+        cases.push_back(c);
+    }
+    {
+        // Sparse pings with a slow freq sweep: the module sleeps between hits
+        // and is woken both by triggers and by the CV moving.
+        GoldenCase c = {"Pinpple_sparse_44k", Scenario(), 44100.f, 3.f, AUDIO, 4};
+        c.scenario.slug = "Pinpple";
+        c.scenario.cables.push_back({"Trigger", clockSignal(1.f)});
+        c.scenario.cables.push_back({"1V/Oct Frequency CV", lfoSignal(0.2f, 2.f)});
+        c.scenario.cables.push_back({"FM", sawSignal(110.f, 5.f)});
+        c.scenario.params.push_back({"Freq CV Attenuverter", 1.f});
+        c.scenario.params.push_back({"FM Amount", 0.3f});
+        c.scenario.params.push_back({"Decay", 0.4f});
+        cases.push_back(c);
+    }
+    {
+        // Six voices: one full SIMD group and one partly used one.
+        GoldenCase c = {"Pinpple_poly_48k", Scenario(), 48000.f, 1.f, AUDIO, 5, 6};
+        c.scenario.slug = "Pinpple";
+        c.scenario.cables.push_back({"Trigger", polySignal(clockSignal(3.f), 6)});
+        c.scenario.cables.push_back({"1V/Oct Frequency CV", polySignal(lfoSignal(0.5f, 2.f), 6)});
+        c.scenario.cables.push_back({"FM", sawSignal(110.f, 5.f)});
+        c.scenario.params.push_back({"Freq CV Attenuverter", 1.f});
+        c.scenario.params.push_back({"FM Amount", 0.3f});
+        cases.push_back(c);
+    }
+    {
+        GoldenCase c = {"PPaTTTerning_cvd_48k", Scenario(), 48000.f, 1.f, EXACT, 3};
+        c.scenario.slug = "PPaTTTerning";
+        c.scenario.cables.push_back({"Clock", clockSignal(32.f)});
+        c.scenario.params.push_back({"Chaos", 0.4f});
+        c.scenario.params.push_back({"Density", 0.7f});
+        c.scenario.params.push_back({"CVD Time/Attenuation", 0.3f});
+        cases.push_back(c);
+    }
+    {
+        GoldenCase c = {"MADDY_chains_48k", Scenario(), 48000.f, 1.f, EXACT, 4};
+        c.scenario.slug = "MADDY";
+        c.scenario.params.push_back({"Frequency", 5.f});
+        c.scenario.params.push_back({"Chaos", 0.3f});
+        c.scenario.params.push_back({"Swing", 0.3f});
+        cases.push_back(c);
+    }
+    {
+        GoldenCase c = {"TWNC_kick_hats_48k", Scenario(), 48000.f, 0.5f, AUDIO, 5};
+        c.scenario.slug = "TWNC";
+        c.scenario.cables.push_back({"Global Clock", clockSignal(16.f)});
+        c.scenario.cables.push_back({"Drum Frequency CV", lfoSignal(1.f, 1.f)});
+        c.scenario.params.push_back({"Track 1 Noise Mix", 0.3f});
+        c.scenario.params.push_back({"Track 2 Fill", 75.f});
+        cases.push_back(c);
+    }
+    {
+        GoldenCase c = {"TWNC_noise_fm_44k", Scenario(), 44100.f, 0.25f, AUDIO, 6};
+        c.scenario.slug = "TWNC";
+        c.scenario.cables.push_back({"Global Clock", clockSignal(16.f)});
+        c.scenario.params.push_back({"Track 2 Noise FM", 0.7f});
+        c.scenario.params.push_back({"Track 2 Div/Mult", 3.f});
+        cases.push_back(c);
+    }
+    {
+        GoldenCase c = {"TWNCLight_envelopes_48k", Scenario(), 48000.f, 1.f, EXACT, 7};
+        c.scenario.slug = "TWNCLight";
+        c.scenario.cables.push_back({"Global Clock", clockSignal(16.f)});
+        c.scenario.cables.push_back({"Drum Decay CV", lfoSignal(1.f, 3.f)});
+        c.scenario.params.push_back({"Track 2 Div/Mult", 4.f});
+        cases.push_back(c);
+    }
+    {
+        GoldenCase c = {"QQ_envelopes_48k", Scenario(), 48000.f, 0.5f, EXACT, 8};
+        c.scenario.slug = "QQ";
+        c.scenario.cables.push_back({"Track 1 Trigger", clockSignal(8.f)});
+        c.scenario.cables.push_back({"Track 2 Trigger", clockSignal(6.f)});
+        c.scenario.cables.push_back({"Track 3 Trigger", clockSignal(10.f)});
+        c.scenario.cables.push_back({"Track 1 Decay CV", lfoSignal(2.f, 5.f)});
+        c.scenario.params.push_back({"Track 2 Shape", 0.9f});
+        c.scenario.params.push_back({"Track 3 Decay Time", 0.05f});
+        cases.push_back(c);
+    }
+    {
+        // Observer has no outputs; this covers that it runs and its light state.
+        GoldenCase c = {"Observer_capture_48k", Scenario(), 48000.f, 0.25f, EXACT, 9};
+        c.scenario = *harness::findScenario("Observer");
+        cases.push_back(c);
+    }
+    {
+        // One sweep and a half at the default time base: the frame holds the
+        // new sweep's first half over the end of the previous one. Track 2
+        // is poly, so its channels share a group with Track 1 and Track 3,
+        // and the ten channels outgrow the storage Observer starts with:
+        // nothing is recorded until the first growScope() between blocks.
+        GoldenCase c = {"Observer_scope_48k", Scenario(), 48000.f, 0.75f, EXACT, 10, 0, true};
+        c.scenario = *harness::findScenario("Observer");
+        for (Cable& cable : c.scenario.cables) {
+            if (cable.input == "Track 2")
+                cable.signal = polySignal(cable.signal, 3);
+        }
+        cases.push_back(c);
+    }
+    return cases;
+}
+
+struct Trace {
+    std::string name;
+    std::vector<float> min, max, mean;
+};
+
+static std::vector<Trace> scopeTraces(Module* m) {
+    std::vector<Trace> traces;
+    ScopeModule* module = dynamic_cast<ScopeModule*>(m);
+    if (!module)
+        return traces;
+    TripleBuffer<ScopeFrame>& frames = module->scope.load()->frames;
+    if (!frames.consume())
+        return traces;
+    const ScopeFrame& frame = frames.readBuffer();
+    for (int i = 0; i < ScopeFrame::TRACKS; i++) {
+        for (int ch = 0; ch < frame.channels[i]; ch++) {
+            Trace t;
+            t.name = string::f("scope:Track %d", i + 1) + (ch == 0 ? "" : string::f(" %d", ch + 1));
+            const ScopePoint* points = frame.track(i, ch);
+            for (int j = 0; j < ScopeFrame::POINTS; j++) {
+                const ScopePoint& point = points[j];
+                bool drawn = point.min <= point.max;
+                t.min.push_back(drawn ? clamp(point.min, -GOLDEN_RANGE, GOLDEN_RANGE) : GOLDEN_RANGE);
+                t.max.push_back(drawn ? clamp(point.max, -GOLDEN_RANGE, GOLDEN_RANGE) : -GOLDEN_RANGE);
+                t.mean.push_back(drawn ? (t.min.back() + t.max.back()) / 2 : 0.f);
+            }
+            traces.push_back(t);
+        }
+    }
+    return traces;
+}
+
+static std::vector<Trace> renderCase(const GoldenCase& c) {
+    harness::Rig rig(c.scenario, c.sampleRate, c.seed);
+    Module* m = rig.module;
+
+    std::vector<Trace> traces;
+    // (output, channel) behind each output trace; lights follow them.
+    std::vector<std::pair<int, int>> outputChannels;
+    const int channels = std::max(c.channels, 1);
+    for (size_t i = 0; i < m->outputs.size(); i++) {
+        PortInfo* info = m->outputInfos[i];
+        std::string name = "out:" + (info ? info->name : string::f("%d", (int) i));
+        for (int ch = 0; ch < channels; ch++) {
+            traces.push_back({ch == 0 ? name : name + string::f(" %d", ch + 1), {}, {}, {}});
+            outputChannels.push_back(std::make_pair((int) i, ch));
+        }
+    }
+    for (size_t i = 0; i < m->lights.size(); i++) {
+        LightInfo* info = m->lightInfos[i];
+        std::string name = (info && !info->name.empty()) ? info->name : string::f("%d", (int) i);
+        traces.push_back({string::f("light%d:", (int) i) + name, {}, {}, {}});
+    }
+
+    const int64_t frames = (int64_t) (c.seconds * c.sampleRate);
+    std::vector<float> blockMin(traces.size()), blockMax(traces.size()), blockSum(traces.size());
+    int inBlock = 0;
+    for (int64_t f = 0; f < frames; f++) {
+        int i = (int) (f % harness::Rig::BLOCK_SIZE);
+        if (i == 0)
+            rig.fillBlock();
+        rig.step(i);
+
+        for (size_t t = 0; t < traces.size(); t++) {
+            float v = (t < outputChannels.size())
+                ? m->outputs[outputChannels[t].first].getVoltage(outputChannels[t].second)
+                : m->lights[t - outputChannels.size()].getBrightness();
+            if (inBlock == 0) {
+                blockMin[t] = blockMax[t] = blockSum[t] = v;
+            }
+            else {
+                blockMin[t] = std::min(blockMin[t], v);
+                blockMax[t] = std::max(blockMax[t], v);
+                blockSum[t] += v;
+            }
+        }
+        if (++inBlock == GOLDEN_BLOCK) {
+            for (size_t t = 0; t < traces.size(); t++) {
+                traces[t].min.push_back(blockMin[t]);
+                traces[t].max.push_back(blockMax[t]);
+                traces[t].mean.push_back(blockSum[t] / GOLDEN_BLOCK);
+            }
+            inBlock = 0;
+        }
+    }
+    if (c.scope)
+        return scopeTraces(m);
+    return traces;
+}
+
+static int16_t quantize(float v) {
+    float q = std::round(clamp(v / GOLDEN_RANGE, -1.f, 1.f) * 32767.f);
+    return (int16_t) q;
+}
+
+static float dequantize(int16_t q) {
+    return q / 32767.f * GOLDEN_RANGE;
+}
+
+static bool writeGolden(const std::string& path, const std::vector<Trace>& traces) {
+    FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f)
+        return false;
+    std::fwrite(GOLDEN_MAGIC, 1, 4, f);
+    uint32_t header[2] = {(uint32_t) traces.size(), (uint32_t) (traces.empty() ? 0 : traces[0].min.size())};
+    std::fwrite(header, sizeof(uint32_t), 2, f);
+    for (const Trace& t : traces) {
+        uint32_t len = t.name.size();
+        std::fwrite(&len, sizeof(len), 1, f);
+        std::fwrite(t.name.data(), 1, len, f);
+        // Run-length encoded: gates, lights and stepped CV collapse to a few runs.
+        std::vector<int16_t> q;
+        size_t b = 0;
+        while (b < t.min.size()) {
+            int16_t triple[3] = {quantize(t.min[b]), quantize(t.max[b]), quantize(t.mean[b])};
+            size_t run = 1;
+            while (b + run < t.min.size() && run < 32767
+                && quantize(t.min[b + run]) == triple[0]
+                && quantize(t.max[b + run]) == triple[1]
+                && quantize(t.mean[b + run]) == triple[2])
+                run++;
+            q.push_back((int16_t) run);
+            q.insert(q.end(), triple, triple + 3);
+            b += run;
+        }
+        uint32_t size = q.size();
+        std::fwrite(&size, sizeof(size), 1, f);
+        std::fwrite(q.data(), sizeof(int16_t), q.size(), f);
+    }
+    std::fclose(f);
+    return true;
+}
+
+static bool readGolden(const std::string& path, std::vector<Trace>& traces) {
+    FILE* f = std::fopen(path.c_str(), "rb");
+    if (!f)
+        return false;
+    char magic[4];
+    uint32_t header[2];
+    bool ok = std::fread(magic, 1, 4, f) == 4 && std::memcmp(magic, GOLDEN_MAGIC, 4) == 0
+        && std::fread(header, sizeof(uint32_t), 2, f) == 2;
+    for (uint32_t i = 0; ok && i < header[0]; i++) {
+        Trace t;
+        uint32_t len = 0;
+        ok = std::fread(&len, sizeof(len), 1, f) == 1 && len < 1024;
+        if (!ok)
+            break;
+        t.name.resize(len);
+        ok = std::fread(&t.name[0], 1, len, f) == len;
+        uint32_t size = 0;
+        ok = ok && std::fread(&size, sizeof(size), 1, f) == 1 && size % 4 == 0;
+        std::vector<int16_t> q(ok ? size : 0);
+        ok = ok && std::fread(q.data(), sizeof(int16_t), q.size(), f) == q.size();
+        for (size_t i = 0; ok && i < q.size(); i += 4) {
+            for (int r = 0; r < q[i]; r++) {
+                t.min.push_back(dequantize(q[i + 1]));
+                t.max.push_back(dequantize(q[i + 2]));
+                t.mean.push_back(dequantize(q[i + 3]));
+            }
+        }
+        ok = ok && t.min.size() == header[1];
+        traces.push_back(t);
+    }
+    std::fclose(f);
+    return ok;
+}
+
+// Returns true when `rendered` matches `reference` within tolerance.
+static bool compareCase(const GoldenCase& c, const std::vector<Trace>& rendered, const std::vector<Trace>& reference, bool verbose) {
+    if (rendered.size() != reference.size()) {
+        std::printf("  trace count changed: %d rendered, %d in reference\n", (int) rendered.size(), (int) reference.size());
+        return false;
+    }
+    bool pass = true;
+    // Quantisation error is added on top of the case tolerance.
+    const float limit = c.tolerance + GOLDEN_RANGE / 32767.f;
+    for (size_t t = 0; t < rendered.size(); t++) {
+        const Trace& r = rendered[t];
+        const Trace& g = reference[t];
+        if (r.name != g.name || r.min.size() != g.min.size()) {
+            std::printf("  %s: layout changed (reference %s)\n", r.name.c_str(), g.name.c_str());
+            pass = false;
+            continue;
+        }
+        float worst = 0.f;
+        int worstBlock = -1;
+        for (size_t b = 0; b < r.min.size(); b++) {
+            float d = std::max(std::fabs(r.min[b] - g.min[b]), std::max(std::fabs(r.max[b] - g.max[b]), std::fabs(r.mean[b] - g.mean[b])));
+            if (d > worst) {
+                worst = d;
+                worstBlock = (int) b;
+            }
+        }
+        bool tracePass = worst <= limit;
+        if (!tracePass || verbose) {
+            std::printf("  %-40s max diff %.5f V%s", r.name.c_str(), worst, tracePass ? "\n" : "");
+            if (!tracePass && c.scope)
+                std::printf(" at point %d (limit %.5f)\n", worstBlock, limit);
+            else if (!tracePass)
+                std::printf(" at %.4f s (limit %.5f)\n", worstBlock * GOLDEN_BLOCK / c.sampleRate, limit);
+        }
+        pass = pass && tracePass;
+    }
+    return pass;
+}
+
+int main(int argc, char** argv) {
+    bool record = false;
+    bool verbose = false;
+    std::string dir = "golden";
+    std::vector<std::string> only;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--record")
+            record = true;
+        else if (arg == "--verbose" || arg == "-v")
+            verbose = true;
+        else if (arg == "--dir" && i + 1 < argc)
+            dir = argv[++i];
+        else if (arg == "--case" && i + 1 < argc)
+            only.push_back(argv[++i]);
+        else {
+            std::printf(
+                "usage: madzine-golden [--record] [--verbose] [--dir DIR] [--case NAME]...\n");
+            return (arg == "--help" || arg == "-h") ? 0 : 1;
+        }
+    }
+
+    // Same floating point environment as Rack's engine threads.
+    harness::setFlushDenormals(true);
+
+    int failures = 0;
+    int count = 0;
+    for (const GoldenCase& c : goldenCases()) {
+        if (!only.empty() && std::find(only.begin(), only.end(), c.name) == only.end())
+            continue;
+        count++;
+        std::string path = dir + "/" + c.name + ".golden";
+        std::vector<Trace> rendered = renderCase(c);
+
+        if (record) {
+            if (!writeGolden(path, rendered)) {
+                std::printf("FAIL %s: cannot write %s\n", c.name.c_str(), path.c_str());
+                failures++;
+                continue;
+            }
+            std::printf("recorded %s\n", path.c_str());
+            continue;
+        }
+
+        std::vector<Trace> reference;
+        if (!readGolden(path, reference)) {
+            std::printf("FAIL %s: missing or unreadable %s\n", c.name.c_str(), path.c_str());
+            failures++;
+            continue;
+        }
+        bool pass = compareCase(c, rendered, reference, verbose);
+        std::printf("%s %s\n", pass ? "  ok" : "FAIL", c.name.c_str());
+        if (!pass)
+            failures++;
+    }
+
+    if (count == 0) {
+        std::printf("no matching cases\n");
+        return 1;
+    }
+    if (!record)
+        std::printf("%d/%d golden cases passed\n", count - failures, count);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,278 @@
+// Tail-latency profiler: how long single process() calls take, not how long
+// they take on average.
+//
+// Every module is patched with its scripted scenario. Any input named
+// "Reset" also gets a slow clock, so reset paths run too. Each call to
+// process() is timed with the time-stamp counter. The run is repeated, and
+// each sample keeps its fastest time across repeats. Every repeat does the
+// same work, so that removes interrupts and preemption but keeps the
+// samples that are slow on their own.
+//
+// For each module this reports p50/p99/p99.9/max, and which events the
+// slowest 0.1% of samples coincide with:
+//
+//   in NAME    a clock, trigger or reset input rose on that sample
+//   out NAME   that output moved by 2V or more on that sample
+//
+// Each event is shown with its share of the slow samples next to its share
+// of all samples. An event much more common among the slow samples is the
+// expensive code path.
+//
+//   madzine-latency [--seconds S] [--rate HZ] [--repeat N] [--reset HZ] [--histogram] [--module SLUG]...
+
+#include "harness.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <x86intrin.h>
+
+struct LatencyOptions {
+    float seconds = 5.f;
+    float sampleRate = 48000.f;
+    int repeats = 3;
+    float resetRate = 0.5f;
+    bool histogram = false;
+    std::vector<std::string> slugs;
+};
+
+// Events are bits: inputs in the low half, outputs in the high half.
+static const int MAX_EVENT_PORTS = 32;
+
+struct Profile {
+    std::vector<uint64_t> ticks;
+    std::vector<uint64_t> events;
+    std::vector<std::string> eventNames;
+    // Time-stamp counter ticks per nanosecond.
+    double ticksPerNs = 1.0;
+};
+
+static uint64_t timerOverhead() {
+    uint64_t best = UINT64_MAX;
+    for (int i = 0; i < 1000; i++) {
+        uint64_t start = __rdtsc();
+        uint64_t end = __rdtsc();
+        best = std::min(best, end - start);
+    }
+    return best;
+}
+
+static harness::Scenario withReset(harness::Scenario scenario, float resetRate) {
+    if (resetRate <= 0.f)
+        return scenario;
+    Model* model = harness::loadPlugin()->getModel(scenario.slug);
+    Module* module = model->createModule();
+    for (PortInfo* info : module->inputInfos) {
+        if (!info || info->name.find("Reset") == std::string::npos)
+            continue;
+        bool patched = false;
+        for (const harness::Cable& cable : scenario.cables)
+            patched = patched || cable.input == info->name;
+        if (!patched)
+            scenario.cables.push_back({info->name, harness::clockSignal(resetRate)});
+    }
+    delete module;
+    return scenario;
+}
+
+static Profile profileModule(const harness::Scenario& scenario, const LatencyOptions& options) {
+    const int64_t blocks = std::max<int64_t>(1, (int64_t) (options.seconds * options.sampleRate) / harness::Rig::BLOCK_SIZE);
+    const size_t samples = (size_t) blocks * harness::Rig::BLOCK_SIZE;
+    const uint64_t overhead = timerOverhead();
+
+    Profile profile;
+    profile.ticks.assign(samples, UINT64_MAX);
+    profile.events.assign(samples, 0);
+
+    uint64_t totalTicks = 0;
+    std::chrono::steady_clock::duration totalTime(0);
+    for (int r = 0; r < options.repeats; r++) {
+        harness::Rig rig(scenario, options.sampleRate);
+        Module* module = rig.module;
+        const int outputs = std::min((int) module->outputs.size(), MAX_EVENT_PORTS);
+
+        if (r == 0) {
+            profile.eventNames.assign(2 * MAX_EVENT_PORTS, "");
+            for (int i = 0; i < std::min((int) module->inputInfos.size(), MAX_EVENT_PORTS); i++)
+                profile.eventNames[i] = "in " + module->inputInfos[i]->name;
+            for (int i = 0; i < outputs; i++)
+                profile.eventNames[MAX_EVENT_PORTS + i] = "out " + module->outputInfos[i]->name;
+        }
+
+        std::vector<float> lastOutputs(outputs, 0.f);
+        std::vector<float> lastDrives(rig.drives.size(), 0.f);
+        auto start = std::chrono::steady_clock::now();
+        uint64_t startTicks = __rdtsc();
+        size_t n = 0;
+        for (int64_t b = 0; b < blocks; b++) {
+            rig.fillBlock();
+            for (int i = 0; i < harness::Rig::BLOCK_SIZE; i++, n++) {
+                uint64_t events = 0;
+                for (size_t d = 0; d < rig.drives.size(); d++) {
+                    harness::Rig::Drive& drive = rig.drives[d];
+                    float v = rig.block[d * harness::Rig::BLOCK_SIZE + i];
+                    drive.input->setVoltage(v, drive.channel);
+                    int port = (int) (drive.input - &module->inputs[0]);
+                    if (drive.signal.kind == harness::CLOCK && v >= 1.f && lastDrives[d] < 1.f && port < MAX_EVENT_PORTS)
+                        events |= uint64_t(1) << port;
+                    lastDrives[d] = v;
+                }
+
+                uint64_t t0 = __rdtsc();
+                module->process(rig.args);
+                uint64_t t1 = __rdtsc();
+                rig.args.frame++;
+
+                for (int o = 0; o < outputs; o++) {
+                    float v = module->outputs[o].getVoltage();
+                    if (std::fabs(v - lastOutputs[o]) >= 2.f)
+                        events |= uint64_t(1) << (MAX_EVENT_PORTS + o);
+                    lastOutputs[o] = v;
+                }
+
+                uint64_t ticks = (t1 - t0 > overhead) ? t1 - t0 - overhead : 0;
+                profile.ticks[n] = std::min(profile.ticks[n], ticks);
+                profile.events[n] = events;
+            }
+        }
+        totalTicks += __rdtsc() - startTicks;
+        totalTime += std::chrono::steady_clock::now() - start;
+    }
+    profile.ticksPerNs = totalTicks / std::chrono::duration<double, std::nano>(totalTime).count();
+    return profile;
+}
+
+static uint64_t percentile(const std::vector<uint64_t>& sorted, double p) {
+    size_t i = std::min(sorted.size() - 1, (size_t) (p * (sorted.size() - 1) + 0.5));
+    return sorted[i];
+}
+
+static void printHistogram(const std::vector<uint64_t>& sorted) {
+    // Power-of-two buckets of ticks.
+    std::vector<size_t> counts(65, 0);
+    for (uint64_t t : sorted) {
+        int bucket = 0;
+        while (bucket < 64 && (uint64_t(1) << bucket) <= t)
+            bucket++;
+        counts[bucket]++;
+    }
+    size_t most = *std::max_element(counts.begin(), counts.end());
+    for (int k = 0; k < 65; k++) {
+        if (!counts[k])
+            continue;
+        uint64_t lo = k ? uint64_t(1) << (k - 1) : 0;
+        int bar = (int) (40.0 * counts[k] / most + 0.999);
+        std::printf("    %10llu+ ticks %9zu %s\n", (unsigned long long) lo, counts[k], std::string(bar, '#').c_str());
+    }
+}
+
+static void report(const harness::Scenario& scenario, const Profile& profile, const LatencyOptions& options) {
+    std::vector<uint64_t> sorted = profile.ticks;
+    std::sort(sorted.begin(), sorted.end());
+    const double budgetNs = 1e9 / options.sampleRate;
+    auto ns = [&](uint64_t ticks) { return ticks / profile.ticksPerNs; };
+
+    size_t worst = std::max_element(profile.ticks.begin(), profile.ticks.end()) - profile.ticks.begin();
+    std::printf("%s @ %.0f Hz, %zu samples, %.0f ns per sample period\n", scenario.slug.c_str(), options.sampleRate, sorted.size(), budgetNs);
+    std::printf("  %-6s %10s %10s %8s\n", "", "ticks", "ns", "period%");
+    const double ps[] = {0.5, 0.99, 0.999, 1.0};
+    const char* names[] = {"p50", "p99", "p99.9", "max"};
+    for (int i = 0; i < 4; i++) {
+        uint64_t t = percentile(sorted, ps[i]);
+        std::printf("  %-6s %10llu %10.0f %8.2f\n", names[i], (unsigned long long) t, ns(t), 100.0 * ns(t) / budgetNs);
+    }
+    std::string worstEvents;
+    for (int e = 0; e < 2 * MAX_EVENT_PORTS; e++) {
+        if (profile.events[worst] & (uint64_t(1) << e))
+            worstEvents += (worstEvents.empty() ? "" : ", ") + profile.eventNames[e];
+    }
+    std::printf("  max at %.4f s (%s)\n", worst / options.sampleRate, worstEvents.empty() ? "no event" : worstEvents.c_str());
+
+    // The slowest 0.1%, at least one sample.
+    uint64_t threshold = percentile(sorted, 0.999);
+    size_t slow = 0;
+    std::vector<size_t> slowCounts(2 * MAX_EVENT_PORTS, 0), allCounts(2 * MAX_EVENT_PORTS, 0);
+    size_t slowQuiet = 0, allQuiet = 0;
+    for (size_t n = 0; n < profile.ticks.size(); n++) {
+        bool isSlow = profile.ticks[n] >= threshold;
+        slow += isSlow;
+        uint64_t events = profile.events[n];
+        if (!events) {
+            allQuiet++;
+            slowQuiet += isSlow;
+        }
+        for (int e = 0; e < 2 * MAX_EVENT_PORTS; e++) {
+            if (events & (uint64_t(1) << e)) {
+                allCounts[e]++;
+                slowCounts[e] += isSlow;
+            }
+        }
+    }
+    std::printf("  slowest %zu samples (>= %llu ticks) coincide with:\n", slow, (unsigned long long) threshold);
+    std::printf("    %-36s %8s %8s\n", "event", "slow%", "all%");
+    for (int e = 0; e < 2 * MAX_EVENT_PORTS; e++) {
+        if (slowCounts[e])
+            std::printf("    %-36s %8.1f %8.2f\n", profile.eventNames[e].c_str(), 100.0 * slowCounts[e] / slow, 100.0 * allCounts[e] / sorted.size());
+    }
+    if (slowQuiet)
+        std::printf("    %-36s %8.1f %8.2f\n", "(no event)", 100.0 * slowQuiet / slow, 100.0 * allQuiet / sorted.size());
+
+    if (options.histogram)
+        printHistogram(sorted);
+    std::fflush(stdout);
+}
+
+int main(int argc, char** argv) {
+    LatencyOptions options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = (i + 1 < argc);
+        if (arg == "--seconds" && hasValue) {
+            options.seconds = std::atof(argv[++i]);
+        }
+        else if (arg == "--rate" && hasValue) {
+            options.sampleRate = std::atof(argv[++i]);
+        }
+        else if (arg == "--repeat" && hasValue) {
+            options.repeats = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (arg == "--reset" && hasValue) {
+            options.resetRate = std::atof(argv[++i]);
+        }
+        else if (arg == "--histogram") {
+            options.histogram = true;
+        }
+        else if (arg == "--module" && hasValue) {
+            options.slugs.push_back(argv[++i]);
+        }
+        else {
+            std::printf(
+                "usage: madzine-latency [options]\n"
+                "  --seconds S       audio seconds rendered per run (default 5)\n"
+                "  --rate HZ         sample rate (default 48000)\n"
+                "  --repeat N        runs; each sample keeps its fastest (default 3)\n"
+                "  --reset HZ        clock on Reset inputs, 0 to leave them unpatched (default 0.5)\n"
+                "  --histogram       print a power-of-two histogram of ticks\n"
+                "  --module SLUG     only profile SLUG (repeatable)\n");
+            return (arg == "--help" || arg == "-h") ? 0 : 1;
+        }
+    }
+
+    if (options.slugs.empty()) {
+        for (const harness::Scenario& scenario : harness::defaultScenarios())
+            options.slugs.push_back(scenario.slug);
+    }
+
+    harness::setFlushDenormals(true);
+
+    for (const std::string& slug : options.slugs) {
+        const harness::Scenario* found = harness::findScenario(slug);
+        if (!found) {
+            std::fprintf(stderr, "madzine-latency: unknown module %s\n", slug.c_str());
+            return 1;
+        }
+        harness::Scenario scenario = withReset(*found, options.resetRate);
+        report(scenario, profileModule(scenario, options), options);
+    }
+    return 0;
+}
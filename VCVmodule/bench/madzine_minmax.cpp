@@ -0,0 +1,143 @@
+// Check of MinMaxPyramid (src/minmax.hpp) against a brute-force min/max.
+//
+// Three groups of four channels are pushed until the top level has wrapped
+// around. The samples are a hash of their index and channel, so the brute
+// force recomputes them instead of keeping 2^24 frames in memory. Then, at
+// every level k:
+//
+//   block    single aligned blocks of 2^k samples, anywhere in the level's
+//            ring, which reduce() reads from level k alone
+//   range    runs of up to 8 such blocks, which it assembles from level k
+//            and the levels above
+//   whole    the oldest range the level still covers, up to the newest
+//            sample
+//   lost     a range starting one block before the level's ring, which must
+//            be refused
+//
+// The first three must return true and match the brute force exactly, in
+// every lane of every group.
+//
+//   madzine-minmax [--queries N]
+
+#include <rack.hpp>
+#include "minmax.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+using namespace rack;
+
+static const int GROUPS = 3;
+
+static float sampleAt(int64_t n, int channel) {
+    uint64_t x = (uint64_t) n * 0x9e3779b97f4a7c15ULL + (uint64_t) channel * 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 31;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 29;
+    return (float) (x >> 40) / (1 << 24) * 20.f - 10.f;
+}
+
+static void push(MinMaxPyramid& pyramid) {
+    simd::float_4 x[GROUPS];
+    for (int g = 0; g < GROUPS; g++) {
+        x[g] = simd::float_4(sampleAt(pyramid.written, 4 * g), sampleAt(pyramid.written, 4 * g + 1),
+                             sampleAt(pyramid.written, 4 * g + 2), sampleAt(pyramid.written, 4 * g + 3));
+    }
+    pyramid.push(x);
+}
+
+static uint64_t rngState = 0x4d494e4d4158ULL;
+
+static int64_t randomBelow(int64_t n) {
+    rngState = rngState * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (int64_t) ((rngState >> 16) % (uint64_t) n);
+}
+
+// Whether reduce() over [begin, end) matches the brute force in every
+// channel. Prints the first mismatch.
+static bool check(const MinMaxPyramid& pyramid, const char* kind, int level, int64_t begin, int64_t end) {
+    for (int g = 0; g < GROUPS; g++) {
+        MinMaxPyramid::Block block;
+        if (!pyramid.reduce(g, begin, end, block)) {
+            std::printf("  level %2d %-6s [%lld, %lld) group %d: refused\n", level, kind, (long long) begin, (long long) end, g);
+            return false;
+        }
+        for (int lane = 0; lane < 4; lane++) {
+            float min = INFINITY, max = -INFINITY;
+            for (int64_t n = begin; n < end; n++) {
+                float v = sampleAt(n, 4 * g + lane);
+                min = std::min(min, v);
+                max = std::max(max, v);
+            }
+            if (block.min[lane] != min || block.max[lane] != max) {
+                std::printf("  level %2d %-6s [%lld, %lld) channel %d: %g..%g, brute force %g..%g\n", level, kind,
+                            (long long) begin, (long long) end, 4 * g + lane, block.min[lane], block.max[lane], min, max);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    int queries = 64;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--queries" && i + 1 < argc) {
+            queries = std::max(1, std::atoi(argv[++i]));
+        }
+        else {
+            std::printf(
+                "usage: madzine-minmax [options]\n"
+                "  --queries N       block and range queries per level (default 64)\n");
+            return (arg == "--help" || arg == "-h") ? 0 : 1;
+        }
+    }
+
+    const int LEVELS = MinMaxPyramid::LEVELS;
+    const int BINS = MinMaxPyramid::BINS;
+    MinMaxPyramid pyramid(GROUPS);
+    pyramid.setGroups(GROUPS);
+    // A little over the top level's reach, ending mid-block so every level
+    // has a partial block at the head.
+    const int64_t total = ((int64_t) BINS << (LEVELS - 1)) + 12345;
+    while (pyramid.written < total)
+        push(pyramid);
+
+    std::printf("%lld samples of %d channels\n", (long long) total, 4 * GROUPS);
+    std::printf("%5s %8s %8s %8s %8s\n", "level", "blocks", "ranges", "whole", "lost");
+    int failures = 0;
+    for (int k = 0; k < LEVELS; k++) {
+        const int64_t width = int64_t(1) << k;
+        // Whole blocks still in level k's ring.
+        const int64_t newest = pyramid.written / width;
+        const int64_t oldest = std::max<int64_t>(0, newest - BINS);
+
+        int blocks = 0;
+        for (int q = 0; q < queries; q++) {
+            int64_t index = oldest + randomBelow(newest - oldest);
+            blocks += check(pyramid, "block", k, index * width, (index + 1) * width);
+        }
+        int ranges = 0;
+        for (int q = 0; q < queries; q++) {
+            int64_t length = 1 + randomBelow(8);
+            int64_t index = oldest + randomBelow(newest - oldest - length + 1);
+            ranges += check(pyramid, "range", k, index * width, (index + length) * width);
+        }
+        bool whole = check(pyramid, "whole", k, oldest * width, pyramid.written);
+
+        bool lost = true;
+        if (oldest > 0) {
+            MinMaxPyramid::Block block;
+            lost = !pyramid.reduce(0, (oldest - 1) * width, oldest * width, block);
+            if (!lost)
+                std::printf("  level %2d lost block %lld: not refused\n", k, (long long) (oldest - 1));
+        }
+
+        std::printf("%5d %4d/%-3d %4d/%-3d %8s %8s\n", k, blocks, queries, ranges, queries, whole ? "ok" : "FAIL", lost ? "ok" : "FAIL");
+        failures += (queries - blocks) + (queries - ranges) + !whole + !lost;
+    }
+    std::printf("%s\n", failures ? "FAIL" : "pyramid matches brute force at every level");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,177 @@
+// Check of the performance export (src/perf.hpp) against the meters it
+// reads.
+//
+// Every module is patched with its scripted scenario and registered with
+// the engine, as if they were all in one patch. The readout is turned on
+// for all of them but the last metered one, and one second is rendered,
+// so each meter publishes twice. Then exportPerfJson() writes its file
+// into a scratch user folder, and the file is read back. It must list
+// every metered module once, with its id and slug. Timing figures appear
+// only where timing is on, and every stat carries its name and published
+// value. Pinpple's voice count and oversampling factor are checked against
+// the patch.
+//
+//   madzine-perf [--rate HZ]
+
+#include "harness.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <unistd.h>
+
+static int failures = 0;
+
+static void fail(const std::string& slug, const std::string& what) {
+    std::printf("  FAIL %s: %s\n", slug.c_str(), what.c_str());
+    failures++;
+}
+
+// Checks one entry of "modules" against the module it names. Returns the
+// module, or NULL if the entry names none.
+static MeteredModule* checkEntry(json_t* moduleJ, float sampleRate) {
+    json_t* idJ = json_object_get(moduleJ, "id");
+    MeteredModule* module = idJ ? dynamic_cast<MeteredModule*>(APP->engine->getModule(json_integer_value(idJ))) : NULL;
+    const char* slug = json_string_value(json_object_get(moduleJ, "slug"));
+    if (!module) {
+        fail(slug ? slug : "?", "entry names no metered module");
+        return NULL;
+    }
+    const std::string& expected = module->model->slug;
+    if (!slug || expected != slug)
+        fail(expected, string::f("slug \"%s\"", slug ? slug : ""));
+
+    const PerfMeter& perf = module->perf;
+    bool timing = perf.timing.load();
+    if (json_is_true(json_object_get(moduleJ, "timing")) != timing)
+        fail(expected, "timing flag");
+    json_t* avgJ = json_object_get(moduleJ, "avgNs");
+    json_t* peakJ = json_object_get(moduleJ, "peakNs");
+    json_t* percentJ = json_object_get(moduleJ, "samplePeriodPercent");
+    if (timing) {
+        double avgNs = json_number_value(avgJ);
+        double percent = avgNs * sampleRate * 1e-7;
+        if (!avgJ || !(avgNs > 0.0))
+            fail(expected, "no average time");
+        if (!peakJ || json_number_value(peakJ) < avgNs)
+            fail(expected, "peak below average");
+        if (!percentJ || std::fabs(json_number_value(percentJ) - percent) > 1e-4 * percent)
+            fail(expected, "share of the sample period");
+    }
+    else if (avgJ || peakJ || percentJ) {
+        fail(expected, "timing figures with timing off");
+    }
+
+    json_t* statsJ = json_object_get(moduleJ, "stats");
+    if (!statsJ || (int) json_object_size(statsJ) != perf.getStatCount()) {
+        fail(expected, "stat count");
+        return module;
+    }
+    for (int i = 0; i < perf.getStatCount(); i++) {
+        json_t* statJ = json_object_get(statsJ, perf.getStatName(i));
+        if (!statJ || json_number_value(statJ) != perf.getStat(i))
+            fail(expected, string::f("stat \"%s\"", perf.getStatName(i)));
+    }
+    return module;
+}
+
+int main(int argc, char** argv) {
+    float sampleRate = 48000.f;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--rate" && i + 1 < argc) {
+            sampleRate = std::atof(argv[++i]);
+        }
+        else {
+            std::printf(
+                "usage: madzine-perf [options]\n"
+                "  --rate HZ         sample rate (default 48000)\n");
+            return (arg == "--help" || arg == "-h") ? 0 : 1;
+        }
+    }
+
+    harness::setFlushDenormals(true);
+
+    std::vector<std::unique_ptr<harness::Rig>> rigs;
+    std::vector<MeteredModule*> metered;
+    for (const harness::Scenario& scenario : harness::defaultScenarios()) {
+        rigs.emplace_back(new harness::Rig(scenario, sampleRate));
+        MeteredModule* module = dynamic_cast<MeteredModule*>(rigs.back()->module);
+        if (module) {
+            module->perf.timing = true;
+            metered.push_back(module);
+        }
+    }
+    if (metered.empty()) {
+        std::printf("no metered modules\n");
+        return 1;
+    }
+    metered.back()->perf.timing = false;
+
+    const int blocks = (int) (sampleRate / harness::Rig::BLOCK_SIZE) + 1;
+    for (int b = 0; b < blocks; b++) {
+        for (auto& rig : rigs) {
+            rig->fillBlock();
+            for (int i = 0; i < harness::Rig::BLOCK_SIZE; i++)
+                rig->step(i);
+        }
+    }
+
+    char dir[] = "/tmp/madzine-perf-XXXXXX";
+    if (!mkdtemp(dir)) {
+        std::printf("can't create a scratch user folder\n");
+        return 1;
+    }
+    asset::userDir = dir;
+    std::string path = exportPerfJson();
+    if (path.empty()) {
+        std::printf("exportPerfJson() wrote nothing\n");
+        return 1;
+    }
+
+    json_error_t error;
+    json_t* rootJ = json_load_file(path.c_str(), 0, &error);
+    std::remove(path.c_str());
+    rmdir((std::string(dir) + "/MADZINE").c_str());
+    rmdir(dir);
+    if (!rootJ) {
+        std::printf("%s: %s\n", path.c_str(), error.text);
+        return 1;
+    }
+
+    if (json_number_value(json_object_get(rootJ, "sampleRate")) != sampleRate)
+        fail("export", "sample rate");
+    json_t* modulesJ = json_object_get(rootJ, "modules");
+    std::vector<MeteredModule*> listed;
+    for (size_t i = 0; i < json_array_size(modulesJ); i++) {
+        MeteredModule* module = checkEntry(json_array_get(modulesJ, i), sampleRate);
+        if (!module)
+            continue;
+        if (std::find(listed.begin(), listed.end(), module) != listed.end())
+            fail(module->model->slug, "listed twice");
+        listed.push_back(module);
+
+        if (module->model->slug == "Pinpple") {
+            const PerfMeter& perf = module->perf;
+            for (int s = 0; s < perf.getStatCount(); s++) {
+                std::string name = perf.getStatName(s);
+                // One voice; the AA filters need at least 132 kHz, which
+                // is 3x at 44.1 and 48 kHz.
+                float expected = (name == "voices") ? 1.f : (name == "oversampling") ? std::ceil(132000.f / sampleRate) : -1.f;
+                if (expected >= 0.f && perf.getStat(s) != expected)
+                    fail("Pinpple", string::f("%s %g, expected %g", name.c_str(), perf.getStat(s), expected));
+            }
+        }
+    }
+    for (MeteredModule* module : metered) {
+        if (std::find(listed.begin(), listed.end(), module) == listed.end())
+            fail(module->model->slug, "missing from the export");
+        else
+            std::printf("  ok %s%s\n", module->model->slug.c_str(), module->perf.timing.load() ? "" : " (timing off)");
+    }
+    json_decref(rootJ);
+
+    std::printf("%d metered modules exported, %d failures\n", (int) metered.size(), failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,252 @@
+// Multi-instance stress test and scaling benchmark.
+//
+// Rack's engine runs a patch on several worker threads, so instances of the
+// same module process concurrently. For each module, this tool first
+// renders a number of instances one after another as the reference. It then
+// renders a fresh set spread over 1, 2, 4 ... N threads that run at the same
+// time. Every instance's output must match its reference bit for bit. A
+// static or global written from process() shows up as a mismatch, because
+// the instances then see each other's writes.
+//
+// Each concurrent run is timed from thread start to join, which includes
+// generating the scripted inputs. It is reported as throughput (instance
+// samples per second) and speedup over one thread. Flat scaling points at
+// shared cache lines or at instances too big for the caches. Each module's
+// footprint is sizeof plus whatever its constructor leaves allocated on the
+// heap.
+//
+// Noise comes from Rack's per-thread generator. Each instance keeps its own
+// copy of it, which is swapped in while that instance runs. That way its
+// random stream does not depend on which thread runs it or on what ran
+// before it.
+//
+//   madzine-stress [--threads N] [--instances N] [--seconds S] [--module SLUG]...
+
+#include "harness.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <thread>
+
+// Live heap bytes, counted by the replaced operator new/delete below. Each
+// block carries its size in a header that keeps the 16-byte alignment.
+static std::atomic<int64_t> heapBytes(0);
+static const size_t HEAP_HEADER = 16;
+
+void* operator new(size_t size) {
+    char* p = (char*) std::malloc(size + HEAP_HEADER);
+    if (!p)
+        throw std::bad_alloc();
+    std::memcpy(p, &size, sizeof(size));
+    heapBytes.fetch_add(size, std::memory_order_relaxed);
+    return p + HEAP_HEADER;
+}
+
+void operator delete(void* ptr) noexcept {
+    if (!ptr)
+        return;
+    char* p = (char*) ptr - HEAP_HEADER;
+    size_t size;
+    std::memcpy(&size, p, sizeof(size));
+    heapBytes.fetch_sub(size, std::memory_order_relaxed);
+    std::free(p);
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete[](void* ptr) noexcept {
+    operator delete(ptr);
+}
+
+struct StressOptions {
+    int threads = std::max(4, (int) std::thread::hardware_concurrency());
+    int instances = 32;
+    float seconds = 1.f;
+    float sampleRate = 48000.f;
+    std::vector<std::string> slugs;
+};
+
+// One instance and its digest: a hash of every output voltage, per block.
+struct Instance {
+    std::unique_ptr<harness::Rig> rig;
+    random::Xoroshiro128Plus rng;
+    std::vector<uint64_t> digests;
+
+    Instance(const harness::Scenario& scenario, float sampleRate, uint64_t seed) {
+        rig.reset(new harness::Rig(scenario, sampleRate, seed));
+        rng = random::local();
+    }
+
+    void renderBlock() {
+        std::swap(rng, random::local());
+        rig->fillBlock();
+        uint64_t hash = 0xcbf29ce484222325ULL;
+        for (int i = 0; i < harness::Rig::BLOCK_SIZE; i++) {
+            rig->step(i);
+            for (Output& output : rig->module->outputs) {
+                for (int c = 0; c < output.getChannels(); c++) {
+                    float v = output.getVoltage(c);
+                    uint32_t bits;
+                    std::memcpy(&bits, &v, sizeof(bits));
+                    hash = (hash ^ bits) * 0x100000001b3ULL;
+                }
+            }
+        }
+        digests.push_back(hash);
+        std::swap(rng, random::local());
+    }
+};
+
+typedef std::vector<std::unique_ptr<Instance>> Instances;
+
+static Instances createInstances(const harness::Scenario& scenario, const StressOptions& options) {
+    Instances instances;
+    for (int i = 0; i < options.instances; i++)
+        instances.emplace_back(new Instance(scenario, options.sampleRate, harness::Rig::DEFAULT_SEED + i));
+    return instances;
+}
+
+// Instance i runs on thread i % threads. The instances of a thread take
+// turns a block at a time, like modules sharing an engine worker. Returns
+// the wall time in seconds.
+static double renderConcurrently(Instances& instances, int threadCount, int64_t blocks) {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadCount; t++) {
+        threads.emplace_back([&, t]() {
+            harness::setFlushDenormals(true);
+            for (int64_t b = 0; b < blocks; b++) {
+                for (size_t i = t; i < instances.size(); i += threadCount)
+                    instances[i]->renderBlock();
+            }
+        });
+    }
+    for (std::thread& thread : threads)
+        thread.join();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Returns the number of instances whose concurrent render differed from the
+// reference, printing the first few.
+static int countMismatches(const std::vector<std::vector<uint64_t>>& reference, const Instances& concurrent, float sampleRate) {
+    int mismatches = 0;
+    for (size_t i = 0; i < reference.size(); i++) {
+        const std::vector<uint64_t>& a = reference[i];
+        const std::vector<uint64_t>& b = concurrent[i]->digests;
+        size_t diverged = std::mismatch(a.begin(), a.end(), b.begin()).first - a.begin();
+        if (diverged < a.size()) {
+            if (mismatches < 4)
+                std::printf("    instance %d diverged at %.4f s\n", (int) i, diverged * harness::Rig::BLOCK_SIZE / sampleRate);
+            mismatches++;
+        }
+    }
+    return mismatches;
+}
+
+static void printFootprint(const harness::Scenario& scenario) {
+    Model* model = harness::loadPlugin()->getModel(scenario.slug);
+    int64_t before = heapBytes.load();
+    Module* module = model->createModule();
+    int64_t total = heapBytes.load() - before;
+    delete module;
+    int64_t heap = total - (int64_t) model->moduleSize;
+    std::printf("%s: sizeof %lld B, heap %lld B, %.1f KB per instance\n", scenario.slug.c_str(),
+                (long long) model->moduleSize, (long long) heap, total / 1024.0);
+}
+
+// Returns whether every thread count reproduced the reference.
+static bool stressModule(const harness::Scenario& scenario, const StressOptions& options) {
+    const int64_t blocks = std::max<int64_t>(1, (int64_t) (options.seconds * options.sampleRate) / harness::Rig::BLOCK_SIZE);
+    const double samples = (double) blocks * harness::Rig::BLOCK_SIZE * options.instances;
+
+    printFootprint(scenario);
+
+    // Reference instances are rendered and freed one at a time, so only
+    // one set is ever alive.
+    std::vector<std::vector<uint64_t>> reference;
+    for (int i = 0; i < options.instances; i++) {
+        Instance instance(scenario, options.sampleRate, harness::Rig::DEFAULT_SEED + i);
+        for (int64_t b = 0; b < blocks; b++)
+            instance.renderBlock();
+        reference.push_back(instance.digests);
+    }
+
+    std::printf("  %7s %9s %14s %12s %8s %s\n", "threads", "instances", "Msamples/s", "ns/sample", "speedup", "output");
+    bool pass = true;
+    double baseline = 0.0;
+    for (int threads = 1;; threads = std::min(threads * 2, options.threads)) {
+        int mismatches;
+        double seconds;
+        {
+            Instances concurrent = createInstances(scenario, options);
+            seconds = renderConcurrently(concurrent, threads, blocks);
+            mismatches = countMismatches(reference, concurrent, options.sampleRate);
+        }
+        double throughput = samples / seconds;
+        if (threads == 1)
+            baseline = throughput;
+        std::printf("  %7d %9d %14.2f %12.1f %8.2f %s\n", threads, options.instances, throughput * 1e-6,
+                    1e9 / throughput, throughput / baseline, mismatches ? "DIVERGED" : "ok");
+        std::fflush(stdout);
+        pass = pass && !mismatches;
+        if (threads == options.threads)
+            break;
+    }
+    return pass;
+}
+
+int main(int argc, char** argv) {
+    StressOptions options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = (i + 1 < argc);
+        if (arg == "--threads" && hasValue) {
+            options.threads = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (arg == "--instances" && hasValue) {
+            options.instances = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (arg == "--seconds" && hasValue) {
+            options.seconds = std::atof(argv[++i]);
+        }
+        else if (arg == "--module" && hasValue) {
+            options.slugs.push_back(argv[++i]);
+        }
+        else {
+            std::printf(
+                "usage: madzine-stress [options]\n"
+                "  --threads N       most worker threads; runs 1, 2, 4 ... N (default max(4, cores))\n"
+                "  --instances N     instances of each module (default 32)\n"
+                "  --seconds S       audio seconds rendered per instance (default 1)\n"
+                "  --module SLUG     only test SLUG (repeatable)\n");
+            return (arg == "--help" || arg == "-h") ? 0 : 1;
+        }
+    }
+
+    if (options.slugs.empty()) {
+        for (const harness::Scenario& scenario : harness::defaultScenarios())
+            options.slugs.push_back(scenario.slug);
+    }
+
+    harness::setFlushDenormals(true);
+
+    int failures = 0;
+    for (const std::string& slug : options.slugs) {
+        const harness::Scenario* scenario = harness::findScenario(slug);
+        if (!scenario) {
+            std::fprintf(stderr, "madzine-stress: unknown module %s\n", slug.c_str());
+            return 1;
+        }
+        if (!stressModule(*scenario, options))
+            failures++;
+    }
+    std::printf("%d/%d modules independent across threads\n", (int) options.slugs.size() - failures, (int) options.slugs.size());
+    return failures ? 1 : 0;
+}
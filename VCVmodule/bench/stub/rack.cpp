@@ -0,0 +1,394 @@
+#include "rack.hpp"
+#include <cctype>
+#include <cerrno>
+#include <sys/stat.h>
+
+namespace rack {
+
+static engine::Engine stubEngine;
+static Window stubWindow;
+static app::RackWidget stubRackWidget;
+static app::Scene stubScene;
+
+Context* contextGet() {
+    static Context context;
+    if (!context.engine) {
+        stubScene.rack = &stubRackWidget;
+        context.engine = &stubEngine;
+        context.window = &stubWindow;
+        context.scene = &stubScene;
+    }
+    return &context;
+}
+
+namespace random {
+
+Xoroshiro128Plus& local() {
+    thread_local Xoroshiro128Plus rng;
+    thread_local bool seeded = false;
+    if (!seeded) {
+        rng.seed(0x6d61647a696e65ULL, 0x62656e6368ULL);
+        seeded = true;
+    }
+    return rng;
+}
+
+} // namespace random
+
+} // namespace rack
+
+// ---------------------------------------------------------------------------
+// jansson subset
+// ---------------------------------------------------------------------------
+
+static json_t* jsonNew(json_t::Type type) {
+    json_t* json = new json_t;
+    json->type = type;
+    return json;
+}
+
+json_t* json_object() { return jsonNew(json_t::OBJECT); }
+json_t* json_array() { return jsonNew(json_t::ARRAY); }
+json_t* json_true() { return jsonNew(json_t::TRUE_); }
+json_t* json_false() { return jsonNew(json_t::FALSE_); }
+json_t* json_null() { return jsonNew(json_t::NULL_); }
+json_t* json_boolean(bool value) { return value ? json_true() : json_false(); }
+
+json_t* json_integer(long long value) {
+    json_t* json = jsonNew(json_t::INTEGER);
+    json->integer = value;
+    return json;
+}
+
+json_t* json_real(double value) {
+    json_t* json = jsonNew(json_t::REAL);
+    json->real = value;
+    return json;
+}
+
+json_t* json_string(const char* value) {
+    json_t* json = jsonNew(json_t::STRING);
+    json->string = value ? value : "";
+    return json;
+}
+
+void json_decref(json_t* json) {
+    if (!json)
+        return;
+    for (json_t* item : json->items)
+        json_decref(item);
+    for (auto& member : json->members)
+        json_decref(member.second);
+    delete json;
+}
+
+json_t* json_object_get(const json_t* object, const char* key) {
+    if (!object || object->type != json_t::OBJECT)
+        return NULL;
+    for (const auto& member : object->members) {
+        if (member.first == key)
+            return member.second;
+    }
+    return NULL;
+}
+
+int json_object_set_new(json_t* object, const char* key, json_t* value) {
+    if (!object || object->type != json_t::OBJECT) {
+        json_decref(value);
+        return -1;
+    }
+    for (auto& member : object->members) {
+        if (member.first == key) {
+            json_decref(member.second);
+            member.second = value;
+            return 0;
+        }
+    }
+    object->members.push_back(std::make_pair(std::string(key), value));
+    return 0;
+}
+
+size_t json_object_size(const json_t* object) {
+    if (!object || object->type != json_t::OBJECT)
+        return 0;
+    return object->members.size();
+}
+
+json_t* json_array_get(const json_t* array, size_t index) {
+    if (!array || array->type != json_t::ARRAY || index >= array->items.size())
+        return NULL;
+    return array->items[index];
+}
+
+size_t json_array_size(const json_t* array) {
+    if (!array || array->type != json_t::ARRAY)
+        return 0;
+    return array->items.size();
+}
+
+int json_array_append_new(json_t* array, json_t* value) {
+    if (!array || array->type != json_t::ARRAY) {
+        json_decref(value);
+        return -1;
+    }
+    array->items.push_back(value);
+    return 0;
+}
+
+long long json_integer_value(const json_t* json) {
+    return (json && json->type == json_t::INTEGER) ? json->integer : 0;
+}
+
+double json_real_value(const json_t* json) {
+    return (json && json->type == json_t::REAL) ? json->real : 0.0;
+}
+
+double json_number_value(const json_t* json) {
+    if (!json)
+        return 0.0;
+    if (json->type == json_t::INTEGER)
+        return (double) json->integer;
+    if (json->type == json_t::REAL)
+        return json->real;
+    return 0.0;
+}
+
+bool json_boolean_value(const json_t* json) { return json && json->type == json_t::TRUE_; }
+bool json_is_true(const json_t* json) { return json && json->type == json_t::TRUE_; }
+
+const char* json_string_value(const json_t* json) {
+    return (json && json->type == json_t::STRING) ? json->string.c_str() : NULL;
+}
+
+static void jsonDump(const json_t* json, std::string& out) {
+    switch (json->type) {
+        case json_t::OBJECT: {
+            out += "{";
+            for (size_t i = 0; i < json->members.size(); i++) {
+                if (i > 0)
+                    out += ", ";
+                out += "\"" + json->members[i].first + "\": ";
+                jsonDump(json->members[i].second, out);
+            }
+            out += "}";
+        } break;
+        case json_t::ARRAY: {
+            out += "[";
+            for (size_t i = 0; i < json->items.size(); i++) {
+                if (i > 0)
+                    out += ", ";
+                jsonDump(json->items[i], out);
+            }
+            out += "]";
+        } break;
+        case json_t::STRING: out += "\"" + json->string + "\""; break;
+        case json_t::INTEGER: out += rack::string::f("%lld", json->integer); break;
+        case json_t::REAL: out += rack::string::f("%.17g", json->real); break;
+        case json_t::TRUE_: out += "true"; break;
+        case json_t::FALSE_: out += "false"; break;
+        case json_t::NULL_: out += "null"; break;
+    }
+}
+
+char* json_dumps(const json_t* json, size_t flags) {
+    if (!json)
+        return NULL;
+    std::string out;
+    jsonDump(json, out);
+    return strdup(out.c_str());
+}
+
+// Recursive descent over the JSON that jsonDump() and Rack write: no
+// comments, and \u escapes only below 0x80.
+struct JsonParser {
+    const char* p;
+
+    void skipSpace() {
+        while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')
+            p++;
+    }
+
+    bool literal(const char* word) {
+        size_t n = std::strlen(word);
+        if (std::strncmp(p, word, n) != 0)
+            return false;
+        p += n;
+        return true;
+    }
+
+    bool parseString(std::string& out) {
+        if (*p != '"')
+            return false;
+        p++;
+        while (*p != '"') {
+            if (!*p)
+                return false;
+            if (*p != '\\') {
+                out += *p++;
+                continue;
+            }
+            p++;
+            switch (*p++) {
+                case '"': out += '"'; break;
+                case '\\': out += '\\'; break;
+                case '/': out += '/'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'n': out += '\n'; break;
+                case 'r': out += '\r'; break;
+                case 't': out += '\t'; break;
+                case 'u': {
+                    char hex[5] = {};
+                    for (int i = 0; i < 4; i++) {
+                        if (!std::isxdigit((unsigned char) *p))
+                            return false;
+                        hex[i] = *p++;
+                    }
+                    long code = std::strtol(hex, NULL, 16);
+                    if (code >= 0x80)
+                        return false;
+                    out += (char) code;
+                } break;
+                default: return false;
+            }
+        }
+        p++;
+        return true;
+    }
+
+    json_t* parseValue() {
+        skipSpace();
+        if (*p == '{') {
+            p++;
+            json_t* object = json_object();
+            skipSpace();
+            if (*p == '}') {
+                p++;
+                return object;
+            }
+            while (true) {
+                skipSpace();
+                std::string key;
+                if (!parseString(key))
+                    break;
+                skipSpace();
+                if (*p++ != ':')
+                    break;
+                json_t* value = parseValue();
+                if (!value)
+                    break;
+                json_object_set_new(object, key.c_str(), value);
+                skipSpace();
+                if (*p == ',') {
+                    p++;
+                    continue;
+                }
+                if (*p++ == '}')
+                    return object;
+                break;
+            }
+            json_decref(object);
+            return NULL;
+        }
+        if (*p == '[') {
+            p++;
+            json_t* array = json_array();
+            skipSpace();
+            if (*p == ']') {
+                p++;
+                return array;
+            }
+            while (true) {
+                json_t* value = parseValue();
+                if (!value)
+                    break;
+                json_array_append_new(array, value);
+                skipSpace();
+                if (*p == ',') {
+                    p++;
+                    continue;
+                }
+                if (*p++ == ']')
+                    return array;
+                break;
+            }
+            json_decref(array);
+            return NULL;
+        }
+        if (*p == '"') {
+            std::string value;
+            return parseString(value) ? json_string(value.c_str()) : NULL;
+        }
+        if (literal("true"))
+            return json_true();
+        if (literal("false"))
+            return json_false();
+        if (literal("null"))
+            return json_null();
+        const char* start = p;
+        char* end;
+        double real = std::strtod(start, &end);
+        if (end == start)
+            return NULL;
+        p = end;
+        if (std::find_if(start, (const char*) end, [](char c) { return c == '.' || c == 'e' || c == 'E'; }) != end)
+            return json_real(real);
+        return json_integer(std::strtoll(start, NULL, 10));
+    }
+};
+
+json_t* json_loads(const char* input, size_t flags, json_error_t* error) {
+    JsonParser parser;
+    parser.p = input;
+    json_t* json = parser.parseValue();
+    if (json) {
+        parser.skipSpace();
+        if (*parser.p) {
+            json_decref(json);
+            json = NULL;
+        }
+    }
+    if (!json && error)
+        std::snprintf(error->text, sizeof(error->text), "parse error at offset %d", (int) (parser.p - input));
+    return json;
+}
+
+json_t* json_load_file(const char* path, size_t flags, json_error_t* error) {
+    FILE* file = std::fopen(path, "r");
+    if (!file) {
+        if (error)
+            std::snprintf(error->text, sizeof(error->text), "can't open %s", path);
+        return NULL;
+    }
+    std::string text;
+    char buffer[4096];
+    size_t n;
+    while ((n = std::fread(buffer, 1, sizeof(buffer), file)) > 0)
+        text.append(buffer, n);
+    std::fclose(file);
+    return json_loads(text.c_str(), flags, error);
+}
+
+namespace rack {
+
+namespace asset {
+
+std::string userDir;
+
+} // namespace asset
+
+namespace system {
+
+bool createDirectories(const std::string& path) {
+    for (size_t slash = path.find('/', 1);; slash = path.find('/', slash + 1)) {
+        std::string dir = path.substr(0, slash);
+        if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST)
+            return false;
+        if (slash == std::string::npos)
+            return true;
+    }
+}
+
+} // namespace system
+
+} // namespace rack
@@ -0,0 +1,1580 @@
+#pragma once
+// Minimal headless stand-in for the Rack SDK, just enough to compile the
+// MADZINE sources and drive Module::process() without a window, GL context or
+// audio device. Engine-side pieces (Module, ports, dsp, simd, random, json)
+// behave like Rack 2; everything on the UI side is an inert no-op.
+
+#include <cmath>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <pmmintrin.h>
+#include <smmintrin.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define RACK_GRID_WIDTH 15
+#define RACK_GRID_HEIGHT 380
+#define RACK_MOD_CTRL 0x0002
+#define RACK_MOD_SHIFT 0x0001
+#define RACK_MOD_ALT 0x0004
+#define RACK_MOD_MASK (RACK_MOD_CTRL | RACK_MOD_SHIFT | RACK_MOD_ALT)
+#define CHECKMARK_STRING "✔"
+#define RECT_ARGS(r) (r).pos.x, (r).pos.y, (r).size.x, (r).size.y
+
+// ---------------------------------------------------------------------------
+// jansson subset
+// ---------------------------------------------------------------------------
+
+struct json_t {
+    enum Type { OBJECT, ARRAY, STRING, INTEGER, REAL, TRUE_, FALSE_, NULL_ };
+    Type type = NULL_;
+    long long integer = 0;
+    double real = 0.0;
+    std::string string;
+    std::vector<json_t*> items;
+    std::vector<std::pair<std::string, json_t*>> members;
+};
+
+json_t* json_object();
+json_t* json_array();
+json_t* json_integer(long long value);
+json_t* json_real(double value);
+json_t* json_boolean(bool value);
+json_t* json_string(const char* value);
+json_t* json_true();
+json_t* json_false();
+json_t* json_null();
+void json_decref(json_t* json);
+json_t* json_object_get(const json_t* object, const char* key);
+int json_object_set_new(json_t* object, const char* key, json_t* value);
+size_t json_object_size(const json_t* object);
+json_t* json_array_get(const json_t* array, size_t index);
+size_t json_array_size(const json_t* array);
+int json_array_append_new(json_t* array, json_t* value);
+long long json_integer_value(const json_t* json);
+double json_real_value(const json_t* json);
+double json_number_value(const json_t* json);
+bool json_boolean_value(const json_t* json);
+bool json_is_true(const json_t* json);
+const char* json_string_value(const json_t* json);
+char* json_dumps(const json_t* json, size_t flags);
+
+struct json_error_t {
+    char text[160];
+};
+
+json_t* json_loads(const char* input, size_t flags, json_error_t* error);
+json_t* json_load_file(const char* path, size_t flags, json_error_t* error);
+
+#define JSON_INDENT(n) (n)
+
+// ---------------------------------------------------------------------------
+// NanoVG / GLFW no-ops
+// ---------------------------------------------------------------------------
+
+struct NVGcontext;
+struct NVGLUframebuffer;
+struct GLFWwindow;
+struct GLFWcursor;
+
+struct NVGcolor {
+    float r = 0.f, g = 0.f, b = 0.f, a = 0.f;
+};
+
+inline NVGcolor nvgRGBA(unsigned char r, unsigned char g, unsigned char b, unsigned char a) {
+    NVGcolor c;
+    c.r = r / 255.f;
+    c.g = g / 255.f;
+    c.b = b / 255.f;
+    c.a = a / 255.f;
+    return c;
+}
+inline NVGcolor nvgRGB(unsigned char r, unsigned char g, unsigned char b) { return nvgRGBA(r, g, b, 255); }
+inline NVGcolor nvgRGBAf(float r, float g, float b, float a) {
+    NVGcolor c;
+    c.r = r;
+    c.g = g;
+    c.b = b;
+    c.a = a;
+    return c;
+}
+inline NVGcolor nvgRGBf(float r, float g, float b) { return nvgRGBAf(r, g, b, 1.f); }
+inline NVGcolor nvgTransRGBA(NVGcolor c, unsigned char a) { c.a = a / 255.f; return c; }
+
+enum NVGalign {
+    NVG_ALIGN_LEFT = 1 << 0,
+    NVG_ALIGN_CENTER = 1 << 1,
+    NVG_ALIGN_RIGHT = 1 << 2,
+    NVG_ALIGN_TOP = 1 << 3,
+    NVG_ALIGN_MIDDLE = 1 << 4,
+    NVG_ALIGN_BOTTOM = 1 << 5,
+    NVG_ALIGN_BASELINE = 1 << 6,
+};
+enum NVGlineCap { NVG_BUTT, NVG_ROUND, NVG_SQUARE, NVG_BEVEL, NVG_MITER };
+enum NVGwinding { NVG_CCW = 1, NVG_CW = 2 };
+enum NVGsolidity { NVG_SOLID = 1, NVG_HOLE = 2 };
+
+inline void nvgSave(NVGcontext*) {}
+inline void nvgRestore(NVGcontext*) {}
+inline void nvgBeginPath(NVGcontext*) {}
+inline void nvgClosePath(NVGcontext*) {}
+inline void nvgMoveTo(NVGcontext*, float, float) {}
+inline void nvgLineTo(NVGcontext*, float, float) {}
+inline void nvgBezierTo(NVGcontext*, float, float, float, float, float, float) {}
+inline void nvgQuadTo(NVGcontext*, float, float, float, float) {}
+inline void nvgArc(NVGcontext*, float, float, float, float, float, int) {}
+inline void nvgRect(NVGcontext*, float, float, float, float) {}
+inline void nvgRoundedRect(NVGcontext*, float, float, float, float, float) {}
+inline void nvgCircle(NVGcontext*, float, float, float) {}
+inline void nvgEllipse(NVGcontext*, float, float, float, float) {}
+inline void nvgPathWinding(NVGcontext*, int) {}
+inline void nvgFill(NVGcontext*) {}
+inline void nvgStroke(NVGcontext*) {}
+inline void nvgFillColor(NVGcontext*, NVGcolor) {}
+inline void nvgStrokeColor(NVGcontext*, NVGcolor) {}
+inline void nvgStrokeWidth(NVGcontext*, float) {}
+inline void nvgLineCap(NVGcontext*, int) {}
+inline void nvgLineJoin(NVGcontext*, int) {}
+inline void nvgGlobalAlpha(NVGcontext*, float) {}
+inline void nvgTranslate(NVGcontext*, float, float) {}
+inline void nvgRotate(NVGcontext*, float) {}
+inline void nvgScale(NVGcontext*, float, float) {}
+inline void nvgScissor(NVGcontext*, float, float, float, float) {}
+inline void nvgIntersectScissor(NVGcontext*, float, float, float, float) {}
+inline void nvgResetScissor(NVGcontext*) {}
+inline void nvgFontSize(NVGcontext*, float) {}
+inline void nvgFontFaceId(NVGcontext*, int) {}
+inline void nvgTextAlign(NVGcontext*, int) {}
+inline void nvgTextLetterSpacing(NVGcontext*, float) {}
+inline float nvgText(NVGcontext*, float x, float, const char*, const char*) { return x; }
+inline float nvgTextBounds(NVGcontext*, float, float, const char*, const char*, float*) { return 0.f; }
+
+#define GLFW_RELEASE 0
+#define GLFW_PRESS 1
+#define GLFW_REPEAT 2
+#define GLFW_MOUSE_BUTTON_LEFT 0
+#define GLFW_MOUSE_BUTTON_RIGHT 1
+#define GLFW_MOUSE_BUTTON_MIDDLE 2
+#define GLFW_ARROW_CURSOR 0x00036001
+#define GLFW_HAND_CURSOR 0x00036004
+#define GLFW_HRESIZE_CURSOR 0x00036005
+#define GLFW_VRESIZE_CURSOR 0x00036006
+
+inline GLFWcursor* glfwCreateStandardCursor(int) { return NULL; }
+inline void glfwSetCursor(GLFWwindow*, GLFWcursor*) {}
+
+namespace rack {
+
+// ---------------------------------------------------------------------------
+// math
+// ---------------------------------------------------------------------------
+
+namespace math {
+
+inline int clamp(int x, int a, int b) { return std::max(std::min(x, b), a); }
+inline float clamp(float x, float a = 0.f, float b = 1.f) { return std::fmax(std::fmin(x, b), a); }
+inline float rescale(float x, float xMin, float xMax, float yMin, float yMax) {
+    return yMin + (x - xMin) / (xMax - xMin) * (yMax - yMin);
+}
+inline float crossfade(float a, float b, float p) { return a + (b - a) * p; }
+inline int eucMod(int a, int b) {
+    int mod = a % b;
+    if (mod < 0)
+        mod += b;
+    return mod;
+}
+inline float eucMod(float a, float b) {
+    float mod = std::fmod(a, b);
+    if (mod < 0.f)
+        mod += b;
+    return mod;
+}
+inline bool isNear(float a, float b, float epsilon = 1e-6f) { return std::fabs(a - b) <= epsilon; }
+
+struct Vec {
+    float x = 0.f;
+    float y = 0.f;
+    Vec() {}
+    Vec(float xy) : x(xy), y(xy) {}
+    Vec(float x, float y) : x(x), y(y) {}
+    Vec plus(Vec b) const { return Vec(x + b.x, y + b.y); }
+    Vec minus(Vec b) const { return Vec(x - b.x, y - b.y); }
+    Vec mult(float s) const { return Vec(x * s, y * s); }
+    Vec mult(Vec b) const { return Vec(x * b.x, y * b.y); }
+    Vec div(float s) const { return Vec(x / s, y / s); }
+    Vec neg() const { return Vec(-x, -y); }
+    float norm() const { return std::hypot(x, y); }
+    bool equals(Vec b) const { return x == b.x && y == b.y; }
+    Vec operator+(const Vec& b) const { return plus(b); }
+    Vec operator-(const Vec& b) const { return minus(b); }
+    Vec operator*(float s) const { return mult(s); }
+    Vec operator/(float s) const { return div(s); }
+};
+
+struct Rect {
+    Vec pos;
+    Vec size;
+    Rect() {}
+    Rect(Vec pos, Vec size) : pos(pos), size(size) {}
+    Rect(float x, float y, float w, float h) : pos(x, y), size(w, h) {}
+    static Rect fromMinMax(Vec a, Vec b) { return Rect(a, b.minus(a)); }
+    bool equals(Rect r) const { return pos.equals(r.pos) && size.equals(r.size); }
+    Vec getTopLeft() const { return pos; }
+    Vec getBottomRight() const { return pos.plus(size); }
+    Vec getCenter() const { return pos.plus(size.mult(0.5f)); }
+    Vec interpolate(Vec p) const { return Vec(pos.x + size.x * p.x, pos.y + size.y * p.y); }
+    bool contains(Vec v) const {
+        return pos.x <= v.x && v.x < pos.x + size.x && pos.y <= v.y && v.y < pos.y + size.y;
+    }
+    Rect expand(Rect r) const {
+        Vec a(std::min(pos.x, r.pos.x), std::min(pos.y, r.pos.y));
+        Vec b(std::max(pos.x + size.x, r.pos.x + r.size.x), std::max(pos.y + size.y, r.pos.y + r.size.y));
+        return fromMinMax(a, b);
+    }
+    Rect grow(Vec delta) const { return Rect(pos.minus(delta), size.plus(delta.mult(2.f))); }
+    Rect zeroPos() const { return Rect(Vec(), size); }
+};
+
+} // namespace math
+
+using namespace math;
+
+// ---------------------------------------------------------------------------
+// simd
+// ---------------------------------------------------------------------------
+
+namespace simd {
+
+template <typename T, int N>
+struct Vector;
+
+template <>
+struct Vector<float, 4> {
+    union {
+        __m128 v;
+        float s[4];
+    };
+
+    Vector() {}
+    Vector(__m128 v) : v(v) {}
+    Vector(float x) { v = _mm_set1_ps(x); }
+    Vector(float x1, float x2, float x3, float x4) { v = _mm_setr_ps(x1, x2, x3, x4); }
+
+    static Vector zero() { return Vector(_mm_setzero_ps()); }
+    static Vector mask() { return Vector(_mm_castsi128_ps(_mm_set1_epi32(-1))); }
+    static Vector load(const float* x) { return Vector(_mm_loadu_ps(x)); }
+    void store(float* x) { _mm_storeu_ps(x, v); }
+
+    float& operator[](int i) { return s[i]; }
+    const float& operator[](int i) const { return s[i]; }
+
+    inline Vector(Vector<int32_t, 4> a);
+    static inline Vector cast(Vector<int32_t, 4> a);
+};
+
+template <>
+struct Vector<int32_t, 4> {
+    union {
+        __m128i v;
+        int32_t s[4];
+    };
+
+    Vector() {}
+    Vector(__m128i v) : v(v) {}
+    Vector(int32_t x) { v = _mm_set1_epi32(x); }
+
+    int32_t& operator[](int i) { return s[i]; }
+    const int32_t& operator[](int i) const { return s[i]; }
+
+    inline Vector(Vector<float, 4> a);
+    static inline Vector cast(Vector<float, 4> a);
+};
+
+// As in Rack: the conversions round toward zero, cast() reinterprets bits.
+inline Vector<float, 4>::Vector(Vector<int32_t, 4> a) { v = _mm_cvtepi32_ps(a.v); }
+inline Vector<float, 4> Vector<float, 4>::cast(Vector<int32_t, 4> a) { return Vector(_mm_castsi128_ps(a.v)); }
+inline Vector<int32_t, 4>::Vector(Vector<float, 4> a) { v = _mm_cvttps_epi32(a.v); }
+inline Vector<int32_t, 4> Vector<int32_t, 4>::cast(Vector<float, 4> a) { return Vector(_mm_castps_si128(a.v)); }
+
+typedef Vector<float, 4> float_4;
+typedef Vector<int32_t, 4> int32_4;
+
+inline int32_4 operator+(int32_4 a, int32_4 b) { return int32_4(_mm_add_epi32(a.v, b.v)); }
+inline int32_4 operator-(int32_4 a, int32_4 b) { return int32_4(_mm_sub_epi32(a.v, b.v)); }
+// Rack shifts int32_4 logically in both directions.
+inline int32_4 operator<<(int32_4 a, int b) { return int32_4(_mm_sll_epi32(a.v, _mm_cvtsi32_si128(b))); }
+inline int32_4 operator>>(int32_4 a, int b) { return int32_4(_mm_srl_epi32(a.v, _mm_cvtsi32_si128(b))); }
+
+inline float_4 operator+(float_4 a, float_4 b) { return float_4(_mm_add_ps(a.v, b.v)); }
+inline float_4 operator-(float_4 a, float_4 b) { return float_4(_mm_sub_ps(a.v, b.v)); }
+inline float_4 operator*(float_4 a, float_4 b) { return float_4(_mm_mul_ps(a.v, b.v)); }
+inline float_4 operator/(float_4 a, float_4 b) { return float_4(_mm_div_ps(a.v, b.v)); }
+inline float_4 operator-(float_4 a) { return float_4(_mm_sub_ps(_mm_setzero_ps(), a.v)); }
+inline float_4 operator+(float a, float_4 b) { return float_4(a) + b; }
+inline float_4 operator-(float a, float_4 b) { return float_4(a) - b; }
+inline float_4 operator*(float a, float_4 b) { return float_4(a) * b; }
+inline float_4 operator/(float a, float_4 b) { return float_4(a) / b; }
+inline float_4 operator+(float_4 a, float b) { return a + float_4(b); }
+inline float_4 operator-(float_4 a, float b) { return a - float_4(b); }
+inline float_4 operator*(float_4 a, float b) { return a * float_4(b); }
+inline float_4 operator/(float_4 a, float b) { return a / float_4(b); }
+inline float_4& operator+=(float_4& a, float_4 b) { return a = a + b; }
+inline float_4& operator-=(float_4& a, float_4 b) { return a = a - b; }
+inline float_4& operator*=(float_4& a, float_4 b) { return a = a * b; }
+inline float_4& operator/=(float_4& a, float_4 b) { return a = a / b; }
+inline float_4 operator&(float_4 a, float_4 b) { return float_4(_mm_and_ps(a.v, b.v)); }
+inline float_4 operator|(float_4 a, float_4 b) { return float_4(_mm_or_ps(a.v, b.v)); }
+inline float_4 operator^(float_4 a, float_4 b) { return float_4(_mm_xor_ps(a.v, b.v)); }
+inline float_4 operator~(float_4 a) { return a ^ float_4::mask(); }
+inline float_4 operator==(float_4 a, float_4 b) { return float_4(_mm_cmpeq_ps(a.v, b.v)); }
+inline float_4 operator!=(float_4 a, float_4 b) { return float_4(_mm_cmpneq_ps(a.v, b.v)); }
+inline float_4 operator<(float_4 a, float_4 b) { return float_4(_mm_cmplt_ps(a.v, b.v)); }
+inline float_4 operator<=(float_4 a, float_4 b) { return float_4(_mm_cmple_ps(a.v, b.v)); }
+inline float_4 operator>(float_4 a, float_4 b) { return float_4(_mm_cmpgt_ps(a.v, b.v)); }
+inline float_4 operator>=(float_4 a, float_4 b) { return float_4(_mm_cmpge_ps(a.v, b.v)); }
+
+inline float_4 fmax(float_4 a, float_4 b) { return float_4(_mm_max_ps(a.v, b.v)); }
+inline float_4 fmin(float_4 a, float_4 b) { return float_4(_mm_min_ps(a.v, b.v)); }
+inline float_4 clamp(float_4 x, float_4 a = 0.f, float_4 b = 1.f) { return fmin(fmax(x, a), b); }
+inline float_4 abs(float_4 x) { return x & float_4(_mm_castsi128_ps(_mm_set1_epi32(0x7fffffff))); }
+inline float_4 sqrt(float_4 x) { return float_4(_mm_sqrt_ps(x.v)); }
+inline float_4 ifelse(float_4 mask, float_4 a, float_4 b) { return (mask & a) | _mm_andnot_ps(mask.v, b.v); }
+inline float_4 floor(float_4 x) { return float_4(_mm_floor_ps(x.v)); }
+inline int movemask(float_4 a) { return _mm_movemask_ps(a.v); }
+
+inline float clamp(float x, float a = 0.f, float b = 1.f) { return math::clamp(x, a, b); }
+inline float ifelse(bool mask, float a, float b) { return mask ? a : b; }
+
+} // namespace simd
+
+// ---------------------------------------------------------------------------
+// string / random
+// ---------------------------------------------------------------------------
+
+namespace string {
+
+inline std::string f(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    va_list argsCopy;
+    va_copy(argsCopy, args);
+    int size = std::vsnprintf(NULL, 0, format, args);
+    va_end(args);
+    std::string s;
+    if (size > 0) {
+        s.resize(size + 1);
+        std::vsnprintf(&s[0], size + 1, format, argsCopy);
+        s.resize(size);
+    }
+    va_end(argsCopy);
+    return s;
+}
+
+} // namespace string
+
+namespace random {
+
+// xoroshiro128+, as used by Rack's per-thread generator.
+struct Xoroshiro128Plus {
+    uint64_t state[2] = {};
+
+    void seed(uint64_t s0, uint64_t s1) {
+        state[0] = s0;
+        state[1] = s1;
+        // A few rounds to mix weak seeds
+        for (int i = 0; i < 14; i++)
+            operator()();
+    }
+
+    static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+    uint64_t operator()() {
+        uint64_t s0 = state[0];
+        uint64_t s1 = state[1];
+        uint64_t result = s0 + s1;
+        s1 ^= s0;
+        state[0] = rotl(s0, 55) ^ s1 ^ (s1 << 14);
+        state[1] = rotl(s1, 36);
+        return result;
+    }
+};
+
+Xoroshiro128Plus& local();
+
+inline void init() {}
+inline uint64_t u64() { return local()(); }
+inline uint32_t u32() { return (uint32_t) (u64() >> 32); }
+inline float uniform() { return (u32() >> 8) / 16777216.f; }
+inline float normal() {
+    const float radius = std::sqrt(-2.f * std::log(1.f - uniform()));
+    const float theta = 2.f * (float) M_PI * uniform();
+    return radius * std::sin(theta);
+}
+
+} // namespace random
+
+// ---------------------------------------------------------------------------
+// dsp
+// ---------------------------------------------------------------------------
+
+namespace dsp {
+
+template <typename T = float>
+struct TSchmittTrigger;
+
+template <>
+struct TSchmittTrigger<float> {
+    bool state = true;
+    void reset() { state = true; }
+    bool process(float in, float lowThreshold = 0.f, float highThreshold = 1.f) {
+        if (state) {
+            if (in <= lowThreshold)
+                state = false;
+        }
+        else if (in >= highThreshold) {
+            state = true;
+            return true;
+        }
+        return false;
+    }
+    bool isHigh() { return state; }
+};
+typedef TSchmittTrigger<> SchmittTrigger;
+
+struct BooleanTrigger {
+    bool state = true;
+    void reset() { state = true; }
+    bool process(bool in) {
+        bool triggered = (in && !state);
+        state = in;
+        return triggered;
+    }
+};
+
+struct PulseGenerator {
+    float remaining = 0.f;
+    void reset() { remaining = 0.f; }
+    bool process(float deltaTime) {
+        if (remaining > 0.f) {
+            remaining -= deltaTime;
+            return true;
+        }
+        return false;
+    }
+    void trigger(float duration = 1e-3f) {
+        if (duration > remaining)
+            remaining = duration;
+    }
+};
+
+struct ClockDivider {
+    uint32_t clock = 0;
+    uint32_t division = 1;
+    void reset() { clock = 0; }
+    void setDivision(uint32_t d) { division = d; }
+    uint32_t getDivision() { return division; }
+    uint32_t getClock() { return clock; }
+    bool process() {
+        clock++;
+        if (clock >= division) {
+            clock = 0;
+            return true;
+        }
+        return false;
+    }
+};
+
+template <typename T = float>
+struct TRCFilter {
+    T c = 0.f;
+    T xstate[1];
+    T ystate[1];
+
+    TRCFilter() { reset(); }
+    void reset() {
+        xstate[0] = 0.f;
+        ystate[0] = 0.f;
+    }
+    void setCutoff(T r) { c = 2.f / r; }
+    void setCutoffFreq(T f) { setCutoff(2.f * (float) M_PI * f); }
+    void process(T x) {
+        T y = (x + xstate[0] - ystate[0] * (1 - c)) / (1 + c);
+        xstate[0] = x;
+        ystate[0] = y;
+    }
+    T lowpass() { return ystate[0]; }
+    T highpass() { return xstate[0] - ystate[0]; }
+};
+typedef TRCFilter<> RCFilter;
+
+template <typename T = float>
+struct TBiquadFilter {
+    T b[3];
+    T a[2];
+    T x[2];
+    T y[2];
+
+    enum Type {
+        LOWPASS_1POLE,
+        HIGHPASS_1POLE,
+        LOWPASS,
+        HIGHPASS,
+        LOWSHELF,
+        HIGHSHELF,
+        BANDPASS,
+        PEAK,
+        NOTCH,
+        NUM_TYPES
+    };
+
+    TBiquadFilter() {
+        setParameters(LOWPASS, 0.f, 0.f, 1.f);
+        reset();
+    }
+    void reset() {
+        x[0] = x[1] = 0.f;
+        y[0] = y[1] = 0.f;
+    }
+    T process(T in) {
+        T out = b[0] * in + b[1] * x[0] + b[2] * x[1] - a[0] * y[0] - a[1] * y[1];
+        x[1] = x[0];
+        x[0] = in;
+        y[1] = y[0];
+        y[0] = out;
+        return out;
+    }
+    void setParameters(Type type, float f, float Q, float V) {
+        float K = std::tan((float) M_PI * f);
+        switch (type) {
+            case LOWPASS_1POLE: {
+                a[0] = -std::exp(-2.f * (float) M_PI * f);
+                a[1] = 0.f;
+                b[0] = 1.f + a[0];
+                b[1] = 0.f;
+                b[2] = 0.f;
+            } break;
+            case HIGHPASS_1POLE: {
+                a[0] = std::exp(-2.f * (float) M_PI * (0.5f - f));
+                a[1] = 0.f;
+                b[0] = 1.f - a[0];
+                b[1] = 0.f;
+                b[2] = 0.f;
+            } break;
+            case LOWPASS: {
+                float norm = 1.f / (1.f + K / Q + K * K);
+                b[0] = K * K * norm;
+                b[1] = 2.f * b[0];
+                b[2] = b[0];
+                a[0] = 2.f * (K * K - 1.f) * norm;
+                a[1] = (1.f - K / Q + K * K) * norm;
+            } break;
+            case HIGHPASS: {
+                float norm = 1.f / (1.f + K / Q + K * K);
+                b[0] = norm;
+                b[1] = -2.f * b[0];
+                b[2] = b[0];
+                a[0] = 2.f * (K * K - 1.f) * norm;
+                a[1] = (1.f - K / Q + K * K) * norm;
+            } break;
+            case BANDPASS: {
+                float norm = 1.f / (1.f + K / Q + K * K);
+                b[0] = K / Q * norm;
+                b[1] = 0.f;
+                b[2] = -b[0];
+                a[0] = 2.f * (K * K - 1.f) * norm;
+                a[1] = (1.f - K / Q + K * K) * norm;
+            } break;
+            case NOTCH: {
+                float norm = 1.f / (1.f + K / Q + K * K);
+                b[0] = (1.f + K * K) * norm;
+                b[1] = 2.f * (K * K - 1.f) * norm;
+                b[2] = b[0];
+                a[0] = b[1];
+                a[1] = (1.f - K / Q + K * K) * norm;
+            } break;
+            default: {
+                // Shelves and peak are not used by MADZINE; pass through.
+                (void) V;
+                b[0] = 1.f;
+                b[1] = b[2] = 0.f;
+                a[0] = a[1] = 0.f;
+            } break;
+        }
+    }
+};
+typedef TBiquadFilter<> BiquadFilter;
+
+template <typename T>
+T exp2_taylor5(T x) {
+    // Matches Rack's approximation: split into integer and fractional parts,
+    // evaluate a 5th order polynomial for the fraction.
+    T xi = std::floor(x);
+    T xf = x - xi;
+    T yf = 1.f + xf * (0.69315308f + xf * (0.24015361f + xf * (0.05582652f + xf * (0.00898934f + xf * 0.00187757f))));
+    return std::ldexp(yf, (int) xi);
+}
+
+inline simd::float_4 exp2_taylor5(simd::float_4 x) {
+    // As above, with 2^floor(x) built directly in the exponent bits.
+    simd::float_4 xi = simd::floor(x);
+    simd::float_4 xf = x - xi;
+    __m128i e = _mm_slli_epi32(_mm_add_epi32(_mm_cvttps_epi32(xi.v), _mm_set1_epi32(127)), 23);
+    simd::float_4 yi(_mm_castsi128_ps(e));
+    simd::float_4 yf = 1.f + xf * (0.69315308f + xf * (0.24015361f + xf * (0.05582652f + xf * (0.00898934f + xf * 0.00187757f))));
+    return yi * yf;
+}
+
+// A plain DFT with pffft's ordered layout: z[0] = Re(bin 0), z[1] = Re(bin
+// length/2), z[2k], z[2k + 1] = bin k. Only drawn by widgets, never timed.
+struct RealFFT {
+    size_t length;
+    RealFFT(size_t length) : length(length) {}
+    void rfft(const float* input, float* output) {
+        for (size_t k = 0; k <= length / 2; k++) {
+            double re = 0.0, im = 0.0;
+            for (size_t i = 0; i < length; i++) {
+                double phase = 2.0 * M_PI * k * i / length;
+                re += input[i] * std::cos(phase);
+                im -= input[i] * std::sin(phase);
+            }
+            if (k == 0)
+                output[0] = re;
+            else if (k == length / 2)
+                output[1] = re;
+            else {
+                output[2 * k] = re;
+                output[2 * k + 1] = im;
+            }
+        }
+    }
+};
+
+} // namespace dsp
+
+// ---------------------------------------------------------------------------
+// UI events and widgets (inert)
+// ---------------------------------------------------------------------------
+
+namespace widget {
+struct Widget;
+}
+
+namespace event {
+
+struct Base {
+    void consume(widget::Widget*) const {}
+    bool isConsumed() const { return false; }
+};
+struct PositionBase {
+    math::Vec pos;
+};
+struct Hover : Base, PositionBase {
+    math::Vec mouseDelta;
+};
+struct Button : Base, PositionBase {
+    int button = 0;
+    int action = 0;
+    int mods = 0;
+};
+struct DoubleClick : Base {};
+struct HoverKey : Base, PositionBase {
+    int key = 0;
+    int action = 0;
+    int mods = 0;
+};
+struct HoverScroll : Base, PositionBase {
+    math::Vec scrollDelta;
+};
+struct Enter : Base {};
+struct Leave : Base {};
+struct Select : Base {};
+struct Deselect : Base {};
+struct DragBase : Base {
+    int button = 0;
+};
+struct DragStart : DragBase {};
+struct DragEnd : DragBase {};
+struct DragMove : DragBase {
+    math::Vec mouseDelta;
+};
+struct Action : Base {};
+struct Change : Base {};
+struct Dirty : Base {};
+
+} // namespace event
+
+namespace widget {
+
+struct Widget {
+    math::Rect box;
+    Widget* parent = NULL;
+    std::vector<Widget*> children;
+    bool visible = true;
+
+    struct DrawArgs {
+        NVGcontext* vg = NULL;
+        math::Rect clipBox;
+        NVGLUframebuffer* fb = NULL;
+    };
+
+    virtual ~Widget() {
+        for (Widget* child : children)
+            delete child;
+    }
+
+    void addChild(Widget* child) {
+        child->parent = this;
+        children.push_back(child);
+    }
+    void addChildBottom(Widget* child) {
+        child->parent = this;
+        children.insert(children.begin(), child);
+    }
+    void removeChild(Widget* child) {
+        children.erase(std::remove(children.begin(), children.end(), child), children.end());
+        child->parent = NULL;
+    }
+    void show() { visible = true; }
+    void hide() { visible = false; }
+    bool isVisible() { return visible; }
+
+    template <class T>
+    T* getAncestorOfType() {
+        for (Widget* w = parent; w; w = w->parent) {
+            T* t = dynamic_cast<T*>(w);
+            if (t)
+                return t;
+        }
+        return NULL;
+    }
+
+    virtual void step() {}
+    virtual void draw(const DrawArgs& args) {}
+    virtual void drawLayer(const DrawArgs& args, int layer) {}
+
+    virtual void onHover(const event::Hover& e) {}
+    virtual void onButton(const event::Button& e) {}
+    virtual void onDoubleClick(const event::DoubleClick& e) {}
+    virtual void onHoverKey(const event::HoverKey& e) {}
+    virtual void onHoverScroll(const event::HoverScroll& e) {}
+    virtual void onEnter(const event::Enter& e) {}
+    virtual void onLeave(const event::Leave& e) {}
+    virtual void onDragStart(const event::DragStart& e) {}
+    virtual void onDragEnd(const event::DragEnd& e) {}
+    virtual void onDragMove(const event::DragMove& e) {}
+    virtual void onAction(const event::Action& e) {}
+    virtual void onChange(const event::Change& e) {}
+    virtual void onDirty(const event::Dirty& e) {}
+};
+
+struct TransparentWidget : Widget {};
+struct OpaqueWidget : Widget {};
+
+struct FramebufferWidget : Widget {
+    bool dirty = true;
+    double oversample = 1.0;
+    void setDirty(bool dirty = true) { this->dirty = dirty; }
+};
+
+struct SvgWidget : Widget {};
+
+} // namespace widget
+
+using namespace widget;
+
+struct Font {
+    int handle = -1;
+};
+
+struct Svg {};
+
+struct Quantity {
+    virtual ~Quantity() {}
+    virtual void setValue(float value) {}
+    virtual float getValue() { return 0.f; }
+    virtual float getMinValue() { return 0.f; }
+    virtual float getMaxValue() { return 1.f; }
+    virtual float getDefaultValue() { return 0.f; }
+    virtual float getDisplayValue() { return getValue(); }
+    virtual void setDisplayValue(float displayValue) { setValue(displayValue); }
+    virtual int getDisplayPrecision() { return 5; }
+    virtual std::string getDisplayValueString() { return string::f("%g", getDisplayValue()); }
+    virtual std::string getLabel() { return ""; }
+    virtual std::string getUnit() { return ""; }
+    virtual std::string getString() { return getLabel() + ": " + getDisplayValueString() + getUnit(); }
+    virtual void reset() { setValue(getDefaultValue()); }
+    virtual void randomize() {}
+
+    float getRange() { return getMaxValue() - getMinValue(); }
+    float getScaledValue() {
+        float range = getRange();
+        return range != 0.f ? (getValue() - getMinValue()) / range : 0.f;
+    }
+    void setScaledValue(float scaledValue) { setValue(getMinValue() + scaledValue * getRange()); }
+    void moveValue(float deltaValue) { setValue(getValue() + deltaValue); }
+    void moveScaledValue(float deltaScaledValue) { setScaledValue(getScaledValue() + deltaScaledValue); }
+};
+
+namespace plugin {
+struct Model;
+} // namespace plugin
+
+namespace engine {
+
+struct Module;
+
+struct Param {
+    float value = 0.f;
+    float getValue() { return value; }
+    void setValue(float value) { this->value = value; }
+};
+
+static const int PORT_MAX_CHANNELS = 16;
+
+struct Port {
+    union {
+        float voltages[PORT_MAX_CHANNELS] = {};
+        float value;
+    };
+    uint8_t channels = 0;
+
+    void setVoltage(float voltage, int channel = 0) { voltages[channel] = voltage; }
+    float getVoltage(int channel = 0) { return voltages[channel]; }
+    float getPolyVoltage(int channel) { return isMonophonic() ? getVoltage(0) : getVoltage(channel); }
+    float getNormalVoltage(float normalVoltage, int channel = 0) { return isConnected() ? getVoltage(channel) : normalVoltage; }
+    float getNormalPolyVoltage(float normalVoltage, int channel) { return isConnected() ? getPolyVoltage(channel) : normalVoltage; }
+    float* getVoltages(int firstChannel = 0) { return &voltages[firstChannel]; }
+    float getVoltageSum() {
+        float sum = 0.f;
+        for (int c = 0; c < channels; c++)
+            sum += voltages[c];
+        return sum;
+    }
+    template <typename T>
+    T getVoltageSimd(int firstChannel) { return T::load(&voltages[firstChannel]); }
+    template <typename T>
+    T getPolyVoltageSimd(int firstChannel) { return isMonophonic() ? getVoltage(0) : getVoltageSimd<T>(firstChannel); }
+    template <typename T>
+    void setVoltageSimd(T voltage, int firstChannel) { voltage.store(&voltages[firstChannel]); }
+
+    void setChannels(int channels) {
+        if (this->channels == 0)
+            return;
+        for (int c = channels; c < this->channels; c++)
+            voltages[c] = 0.f;
+        if (channels == 0)
+            channels = 1;
+        this->channels = channels;
+    }
+    int getChannels() { return channels; }
+    bool isConnected() { return channels > 0; }
+    bool isMonophonic() { return channels == 1; }
+    bool isPolyphonic() { return channels > 1; }
+};
+
+struct Input : Port {};
+struct Output : Port {};
+
+struct Light {
+    float value = 0.f;
+    void setBrightness(float brightness) { value = brightness; }
+    float getBrightness() { return value; }
+    void setBrightnessSmooth(float brightness, float deltaTime, float lambda = 30.f) {
+        if (brightness < value)
+            value += (brightness - value) * lambda * deltaTime;
+        else
+            value = brightness;
+    }
+    void setSmoothBrightness(float brightness, float deltaTime) { setBrightnessSmooth(brightness, deltaTime); }
+};
+
+struct ParamQuantity : Quantity {
+    Module* module = NULL;
+    int paramId = 0;
+    float minValue = 0.f;
+    float maxValue = 1.f;
+    float defaultValue = 0.f;
+    std::string name;
+    std::string unit;
+    float displayBase = 0.f;
+    float displayMultiplier = 1.f;
+    float displayOffset = 0.f;
+    int displayPrecision = 5;
+    std::string description;
+    bool resetEnabled = true;
+    bool randomizeEnabled = true;
+    bool smoothEnabled = false;
+    bool snapEnabled = false;
+
+    Param* getParam();
+    void setValue(float value) override;
+    float getValue() override;
+    float getMinValue() override { return minValue; }
+    float getMaxValue() override { return maxValue; }
+    float getDefaultValue() override { return defaultValue; }
+    float getDisplayValue() override {
+        float v = getValue();
+        if (displayBase == 0.f)
+            return v * displayMultiplier + displayOffset;
+        if (displayBase < 0.f)
+            return std::log(v) / std::log(-displayBase) * displayMultiplier + displayOffset;
+        return std::pow(displayBase, v) * displayMultiplier + displayOffset;
+    }
+    std::string getLabel() override { return name; }
+    std::string getUnit() override { return unit; }
+    float toScaled(float value) { return math::rescale(value, getMinValue(), getMaxValue(), 0.f, 1.f); }
+    float fromScaled(float scaledValue) { return math::rescale(scaledValue, 0.f, 1.f, getMinValue(), getMaxValue()); }
+    void setImmediateValue(float value) { setValue(value); }
+    float getImmediateValue() { return getValue(); }
+};
+
+struct SwitchQuantity : ParamQuantity {
+    std::vector<std::string> labels;
+    std::string getDisplayValueString() override {
+        int index = (int) std::floor(getValue() - getMinValue());
+        if (index < 0 || index >= (int) labels.size())
+            return ParamQuantity::getDisplayValueString();
+        return labels[index];
+    }
+};
+
+struct PortInfo {
+    Module* module = NULL;
+    int type = 0;
+    int portId = 0;
+    std::string name;
+    std::string description;
+    virtual ~PortInfo() {}
+    virtual std::string getName() { return name; }
+};
+
+struct LightInfo {
+    Module* module = NULL;
+    int lightId = 0;
+    std::string name;
+    std::string description;
+    virtual ~LightInfo() {}
+};
+
+struct Module {
+    plugin::Model* model = NULL;
+    int64_t id = -1;
+    std::vector<Param> params;
+    std::vector<Input> inputs;
+    std::vector<Output> outputs;
+    std::vector<Light> lights;
+    std::vector<ParamQuantity*> paramQuantities;
+    std::vector<PortInfo*> inputInfos;
+    std::vector<PortInfo*> outputInfos;
+    std::vector<LightInfo*> lightInfos;
+
+    virtual ~Module() {
+        for (ParamQuantity* pq : paramQuantities)
+            delete pq;
+        for (PortInfo* info : inputInfos)
+            delete info;
+        for (PortInfo* info : outputInfos)
+            delete info;
+        for (LightInfo* info : lightInfos)
+            delete info;
+    }
+
+    void config(int numParams, int numInputs, int numOutputs, int numLights = 0) {
+        params.resize(numParams);
+        inputs.resize(numInputs);
+        outputs.resize(numOutputs);
+        lights.resize(numLights);
+        paramQuantities.resize(numParams, NULL);
+        for (int i = 0; i < numParams; i++)
+            configParam(i, 0.f, 1.f, 0.f);
+        inputInfos.resize(numInputs, NULL);
+        for (int i = 0; i < numInputs; i++)
+            configInput(i);
+        outputInfos.resize(numOutputs, NULL);
+        for (int i = 0; i < numOutputs; i++)
+            configOutput(i);
+        lightInfos.resize(numLights, NULL);
+    }
+
+    template <class TParamQuantity = ParamQuantity>
+    TParamQuantity* configParam(int paramId, float minValue, float maxValue, float defaultValue, std::string name = "", std::string unit = "", float displayBase = 0.f, float displayMultiplier = 1.f, float displayOffset = 0.f) {
+        if (paramQuantities[paramId])
+            delete paramQuantities[paramId];
+        TParamQuantity* q = new TParamQuantity;
+        q->ParamQuantity::module = this;
+        q->ParamQuantity::paramId = paramId;
+        q->ParamQuantity::minValue = minValue;
+        q->ParamQuantity::maxValue = maxValue;
+        q->ParamQuantity::defaultValue = defaultValue;
+        q->ParamQuantity::name = name;
+        q->ParamQuantity::unit = unit;
+        q->ParamQuantity::displayBase = displayBase;
+        q->ParamQuantity::displayMultiplier = displayMultiplier;
+        q->ParamQuantity::displayOffset = displayOffset;
+        paramQuantities[paramId] = q;
+        params[paramId].value = defaultValue;
+        return q;
+    }
+
+    template <class TSwitchQuantity = SwitchQuantity>
+    TSwitchQuantity* configSwitch(int paramId, float minValue, float maxValue, float defaultValue, std::string name = "", std::vector<std::string> labels = {}) {
+        TSwitchQuantity* sq = configParam<TSwitchQuantity>(paramId, minValue, maxValue, defaultValue, name);
+        sq->snapEnabled = true;
+        sq->smoothEnabled = false;
+        sq->labels = labels;
+        return sq;
+    }
+
+    template <class TSwitchQuantity = SwitchQuantity>
+    TSwitchQuantity* configButton(int paramId, std::string name = "") {
+        TSwitchQuantity* sq = configParam<TSwitchQuantity>(paramId, 0.f, 1.f, 0.f, name);
+        sq->randomizeEnabled = false;
+        sq->snapEnabled = true;
+        return sq;
+    }
+
+    template <class TPortInfo = PortInfo>
+    TPortInfo* configInput(int portId, std::string name = "") {
+        if (inputInfos[portId])
+            delete inputInfos[portId];
+        TPortInfo* info = new TPortInfo;
+        info->module = this;
+        info->type = 0;
+        info->portId = portId;
+        info->name = name;
+        inputInfos[portId] = info;
+        return info;
+    }
+
+    template <class TPortInfo = PortInfo>
+    TPortInfo* configOutput(int portId, std::string name = "") {
+        if (outputInfos[portId])
+            delete outputInfos[portId];
+        TPortInfo* info = new TPortInfo;
+        info->module = this;
+        info->type = 1;
+        info->portId = portId;
+        info->name = name;
+        outputInfos[portId] = info;
+        return info;
+    }
+
+    template <class TLightInfo = LightInfo>
+    TLightInfo* configLight(int lightId, std::string name = "") {
+        if (lightInfos[lightId])
+            delete lightInfos[lightId];
+        TLightInfo* info = new TLightInfo;
+        info->module = this;
+        info->lightId = lightId;
+        info->name = name;
+        lightInfos[lightId] = info;
+        return info;
+    }
+
+    void configBypass(int inputId, int outputId) {}
+
+    ParamQuantity* getParamQuantity(int index) { return paramQuantities[index]; }
+    PortInfo* getInputInfo(int index) { return inputInfos[index]; }
+    PortInfo* getOutputInfo(int index) { return outputInfos[index]; }
+    int getNumParams() { return (int) params.size(); }
+    int getNumInputs() { return (int) inputs.size(); }
+    int getNumOutputs() { return (int) outputs.size(); }
+    int getNumLights() { return (int) lights.size(); }
+
+    struct ProcessArgs {
+        float sampleRate = 0.f;
+        float sampleTime = 0.f;
+        int64_t frame = 0;
+    };
+
+    struct SampleRateChangeEvent {
+        float sampleRate = 0.f;
+        float sampleTime = 0.f;
+    };
+
+    struct ResetEvent {};
+    struct RandomizeEvent {};
+
+    virtual void process(const ProcessArgs& args) {}
+    virtual json_t* dataToJson() { return NULL; }
+    virtual void dataFromJson(json_t* root) {}
+
+    virtual void onSampleRateChange(const SampleRateChangeEvent& e) { onSampleRateChange(); }
+    virtual void onSampleRateChange() {}
+    virtual void onReset(const ResetEvent& e) {
+        for (ParamQuantity* pq : paramQuantities) {
+            if (pq && pq->resetEnabled)
+                pq->reset();
+        }
+        onReset();
+    }
+    virtual void onReset() {}
+    virtual void onRandomize(const RandomizeEvent& e) { onRandomize(); }
+    virtual void onRandomize() {}
+};
+
+inline Param* ParamQuantity::getParam() { return module ? &module->params[paramId] : NULL; }
+inline void ParamQuantity::setValue(float value) {
+    Param* param = getParam();
+    if (!param)
+        return;
+    if (!std::isfinite(value))
+        return;
+    value = math::clamp(value, std::min(minValue, maxValue), std::max(minValue, maxValue));
+    if (snapEnabled)
+        value = std::round(value);
+    param->setValue(value);
+}
+inline float ParamQuantity::getValue() {
+    Param* param = getParam();
+    return param ? param->getValue() : 0.f;
+}
+
+struct Engine {
+    float sampleRate = 44100.f;
+    float getSampleRate() { return sampleRate; }
+    float getSampleTime() { return 1.f / sampleRate; }
+
+    // The harness adds every module it builds, so the engine lists the
+    // live rigs as Rack lists the modules of a patch. Ids count up from 1.
+    // Main thread only.
+    void addModule(Module* module) {
+        if (module->id < 0)
+            module->id = nextModuleId++;
+        modules[module->id] = module;
+    }
+    void removeModule(Module* module) { modules.erase(module->id); }
+    std::vector<int64_t> getModuleIds() {
+        std::vector<int64_t> ids;
+        for (const auto& entry : modules)
+            ids.push_back(entry.first);
+        return ids;
+    }
+    Module* getModule(int64_t moduleId) {
+        auto it = modules.find(moduleId);
+        return (it == modules.end()) ? NULL : it->second;
+    }
+
+private:
+    std::map<int64_t, Module*> modules;
+    int64_t nextModuleId = 1;
+};
+
+} // namespace engine
+
+using namespace engine;
+
+namespace ui {
+
+struct MenuEntry : OpaqueWidget {};
+
+struct Menu : OpaqueWidget {};
+
+struct MenuLabel : MenuEntry {
+    std::string text;
+};
+
+struct MenuSeparator : MenuEntry {};
+
+struct MenuItem : MenuEntry {
+    std::string text;
+    std::string rightText;
+    bool disabled = false;
+    virtual Menu* createChildMenu() { return NULL; }
+};
+
+struct Slider : OpaqueWidget {
+    Quantity* quantity = NULL;
+};
+
+struct Label : Widget {
+    std::string text;
+    float fontSize = 13.f;
+    NVGcolor color;
+};
+
+struct TextField : OpaqueWidget {
+    std::string text;
+};
+
+} // namespace ui
+
+using namespace ui;
+
+namespace app {
+
+struct ParamWidget : OpaqueWidget {
+    engine::Module* module = NULL;
+    int paramId = 0;
+    engine::ParamQuantity* getParamQuantity() {
+        if (!module)
+            return NULL;
+        return module->paramQuantities[paramId];
+    }
+    virtual void initParamQuantity() {}
+    virtual void appendContextMenu(Menu* menu) {}
+};
+
+struct Knob : ParamWidget {
+    bool horizontal = false;
+    bool smooth = true;
+    bool snap = false;
+    float speed = 1.f;
+    float minAngle = -M_PI;
+    float maxAngle = M_PI;
+};
+
+struct SvgKnob : Knob {
+    void setSvg(std::shared_ptr<Svg>) {}
+};
+
+struct SvgSwitch : ParamWidget {
+    bool momentary = false;
+    void addFrame(std::shared_ptr<Svg>) {}
+};
+
+struct PortWidget : OpaqueWidget {
+    engine::Module* module = NULL;
+    int type = 0;
+    int portId = 0;
+};
+
+struct SvgPort : PortWidget {
+    void setSvg(std::shared_ptr<Svg>) {}
+};
+
+struct LightWidget : TransparentWidget {
+    NVGcolor bgColor;
+    NVGcolor color;
+    NVGcolor borderColor;
+    std::vector<NVGcolor> baseColors;
+    void addBaseColor(NVGcolor c) { baseColors.push_back(c); }
+};
+
+struct ModuleLightWidget : LightWidget {
+    engine::Module* module = NULL;
+    int firstLightId = 0;
+};
+
+struct CableWidget : OpaqueWidget {
+    NVGcolor color;
+};
+
+struct RackWidget : OpaqueWidget {
+    CableWidget* getTopCable(PortWidget* port) { return NULL; }
+};
+
+struct Scene : OpaqueWidget {
+    RackWidget* rack = NULL;
+};
+
+struct SvgPanel : Widget {
+    void setBackground(std::shared_ptr<Svg>) {}
+};
+
+struct LedDisplay : Widget {};
+
+struct ModuleWidget : OpaqueWidget {
+    engine::Module* module = NULL;
+    std::vector<ParamWidget*> paramWidgets;
+    std::vector<PortWidget*> inputWidgets;
+    std::vector<PortWidget*> outputWidgets;
+
+    engine::Module* getModule() { return module; }
+    template <class TModule>
+    TModule* getModule() { return dynamic_cast<TModule*>(module); }
+    void setModule(engine::Module* module) { this->module = module; }
+    void setPanel(Widget* panel) { addChild(panel); }
+    void setPanel(std::shared_ptr<Svg> svg) {}
+    void addParam(ParamWidget* param) {
+        addChild(param);
+        paramWidgets.push_back(param);
+    }
+    void addInput(PortWidget* input) {
+        addChild(input);
+        inputWidgets.push_back(input);
+    }
+    void addOutput(PortWidget* output) {
+        addChild(output);
+        outputWidgets.push_back(output);
+    }
+    ParamWidget* getParam(int paramId) {
+        for (ParamWidget* pw : paramWidgets) {
+            if (pw->paramId == paramId)
+                return pw;
+        }
+        return NULL;
+    }
+    PortWidget* getInput(int portId) {
+        for (PortWidget* pw : inputWidgets) {
+            if (pw->portId == portId)
+                return pw;
+        }
+        return NULL;
+    }
+    PortWidget* getOutput(int portId) {
+        for (PortWidget* pw : outputWidgets) {
+            if (pw->portId == portId)
+                return pw;
+        }
+        return NULL;
+    }
+    virtual void appendContextMenu(Menu* menu) {}
+};
+
+} // namespace app
+
+using namespace app;
+
+// ---------------------------------------------------------------------------
+// Context, plugin and model
+// ---------------------------------------------------------------------------
+
+struct Window {
+    GLFWwindow* win = NULL;
+    std::shared_ptr<Font> uiFont = std::make_shared<Font>();
+    std::shared_ptr<Svg> loadSvg(const std::string& filename) { return std::make_shared<Svg>(); }
+    int getMods() { return 0; }
+    double getLastFrameDuration() { return 0.0; }
+    int64_t getFrame() { return 0; }
+};
+
+struct Context {
+    engine::Engine* engine = NULL;
+    Window* window = NULL;
+    app::Scene* scene = NULL;
+};
+
+Context* contextGet();
+#define APP rack::contextGet()
+
+namespace plugin {
+
+struct Plugin;
+
+struct Model {
+    Plugin* plugin = NULL;
+    std::string slug;
+    std::string name;
+    // Not in Rack: sizeof the module type, for the bench's memory report.
+    size_t moduleSize = 0;
+    virtual ~Model() {}
+    virtual engine::Module* createModule() { return NULL; }
+    virtual app::ModuleWidget* createModuleWidget(engine::Module* m) { return NULL; }
+};
+
+struct Plugin {
+    std::vector<Model*> models;
+    std::string slug;
+    void addModel(Model* model) {
+        model->plugin = this;
+        models.push_back(model);
+    }
+    Model* getModel(const std::string& slug) {
+        for (Model* model : models) {
+            if (model->slug == slug)
+                return model;
+        }
+        return NULL;
+    }
+};
+
+} // namespace plugin
+
+using plugin::Plugin;
+using plugin::Model;
+
+namespace asset {
+inline std::string plugin(plugin::Plugin* plugin, const std::string& filename) { return filename; }
+inline std::string system(const std::string& filename) { return filename; }
+// The user folder: the working directory unless a tool sets userDir.
+extern std::string userDir;
+inline std::string user(const std::string& filename) { return userDir.empty() ? filename : userDir + "/" + filename; }
+} // namespace asset
+
+namespace system {
+bool createDirectories(const std::string& path);
+} // namespace system
+
+template <class TModule, class TModuleWidget>
+plugin::Model* createModel(const std::string& slug) {
+    struct TModel : plugin::Model {
+        engine::Module* createModule() override {
+            TModule* m = new TModule;
+            m->model = this;
+            return m;
+        }
+        app::ModuleWidget* createModuleWidget(engine::Module* m) override {
+            TModule* tm = NULL;
+            if (m)
+                tm = dynamic_cast<TModule*>(m);
+            return new TModuleWidget(tm);
+        }
+    };
+    plugin::Model* o = new TModel;
+    o->slug = slug;
+    o->moduleSize = sizeof(TModule);
+    return o;
+}
+
+template <class TWidget>
+TWidget* createWidget(math::Vec pos) {
+    TWidget* o = new TWidget;
+    o->box.pos = pos;
+    return o;
+}
+
+template <class TWidget>
+TWidget* createWidgetCentered(math::Vec pos) {
+    TWidget* o = createWidget<TWidget>(pos);
+    o->box.pos = o->box.pos.minus(o->box.size.div(2));
+    return o;
+}
+
+inline app::SvgPanel* createPanel(std::string svgPath) { return new app::SvgPanel; }
+
+template <class TParamWidget>
+TParamWidget* createParam(math::Vec pos, engine::Module* module, int paramId) {
+    TParamWidget* o = new TParamWidget;
+    o->box.pos = pos;
+    o->app::ParamWidget::module = module;
+    o->app::ParamWidget::paramId = paramId;
+    o->initParamQuantity();
+    return o;
+}
+
+template <class TParamWidget>
+TParamWidget* createParamCentered(math::Vec pos, engine::Module* module, int paramId) {
+    TParamWidget* o = createParam<TParamWidget>(pos, module, paramId);
+    o->box.pos = o->box.pos.minus(o->box.size.div(2));
+    return o;
+}
+
+template <class TPortWidget>
+TPortWidget* createInput(math::Vec pos, engine::Module* module, int inputId) {
+    TPortWidget* o = new TPortWidget;
+    o->box.pos = pos;
+    o->app::PortWidget::module = module;
+    o->app::PortWidget::type = 0;
+    o->app::PortWidget::portId = inputId;
+    return o;
+}
+
+template <class TPortWidget>
+TPortWidget* createInputCentered(math::Vec pos, engine::Module* module, int inputId) {
+    TPortWidget* o = createInput<TPortWidget>(pos, module, inputId);
+    o->box.pos = o->box.pos.minus(o->box.size.div(2));
+    return o;
+}
+
+template <class TPortWidget>
+TPortWidget* createOutput(math::Vec pos, engine::Module* module, int outputId) {
+    TPortWidget* o = new TPortWidget;
+    o->box.pos = pos;
+    o->app::PortWidget::module = module;
+    o->app::PortWidget::type = 1;
+    o->app::PortWidget::portId = outputId;
+    return o;
+}
+
+template <class TPortWidget>
+TPortWidget* createOutputCentered(math::Vec pos, engine::Module* module, int outputId) {
+    TPortWidget* o = createOutput<TPortWidget>(pos, module, outputId);
+    o->box.pos = o->box.pos.minus(o->box.size.div(2));
+    return o;
+}
+
+template <class TModuleLightWidget>
+TModuleLightWidget* createLight(math::Vec pos, engine::Module* module, int firstLightId) {
+    TModuleLightWidget* o = new TModuleLightWidget;
+    o->box.pos = pos;
+    o->app::ModuleLightWidget::module = module;
+    o->app::ModuleLightWidget::firstLightId = firstLightId;
+    return o;
+}
+
+template <class TModuleLightWidget>
+TModuleLightWidget* createLightCentered(math::Vec pos, engine::Module* module, int firstLightId) {
+    TModuleLightWidget* o = createLight<TModuleLightWidget>(pos, module, firstLightId);
+    o->box.pos = o->box.pos.minus(o->box.size.div(2));
+    return o;
+}
+
+inline ui::MenuLabel* createMenuLabel(std::string text) {
+    ui::MenuLabel* o = new ui::MenuLabel;
+    o->text = text;
+    return o;
+}
+
+template <class TMenuItem = ui::MenuItem>
+TMenuItem* createMenuItem(std::string text, std::string rightText = "", std::function<void()> action = []() {}, bool disabled = false) {
+    TMenuItem* item = new TMenuItem;
+    item->text = text;
+    item->rightText = rightText;
+    item->disabled = disabled;
+    return item;
+}
+
+template <class TMenuItem = ui::MenuItem>
+ui::MenuItem* createBoolMenuItem(std::string text, std::string rightText, std::function<bool()> getter, std::function<void(bool)> setter, bool disabled = false) {
+    return createMenuItem<TMenuItem>(text, rightText, []() {}, disabled);
+}
+
+template <typename T>
+ui::MenuItem* createBoolPtrMenuItem(std::string text, std::string rightText, T* ptr) {
+    return createMenuItem(text, rightText);
+}
+
+template <class TMenuItem = ui::MenuItem>
+ui::MenuItem* createSubmenuItem(std::string text, std::string rightText, std::function<void(ui::Menu*)> createMenu, bool disabled = false) {
+    return createMenuItem<TMenuItem>(text, rightText, []() {}, disabled);
+}
+
+inline ui::Menu* createMenu() { return new ui::Menu; }
+
+// ---------------------------------------------------------------------------
+// Component library (only what MADZINE panels reference)
+// ---------------------------------------------------------------------------
+
+namespace componentlibrary {
+
+struct GrayModuleLightWidget : app::ModuleLightWidget {};
+struct RedLight : GrayModuleLightWidget {};
+struct GreenLight : GrayModuleLightWidget {};
+struct BlueLight : GrayModuleLightWidget {};
+struct YellowLight : GrayModuleLightWidget {};
+struct WhiteLight : GrayModuleLightWidget {};
+struct RedGreenBlueLight : GrayModuleLightWidget {};
+
+template <typename TBase = GrayModuleLightWidget>
+struct TSvgLight : TBase {};
+template <typename TBase = GrayModuleLightWidget>
+struct SmallLight : TSvgLight<TBase> {};
+template <typename TBase = GrayModuleLightWidget>
+struct MediumLight : TSvgLight<TBase> {};
+template <typename TBase = GrayModuleLightWidget>
+struct LargeLight : TSvgLight<TBase> {};
+
+struct PJ301MPort : app::SvgPort {};
+struct Trimpot : app::SvgKnob {};
+struct RoundBlackKnob : app::SvgKnob {};
+struct RoundSmallBlackKnob : app::SvgKnob {};
+struct VCVButton : app::SvgSwitch {};
+struct VCVLatch : VCVButton {};
+struct ScrewSilver : widget::SvgWidget {};
+
+} // namespace componentlibrary
+
+using namespace componentlibrary;
+
+} // namespace rack
@@ -1,153 +1,23 @@
 #include "plugin.hpp"
+#include "cached.hpp"
+#include "denormal.hpp"
+#include "envelope.hpp"
+#include "fastmath.hpp"
+#include "perf.hpp"
+#include "widgets.hpp"
 
-struct EnhancedTextLabel : TransparentWidget {
-    std::string text;
-    float fontSize;
-    NVGcolor color;
-    bool bold;
-    
-    EnhancedTextLabel(Vec pos, Vec size, std::string text, float fontSize = 12.f, 
-                      NVGcolor color = nvgRGB(255, 255, 255), bool bold = true) {
-        box.pos = pos;
-        box.size = size;
-        this->text = text;
-        this->fontSize = fontSize;
-        this->color = color;
-        this->bold = bold;
-    }
-    
-    void draw(const DrawArgs &args) override {
-        nvgFontSize(args.vg, fontSize);
-        nvgFontFaceId(args.vg, APP->window->uiFont->handle);
-        nvgTextAlign(args.vg, NVG_ALIGN_CENTER | NVG_ALIGN_MIDDLE);
-        nvgFillColor(args.vg, color);
-        
-        if (bold) {
-            float offset = 0.3f;
-            nvgText(args.vg, box.size.x / 2.f - offset, box.size.y / 2.f, text.c_str(), NULL);
-            nvgText(args.vg, box.size.x / 2.f + offset, box.size.y / 2.f, text.c_str(), NULL);
-            nvgText(args.vg, box.size.x / 2.f, box.size.y / 2.f - offset, text.c_str(), NULL);
-            nvgText(args.vg, box.size.x / 2.f, box.size.y / 2.f + offset, text.c_str(), NULL);
-            nvgText(args.vg, box.size.x / 2.f, box.size.y / 2.f, text.c_str(), NULL);
-        } else {
-            nvgText(args.vg, box.size.x / 2.f, box.size.y / 2.f, text.c_str(), NULL);
-        }
-    }
-};
-
-struct WhiteBackgroundBox : Widget {
-    WhiteBackgroundBox(Vec pos, Vec size) {
+struct UFOWidget : CachedWidget {
+    UFOWidget(Vec pos, Vec size) {
         box.pos = pos;
         box.size = size;
     }
     
-    void draw(const DrawArgs &args) override {
-        nvgBeginPath(args.vg);
-        nvgRect(args.vg, 0, 0, box.size.x, box.size.y);
-        nvgFillColor(args.vg, nvgRGB(255, 255, 255));
-        nvgFill(args.vg);
-        
-        nvgStrokeWidth(args.vg, 1.0f);
-        nvgStrokeColor(args.vg, nvgRGBA(200, 200, 200, 255));
-        nvgStroke(args.vg);
+    // The tilted beam reaches about 2.5 px below the box.
+    math::Rect cacheBounds() override {
+        return box.zeroPos().grow(Vec(0.f, 3.f));
     }
-};
-
-struct StandardBlackKnob : ParamWidget {
-    bool isDragging = false;
     
-    StandardBlackKnob() {
-        box.size = Vec(26, 26);
-    }
-    
-    float getDisplayAngle() {
-        ParamQuantity* pq = getParamQuantity();
-        if (!pq) return 0.0f;
-        
-        float normalizedValue = pq->getScaledValue();
-        float angle = rescale(normalizedValue, 0.0f, 1.0f, -0.75f * M_PI, 0.75f * M_PI);
-        return angle;
-    }
-    
-    void draw(const DrawArgs& args) override {
-        float radius = box.size.x / 2.0f;
-        float angle = getDisplayAngle();
-        
-        nvgBeginPath(args.vg);
-        nvgCircle(args.vg, radius, radius, radius - 1);
-        nvgFillColor(args.vg, nvgRGB(30, 30, 30));
-        nvgFill(args.vg);
-        
-        nvgBeginPath(args.vg);
-        nvgCircle(args.vg, radius, radius, radius - 1);
-        nvgStrokeWidth(args.vg, 1.0f);
-        nvgStrokeColor(args.vg, nvgRGB(100, 100, 100));
-        nvgStroke(args.vg);
-        
-        nvgBeginPath(args.vg);
-        nvgCircle(args.vg, radius, radius, radius - 4);
-        nvgFillColor(args.vg, nvgRGB(50, 50, 50));
-        nvgFill(args.vg);
-        
-        float indicatorLength = radius - 8;
-        float lineX = radius + indicatorLength * std::sin(angle);
-        float lineY = radius - indicatorLength * std::cos(angle);
-        
-        nvgBeginPath(args.vg);
-        nvgMoveTo(args.vg, radius, radius);
-        nvgLineTo(args.vg, lineX, lineY);
-        nvgStrokeWidth(args.vg, 2.0f);
-        nvgStrokeColor(args.vg, nvgRGB(255, 255, 255));
-        nvgStroke(args.vg);
-        
-        nvgBeginPath(args.vg);
-        nvgCircle(args.vg, lineX, lineY, 2.0f);
-        nvgFillColor(args.vg, nvgRGB(255, 255, 255));
-        nvgFill(args.vg);
-    }
-    
-    void onButton(const event::Button& e) override {
-        if (e.action == GLFW_PRESS && e.button == GLFW_MOUSE_BUTTON_LEFT) {
-            isDragging = true;
-            e.consume(this);
-        }
-        else if (e.action == GLFW_RELEASE && e.button == GLFW_MOUSE_BUTTON_LEFT) {
-            isDragging = false;
-        }
-        ParamWidget::onButton(e);
-    }
-    
-    void onDragMove(const event::DragMove& e) override {
-        ParamQuantity* pq = getParamQuantity();
-        if (!isDragging || !pq) return;
-        
-        float sensitivity = 0.002f;
-        float deltaY = -e.mouseDelta.y;
-        
-        float range = pq->getMaxValue() - pq->getMinValue();
-        float currentValue = pq->getValue();
-        float newValue = currentValue + deltaY * sensitivity * range;
-        newValue = clamp(newValue, pq->getMinValue(), pq->getMaxValue());
-        
-        pq->setValue(newValue);
-    }
-    
-    void onDoubleClick(const event::DoubleClick& e) override {
-        ParamQuantity* pq = getParamQuantity();
-        if (!pq) return;
-        
-        pq->reset();
-        e.consume(this);
-    }
-};
-
-struct UFOWidget : Widget {
-    UFOWidget(Vec pos, Vec size) {
-        box.pos = pos;
-        box.size = size;
-    }
-    
-    void draw(const DrawArgs &args) override {
+    void drawCached(const DrawArgs &args) override {
         float centerX = box.size.x / 2.0f;
         float centerY = box.size.y / 2.0f;
         
@@ -192,13 +62,13 @@ struct UFOWidget : Widget {
     }
 };
 
-struct FluteWidget : Widget {
+struct FluteWidget : CachedWidget {
     FluteWidget(Vec pos, Vec size) {
         box.pos = pos;
         box.size = size;
     }
     
-    void draw(const DrawArgs &args) override {
+    void drawCached(const DrawArgs &args) override {
         float centerX = box.size.x / 2.0f;
         float centerY = box.size.y / 2.0f;
         
@@ -260,13 +130,13 @@ struct FluteWidget : Widget {
     }
 };
 
-struct HouseWidget : Widget {
+struct HouseWidget : CachedWidget {
     HouseWidget(Vec pos, Vec size) {
         box.pos = pos;
         box.size = size;
     }
     
-    void draw(const DrawArgs &args) override {
+    void drawCached(const DrawArgs &args) override {
         float centerX = box.size.x / 2.0f;
         float centerY = box.size.y / 2.0f;
         
@@ -335,7 +205,7 @@ struct HouseWidget : Widget {
     }
 };
 
-struct ADGenerator : Module {
+struct ADGenerator : MeteredModule {
     enum ParamId {
         ATK_ALL_PARAM,
         DEC_ALL_PARAM,
@@ -398,18 +268,19 @@ struct ADGenerator : Module {
         }
         
         float process(float input, float cutoff, float sampleRate) {
-            float f = 2.0f * std::sin(M_PI * cutoff / sampleRate);
+            float f = 2.0f * fastSin2pi(0.5f * cutoff / sampleRate);
             f = clamp(f, 0.0f, 1.0f);
             
-            lowpass += f * (input - lowpass);
+            lowpass = flushDenormal(lowpass + f * (input - lowpass));
             highpass = input - lowpass;
-            bandpass += f * (highpass - bandpass);
+            bandpass = flushDenormal(bandpass + f * (highpass - bandpass));
             
             return bandpass;
         }
     };
     
     BandPassFilter bpfFilters[3];
+    int bpfStat;
 
     struct ADEnvelope {
         enum Phase {
@@ -450,27 +321,9 @@ struct ADGenerator : Module {
             oldPhaseTime = 0.0f;
         }
         
-        float applyCurve(float x, float curvature) {
-            x = clamp(x, 0.0f, 1.0f);
-            
-            if (curvature == 0.0f) {
-                return x;
-            }
-            
-            float k = curvature;
-            float abs_x = std::abs(x);
-            float denominator = k - 2.0f * k * abs_x + 1.0f;
-            
-            if (std::abs(denominator) < 1e-6f) {
-                return x;
-            }
-            
-            return (x - k * x) / denominator;
-        }
-        
         float processEnvelopeFollower(float triggerVoltage, float sampleTime, float attackTime, float releaseTime, float curve) {
-            attackCoeff = 1.0f - std::exp(-sampleTime / std::max(0.0005f, attackTime * 0.1f));
-            releaseCoeff = 1.0f - std::exp(-sampleTime / std::max(0.001f, releaseTime * 0.5f));
+            attackCoeff = 1.0f - fastExp(-sampleTime / std::max(0.0005f, attackTime * 0.1f));
+            releaseCoeff = 1.0f - fastExp(-sampleTime / std::max(0.001f, releaseTime * 0.5f));
             
             attackCoeff = clamp(attackCoeff, 0.0f, 1.0f);
             releaseCoeff = clamp(releaseCoeff, 0.0f, 1.0f);
@@ -490,7 +343,7 @@ struct ADGenerator : Module {
             targetCoeff = clamp(targetCoeff, 0.0f, 1.0f);
             
             followerState += (rectified - followerState) * targetCoeff;
-            followerState = clamp(followerState, 0.0f, 1.0f);
+            followerState = flushDenormal(clamp(followerState, 0.0f, 1.0f));
             
             return followerState;
         }
@@ -540,8 +393,8 @@ struct ADGenerator : Module {
             float atkOffset = atkAll * 0.5f;
             float decOffset = decAll * 0.5f;
             
-            oldAttackTime = std::pow(10.0f, (attack - 0.5f) * 6.0f) + atkOffset;
-            oldDecayTime = std::pow(10.0f, (decay - 0.5f) * 6.0f) + decOffset;
+            oldAttackTime = fastPow10((attack - 0.5f) * 6.0f) + atkOffset;
+            oldDecayTime = fastPow10((decay - 0.5f) * 6.0f) + decOffset;
             
             oldAttackTime = std::max(0.001f, oldAttackTime);
             oldDecayTime = std::max(0.001f, oldDecayTime);
@@ -594,8 +447,8 @@ struct ADGenerator : Module {
                 float atkOffset = atkAll * 0.5f;
                 float decOffset = decAll * 0.5f;
                 
-                attackTime = std::pow(10.0f, (attack - 0.5f) * 6.0f) + atkOffset;
-                decayTime = std::pow(10.0f, (decay - 0.5f) * 6.0f) + decOffset;
+                attackTime = fastPow10((attack - 0.5f) * 6.0f) + atkOffset;
+                decayTime = fastPow10((decay - 0.5f) * 6.0f) + decOffset;
                 
                 attackTime = std::max(0.001f, attackTime);
                 decayTime = std::max(0.001f, decayTime);
@@ -616,6 +469,7 @@ struct ADGenerator : Module {
 
     ADGenerator() {
         config(PARAMS_LEN, INPUTS_LEN, OUTPUTS_LEN, LIGHTS_LEN);
+        bpfStat = perf.addStat("BPFs", PerfMeter::MEAN);
         
         configParam(ATK_ALL_PARAM, -1.0f, 1.0f, 0.0f, "Attack All");
         configParam(DEC_ALL_PARAM, -1.0f, 1.0f, 0.0f, "Decay All");
@@ -710,6 +564,7 @@ struct ADGenerator : Module {
     }
 
     void process(const ProcessArgs& args) override {
+        PerfMeter::Scope perfScope(perf, args.sampleRate);
         float sumOutput = 0.0f;
         float atkAll = params[ATK_ALL_PARAM].getValue();
         float decAll = params[DEC_ALL_PARAM].getValue();
@@ -739,6 +594,7 @@ struct ADGenerator : Module {
             float processedSignal = inputSignals[i];
             if (bpfEnabled[i]) {
                 processedSignal = bpfFilters[i].process(inputSignals[i], bpfCutoffs[i], args.sampleRate);
+                perf.add(bpfStat, 1.0f);
             }
             
             float attackParam = params[TRACK1_ATTACK_PARAM + i * 6].getValue();
@@ -839,6 +695,15 @@ struct ADGeneratorWidget : ModuleWidget {
         addChild(new EnhancedTextLabel(Vec(38, 337), Vec(12, 10), "2", 7.f, nvgRGB(255, 133, 133), true));
         addChild(new EnhancedTextLabel(Vec(69, 337), Vec(12, 10), "3", 7.f, nvgRGB(255, 133, 133), true));
         addChild(new EnhancedTextLabel(Vec(96, 337), Vec(16, 10), "MIYA", 7.f, nvgRGB(255, 133, 133), true));
+
+        addChild(new PerfReadout(module, box.size.x));
+    }
+
+    void appendContextMenu(Menu* menu) override {
+        ADGenerator* module = getModule<ADGenerator>();
+        if (!module) return;
+
+        appendPerfMenu(menu, module);
     }
 };
 
@@ -1,243 +1,12 @@
 #include "plugin.hpp"
+#include "euclidean.hpp"
+#include "perf.hpp"
+#include "widgets.hpp"
+#include "divmult.hpp"
 #include <vector>
 #include <numeric>
 #include <algorithm>
 
-struct EnhancedTextLabel : TransparentWidget {
-    std::string text;
-    float fontSize;
-    NVGcolor color;
-    bool bold;
-    
-    EnhancedTextLabel(Vec pos, Vec size, std::string text, float fontSize = 12.f, 
-                      NVGcolor color = nvgRGB(255, 255, 255), bool bold = true) {
-        box.pos = pos;
-        box.size = size;
-        this->text = text;
-        this->fontSize = fontSize;
-        this->color = color;
-        this->bold = bold;
-    }
-    
-    void draw(const DrawArgs &args) override {
-        nvgFontSize(args.vg, fontSize);
-        nvgFontFaceId(args.vg, APP->window->uiFont->handle);
-        nvgTextAlign(args.vg, NVG_ALIGN_CENTER | NVG_ALIGN_MIDDLE);
-        nvgFillColor(args.vg, color);
-        
-        if (bold) {
-            float offset = 0.3f;
-            nvgText(args.vg, box.size.x / 2.f - offset, box.size.y / 2.f, text.c_str(), NULL);
-            nvgText(args.vg, box.size.x / 2.f + offset, box.size.y / 2.f, text.c_str(), NULL);
-            nvgText(args.vg, box.size.x / 2.f, box.size.y / 2.f - offset, text.c_str(), NULL);
-            nvgText(args.vg, box.size.x / 2.f, box.size.y / 2.f + offset, text.c_str(), NULL);
-            nvgText(args.vg, box.size.x / 2.f, box.size.y / 2.f, text.c_str(), NULL);
-        } else {
-            nvgText(args.vg, box.size.x / 2.f, box.size.y / 2.f, text.c_str(), NULL);
-        }
-    }
-};
-
-struct WhiteBackgroundBox : Widget {
-    WhiteBackgroundBox(Vec pos, Vec size) {
-        box.pos = pos;
-        box.size = size;
-    }
-    
-    void draw(const DrawArgs &args) override {
-        nvgBeginPath(args.vg);
-        nvgRect(args.vg, 0, 0, box.size.x, box.size.y);
-        nvgFillColor(args.vg, nvgRGB(255, 255, 255));
-        nvgFill(args.vg);
-        
-        nvgStrokeWidth(args.vg, 1.0f);
-        nvgStrokeColor(args.vg, nvgRGBA(200, 200, 200, 255));
-        nvgStroke(args.vg);
-    }
-};
-
-struct StandardBlackKnob : ParamWidget {
-    bool isDragging = false;
-    
-    StandardBlackKnob() {
-        box.size = Vec(26, 26);
-    }
-    
-    float getDisplayAngle() {
-        ParamQuantity* pq = getParamQuantity();
-        if (!pq) return 0.0f;
-        
-        float normalizedValue = pq->getScaledValue();
-        float angle = rescale(normalizedValue, 0.0f, 1.0f, -0.75f * M_PI, 0.75f * M_PI);
-        return angle;
-    }
-    
-    void draw(const DrawArgs& args) override {
-        float radius = box.size.x / 2.0f;
-        float angle = getDisplayAngle();
-        
-        nvgBeginPath(args.vg);
-        nvgCircle(args.vg, radius, radius, radius - 1);
-        nvgFillColor(args.vg, nvgRGB(30, 30, 30));
-        nvgFill(args.vg);
-        
-        nvgBeginPath(args.vg);
-        nvgCircle(args.vg, radius, radius, radius - 1);
-        nvgStrokeWidth(args.vg, 1.0f);
-        nvgStrokeColor(args.vg, nvgRGB(100, 100, 100));
-        nvgStroke(args.vg);
-        
-        nvgBeginPath(args.vg);
-        nvgCircle(args.vg, radius, radius, radius - 4);
-        nvgFillColor(args.vg, nvgRGB(50, 50, 50));
-        nvgFill(args.vg);
-        
-        float indicatorLength = radius - 8;
-        float lineX = radius + indicatorLength * std::sin(angle);
-        float lineY = radius - indicatorLength * std::cos(angle);
-        
-        nvgBeginPath(args.vg);
-        nvgMoveTo(args.vg, radius, radius);
-        nvgLineTo(args.vg, lineX, lineY);
-        nvgStrokeWidth(args.vg, 2.0f);
-        nvgStrokeColor(args.vg, nvgRGB(255, 255, 255));
-        nvgStroke(args.vg);
-        
-        nvgBeginPath(args.vg);
-        nvgCircle(args.vg, lineX, lineY, 2.0f);
-        nvgFillColor(args.vg, nvgRGB(255, 255, 255));
-        nvgFill(args.vg);
-    }
-    
-    void onButton(const event::Button& e) override {
-        if (e.action == GLFW_PRESS && e.button == GLFW_MOUSE_BUTTON_LEFT) {
-            isDragging = true;
-            e.consume(this);
-        }
-        else if (e.action == GLFW_RELEASE && e.button == GLFW_MOUSE_BUTTON_LEFT) {
-            isDragging = false;
-        }
-        ParamWidget::onButton(e);
-    }
-    
-    void onDragMove(const event::DragMove& e) override {
-        ParamQuantity* pq = getParamQuantity();
-        if (!isDragging || !pq) return;
-        
-        float sensitivity = 0.002f;
-        float deltaY = -e.mouseDelta.y;
-        
-        float range = pq->getMaxValue() - pq->getMinValue();
-        float currentValue = pq->getValue();
-        float newValue = currentValue + deltaY * sensitivity * range;
-        newValue = clamp(newValue, pq->getMinValue(), pq->getMaxValue());
-        
-        pq->setValue(newValue);
-    }
-    
-    void onDoubleClick(const event::DoubleClick& e) override {
-        ParamQuantity* pq = getParamQuantity();
-        if (!pq) return;
-        
-        pq->reset();
-        e.consume(this);
-    }
-};
-
-struct SnapKnob : ParamWidget {
-    float accumDelta = 0.0f;
-    
-    SnapKnob() {
-        box.size = Vec(26, 26);
-    }
-    
-    float getDisplayAngle() {
-        ParamQuantity* pq = getParamQuantity();
-        if (!pq) return 0.0f;
-        
-        float normalizedValue = pq->getScaledValue();
-        float angle = rescale(normalizedValue, 0.0f, 1.0f, -0.75f * M_PI, 0.75f * M_PI);
-        return angle;
-    }
-    
-    void draw(const DrawArgs& args) override {
-        float radius = box.size.x / 2.0f;
-        float angle = getDisplayAngle();
-        
-        nvgBeginPath(args.vg);
-        nvgCircle(args.vg, radius, radius, radius - 1);
-        nvgFillColor(args.vg, nvgRGB(30, 30, 30));
-        nvgFill(args.vg);
-        
-        nvgBeginPath(args.vg);
-        nvgCircle(args.vg, radius, radius, radius - 1);
-        nvgStrokeWidth(args.vg, 1.0f);
-        nvgStrokeColor(args.vg, nvgRGB(100, 100, 100));
-        nvgStroke(args.vg);
-        
-        nvgBeginPath(args.vg);
-        nvgCircle(args.vg, radius, radius, radius - 4);
-        nvgFillColor(args.vg, nvgRGB(50, 50, 50));
-        nvgFill(args.vg);
-        
-        float indicatorLength = radius - 8;
-        float lineX = radius + indicatorLength * std::sin(angle);
-        float lineY = radius - indicatorLength * std::cos(angle);
-        
-        nvgBeginPath(args.vg);
-        nvgMoveTo(args.vg, radius, radius);
-        nvgLineTo(args.vg, lineX, lineY);
-        nvgStrokeWidth(args.vg, 2.0f);
-        nvgStrokeColor(args.vg, nvgRGB(255, 255, 255));
-        nvgStroke(args.vg);
-        
-        nvgBeginPath(args.vg);
-        nvgCircle(args.vg, lineX, lineY, 2.0f);
-        nvgFillColor(args.vg, nvgRGB(255, 255, 255));
-        nvgFill(args.vg);
-    }
-    
-    void onButton(const event::Button& e) override {
-        if (e.action == GLFW_PRESS && e.button == GLFW_MOUSE_BUTTON_LEFT) {
-            accumDelta = 0.0f;
-            e.consume(this);
-        }
-        ParamWidget::onButton(e);
-    }
-    
-    void onDragMove(const event::DragMove& e) override {
-        ParamQuantity* pq = getParamQuantity();
-        if (!pq) return;
-        
-        accumDelta += (e.mouseDelta.x - e.mouseDelta.y);
-        
-        float threshold = 10.0f;
-        
-        if (accumDelta >= threshold) {
-            float currentValue = pq->getValue();
-            float newValue = currentValue + 1.0f;
-            newValue = clamp(newValue, pq->getMinValue(), pq->getMaxValue());
-            pq->setValue(newValue);
-            accumDelta = 0.0f;
-        }
-        else if (accumDelta <= -threshold) {
-            float currentValue = pq->getValue();
-            float newValue = currentValue - 1.0f;
-            newValue = clamp(newValue, pq->getMinValue(), pq->getMaxValue());
-            pq->setValue(newValue);
-            accumDelta = 0.0f;
-        }
-    }
-    
-    void onDoubleClick(const event::DoubleClick& e) override {
-        ParamQuantity* pq = getParamQuantity();
-        if (!pq) return;
-        
-        pq->reset();
-        e.consume(this);
-    }
-};
-
 struct DivMultParamQuantity : ParamQuantity {
     std::string getDisplayValueString() override {
         int value = (int)std::round(getValue());
@@ -251,24 +20,7 @@ struct DivMultParamQuantity : ParamQuantity {
     }
 };
 
-std::vector<bool> generateEuclideanRhythm(int length, int fill, int shift) {
-    std::vector<bool> pattern(length, false);
-    if (fill == 0 || length == 0) return pattern;
-    if (fill > length) fill = length;
-
-    shift = shift % length;
-    if (shift < 0) shift += length;
-
-    for (int i = 0; i < fill; ++i) {
-        int index = (int)std::floor((float)i * length / fill);
-        pattern[index] = true;
-    }
-    
-    std::rotate(pattern.begin(), pattern.begin() + shift, pattern.end());
-    return pattern;
-}
-
-struct EuclideanRhythm : Module {
+struct EuclideanRhythm : MeteredModule {
     enum ParamId {
         MANUAL_RESET_PARAM,
         TRACK1_DIVMULT_PARAM,
@@ -339,8 +91,7 @@ struct EuclideanRhythm : Module {
     dsp::SchmittTrigger resetTrigger;
     dsp::SchmittTrigger manualResetTrigger;
     
-    float globalClockSeconds = 0.5f;
-    float secondsSinceLastClock = -1.0f;
+    ClockPeriod clockPeriod;
     
     dsp::PulseGenerator orRedPulse;
     dsp::PulseGenerator orGreenPulse;
@@ -350,30 +101,21 @@ struct EuclideanRhythm : Module {
         int divMultValue = 0;
         int division = 1;
         int multiplication = 1;
-        float dividedClockSeconds = 0.5f;
-        float multipliedClockSeconds = 0.5f;
-        float dividedProgressSeconds = 0.0f;
-        float gateSeconds = 0.0f;
-        int dividerCount = 0;
-        bool shouldStep = false;
-        bool prevMultipliedGate = false;
+        ClockDivMult clock;
         
         int currentStep = 0;
         int length = 16;
         int fill = 4;
         int shift = 0;
-        std::vector<bool> pattern;
+        uint64_t pattern = 0;
         bool gateState = false;
         bool cycleCompleted = false;
         dsp::PulseGenerator trigPulse;
 
         void reset() {
-            dividedProgressSeconds = 0.0f;
-            dividerCount = 0;
-            shouldStep = false;
-            prevMultipliedGate = false;
+            clock.reset();
             currentStep = 0;
-            pattern.clear();
+            pattern = 0;
             gateState = false;
             cycleCompleted = false;
         }
@@ -392,49 +134,13 @@ struct EuclideanRhythm : Module {
             }
         }
         
-        bool processClockDivMult(bool globalClock, float globalClockSeconds, float sampleTime) {
-            dividedClockSeconds = globalClockSeconds * (float)division;
-            multipliedClockSeconds = dividedClockSeconds / (float)multiplication;
-            gateSeconds = std::max(0.001f, multipliedClockSeconds * 0.5f);
-            
-            if (globalClock) {
-                if (dividerCount < 1) {
-                    dividedProgressSeconds = 0.0f;
-                } else {
-                    dividedProgressSeconds += sampleTime;
-                }
-                ++dividerCount;
-                if (dividerCount >= division) {
-                    dividerCount = 0;
-                }
-            } else {
-                dividedProgressSeconds += sampleTime;
-            }
-            
-            shouldStep = false;
-            if (dividedProgressSeconds < dividedClockSeconds) {
-                float multipliedProgressSeconds = dividedProgressSeconds / multipliedClockSeconds;
-                multipliedProgressSeconds -= (float)(int)multipliedProgressSeconds;
-                multipliedProgressSeconds *= multipliedClockSeconds;
-                
-                bool currentMultipliedGate = multipliedProgressSeconds <= gateSeconds;
-                
-                if (currentMultipliedGate && !prevMultipliedGate) {
-                    shouldStep = true;
-                }
-                prevMultipliedGate = currentMultipliedGate;
-            }
-            
-            return shouldStep;
-        }
-        
         void stepTrack() {
             cycleCompleted = false;
             currentStep = (currentStep + 1) % length;
             if (currentStep == 0) {
                 cycleCompleted = true;
             }
-            gateState = !pattern.empty() && pattern[currentStep];
+            gateState = euclideanStep(pattern, currentStep);
             if (gateState) {
                 trigPulse.trigger(0.01f);
             }
@@ -525,10 +231,10 @@ struct EuclideanRhythm : Module {
             paramQuantities[paramBase]->name = string::f("T%d Div/Mult", i+1);
             paramQuantities[paramBase]->snapEnabled = true;
             
-            configParam(paramBase + 1, 1.0f, 32.0f, 16.0f, string::f("T%d Length", i+1));
+            configParam(paramBase + 1, 1.0f, (float)EUCLIDEAN_MAX_LENGTH, 16.0f, string::f("T%d Length", i+1));
             getParamQuantity(paramBase + 1)->snapEnabled = true;
             configParam(paramBase + 2, 0.0f, 100.0f, 25.0f, string::f("T%d Fill", i+1), "%");
-            configParam(paramBase + 3, 0.0f, 31.0f, 0.0f, string::f("T%d Shift", i+1));
+            configParam(paramBase + 3, 0.0f, (float)EUCLIDEAN_MAX_LENGTH - 1.0f, 0.0f, string::f("T%d Shift", i+1));
             getParamQuantity(paramBase + 3)->snapEnabled = true;
             configParam(paramBase + 4, -1.0f, 1.0f, 0.0f, string::f("T%d Length CV", i+1));
             configParam(paramBase + 5, -1.0f, 1.0f, 0.0f, string::f("T%d Fill CV", i+1));
@@ -552,8 +258,7 @@ struct EuclideanRhythm : Module {
     }
 
     void onReset() override {
-        secondsSinceLastClock = -1.0f;
-        globalClockSeconds = 0.5f;
+        clockPeriod.reset();
         for (int i = 0; i < 3; ++i) {
             tracks[i].reset();
         }
@@ -563,6 +268,7 @@ struct EuclideanRhythm : Module {
     }
 
     void process(const ProcessArgs& args) override {
+        PerfMeter::Scope perfScope(perf, args.sampleRate);
         bool globalClockActive = inputs[GLOBAL_CLOCK_INPUT].isConnected();
         bool globalClockTriggered = false;
         bool globalResetTriggered = false;
@@ -584,17 +290,7 @@ struct EuclideanRhythm : Module {
             return;
         }
         
-        if (globalClockTriggered) {
-            if (secondsSinceLastClock > 0.0f) {
-                globalClockSeconds = secondsSinceLastClock;
-                globalClockSeconds = clamp(globalClockSeconds, 0.01f, 10.0f);
-            }
-            secondsSinceLastClock = 0.0f;
-        }
-        
-        if (secondsSinceLastClock >= 0.0f) {
-            secondsSinceLastClock += args.sampleTime;
-        }
+        int64_t clockPeriodSamples = clockPeriod.process(globalClockTriggered, args.sampleRate);
 
         for (int i = 0; i < 3; ++i) {
             TrackState& track = tracks[i];
@@ -608,7 +304,7 @@ struct EuclideanRhythm : Module {
                 float lengthCVAtten = params[TRACK1_LENGTH_CV_ATTEN_PARAM + i * 7].getValue();
                 lengthCV = inputs[TRACK1_LENGTH_CV_INPUT + i * 3].getVoltage() * lengthCVAtten;
             }
-            track.length = (int)std::round(clamp(lengthParam + lengthCV, 1.0f, 32.0f));
+            track.length = (int)std::round(clamp(lengthParam + lengthCV, 1.0f, (float)EUCLIDEAN_MAX_LENGTH));
 
             float fillParam = params[TRACK1_FILL_PARAM + i * 7].getValue();
             float fillCV = 0.0f;
@@ -627,11 +323,11 @@ struct EuclideanRhythm : Module {
             }
             track.shift = (int)std::round(clamp(shiftParam + shiftCV, 0.0f, (float)track.length - 1.0f));
 
-            track.pattern = generateEuclideanRhythm(track.length, track.fill, track.shift);
+            track.pattern = generateEuclideanPattern(track.length, track.fill, track.shift);
 
-            bool trackClockTrigger = track.processClockDivMult(globalClockTriggered, globalClockSeconds, args.sampleTime);
+            bool trackClockTrigger = track.clock.process(globalClockTriggered, clockPeriodSamples, track.division, track.multiplication);
 
-            if (trackClockTrigger && !track.pattern.empty() && globalClockActive) {
+            if (trackClockTrigger && globalClockActive) {
                 track.stepTrack();
             }
             
@@ -776,6 +472,15 @@ struct EuclideanRhythmWidget : ModuleWidget {
         addChild(new EnhancedTextLabel(Vec(mixX - 12, 337), Vec(25, 10), "OR", 7.f, nvgRGB(255, 133, 133), true));
         addOutput(createOutputCentered<PJ301MPort>(Vec(mixX, outputY), module, EuclideanRhythm::MASTER_TRIG_OUTPUT));
         addChild(createLightCentered<SmallLight<RedGreenBlueLight>>(Vec(mixX + 8, outputY + 17), module, EuclideanRhythm::OR_RED_LIGHT));
+
+        addChild(new PerfReadout(module, box.size.x));
+    }
+
+    void appendContextMenu(Menu* menu) override {
+        EuclideanRhythm* module = getModule<EuclideanRhythm>();
+        if (!module) return;
+
+        appendPerfMenu(menu, module);
     }
 };
 
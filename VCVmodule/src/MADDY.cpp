@@ -1,473 +1,18 @@
 #include "plugin.hpp"
 #include <vector>
 #include <algorithm>
+#include "cached.hpp"
+#include "divmult.hpp"
+#include "envelope.hpp"
+#include "euclidean.hpp"
+#include "fastmath.hpp"
+#include "perf.hpp"
+#include "widgets.hpp"
 
-struct MADDYEnhancedTextLabel : TransparentWidget {
-    std::string text;
-    float fontSize;
-    NVGcolor color;
-    bool bold;
-    
-    MADDYEnhancedTextLabel(Vec pos, Vec size, std::string text, float fontSize = 12.f, 
-                      NVGcolor color = nvgRGB(255, 255, 255), bool bold = true) {
-        box.pos = pos;
-        box.size = size;
-        this->text = text;
-        this->fontSize = fontSize;
-        this->color = color;
-        this->bold = bold;
-    }
-    
-    void draw(const DrawArgs &args) override {
-        nvgFontSize(args.vg, fontSize);
-        nvgFontFaceId(args.vg, APP->window->uiFont->handle);
-        nvgTextAlign(args.vg, NVG_ALIGN_CENTER | NVG_ALIGN_MIDDLE);
-        nvgFillColor(args.vg, color);
-        
-        if (bold) {
-            float offset = 0.3f;
-            nvgText(args.vg, box.size.x / 2.f - offset, box.size.y / 2.f, text.c_str(), NULL);
-            nvgText(args.vg, box.size.x / 2.f + offset, box.size.y / 2.f, text.c_str(), NULL);
-            nvgText(args.vg, box.size.x / 2.f, box.size.y / 2.f - offset, text.c_str(), NULL);
-            nvgText(args.vg, box.size.x / 2.f, box.size.y / 2.f + offset, text.c_str(), NULL);
-        }
-        nvgText(args.vg, box.size.x / 2.f, box.size.y / 2.f, text.c_str(), NULL);
-    }
-};
-
-struct MADDYStandardBlackKnob : ParamWidget {
-    bool isDragging = false;
-    
-    MADDYStandardBlackKnob() {
-        box.size = Vec(26, 26);
-    }
-    
-    float getDisplayAngle() {
-        ParamQuantity* pq = getParamQuantity();
-        if (!pq) return 0.0f;
-        float normalizedValue = pq->getScaledValue();
-        return rescale(normalizedValue, 0.0f, 1.0f, -0.75f * M_PI, 0.75f * M_PI);
-    }
-    
-    void draw(const DrawArgs& args) override {
-        float radius = box.size.x / 2.0f;
-        float angle = getDisplayAngle();
-        
-        nvgBeginPath(args.vg);
-        nvgCircle(args.vg, radius, radius, radius - 1);
-        nvgFillColor(args.vg, nvgRGB(30, 30, 30));
-        nvgFill(args.vg);
-        
-        nvgBeginPath(args.vg);
-        nvgCircle(args.vg, radius, radius, radius - 1);
-        nvgStrokeWidth(args.vg, 1.0f);
-        nvgStrokeColor(args.vg, nvgRGB(100, 100, 100));
-        nvgStroke(args.vg);
-        
-        nvgBeginPath(args.vg);
-        nvgCircle(args.vg, radius, radius, radius - 4);
-        nvgFillColor(args.vg, nvgRGB(50, 50, 50));
-        nvgFill(args.vg);
-        
-        float indicatorLength = radius - 8;
-        float lineX = radius + indicatorLength * std::sin(angle);
-        float lineY = radius - indicatorLength * std::cos(angle);
-        
-        nvgBeginPath(args.vg);
-        nvgMoveTo(args.vg, radius, radius);
-        nvgLineTo(args.vg, lineX, lineY);
-        nvgStrokeWidth(args.vg, 2.0f);
-        nvgStrokeColor(args.vg, nvgRGB(255, 255, 255));
-        nvgStroke(args.vg);
-        
-        nvgBeginPath(args.vg);
-        nvgCircle(args.vg, lineX, lineY, 2.0f);
-        nvgFillColor(args.vg, nvgRGB(255, 255, 255));
-        nvgFill(args.vg);
-    }
-    
-    void onButton(const event::Button& e) override {
-        if (e.action == GLFW_PRESS && e.button == GLFW_MOUSE_BUTTON_LEFT) {
-            isDragging = true;
-            e.consume(this);
-        }
-        else if (e.action == GLFW_RELEASE && e.button == GLFW_MOUSE_BUTTON_LEFT) {
-            isDragging = false;
-        }
-        ParamWidget::onButton(e);
-    }
-    
-    void onDragMove(const event::DragMove& e) override {
-        ParamQuantity* pq = getParamQuantity();
-        if (!isDragging || !pq) return;
-        
-        float sensitivity = 0.002f;
-        float deltaY = -e.mouseDelta.y;
-        float range = pq->getMaxValue() - pq->getMinValue();
-        float currentValue = pq->getValue();
-        float newValue = clamp(currentValue + deltaY * sensitivity * range, pq->getMinValue(), pq->getMaxValue());
-        pq->setValue(newValue);
-    }
-    
-    void onDoubleClick(const event::DoubleClick& e) override {
-        ParamQuantity* pq = getParamQuantity();
-        if (!pq) return;
-        pq->reset();
-        e.consume(this);
-    }
-};
-
-struct MADDYSnapKnob : ParamWidget {
-    float accumDelta = 0.0f;
-    
-    MADDYSnapKnob() {
-        box.size = Vec(26, 26);
-    }
-    
-    float getDisplayAngle() {
-        ParamQuantity* pq = getParamQuantity();
-        if (!pq) return 0.0f;
-        float normalizedValue = pq->getScaledValue();
-        return rescale(normalizedValue, 0.0f, 1.0f, -0.75f * M_PI, 0.75f * M_PI);
-    }
-    
-    void draw(const DrawArgs& args) override {
-        float radius = box.size.x / 2.0f;
-        float angle = getDisplayAngle();
-        
-        nvgBeginPath(args.vg);
-        nvgCircle(args.vg, radius, radius, radius - 1);
-        nvgFillColor(args.vg, nvgRGB(30, 30, 30));
-        nvgFill(args.vg);
-        
-        nvgBeginPath(args.vg);
-        nvgCircle(args.vg, radius, radius, radius - 1);
-        nvgStrokeWidth(args.vg, 1.0f);
-        nvgStrokeColor(args.vg, nvgRGB(100, 100, 100));
-        nvgStroke(args.vg);
-        
-        nvgBeginPath(args.vg);
-        nvgCircle(args.vg, radius, radius, radius - 4);
-        nvgFillColor(args.vg, nvgRGB(130, 130, 130));
-        nvgFill(args.vg);
-        
-        float indicatorLength = radius - 8;
-        float lineX = radius + indicatorLength * std::sin(angle);
-        float lineY = radius - indicatorLength * std::cos(angle);
-        
-        nvgBeginPath(args.vg);
-        nvgMoveTo(args.vg, radius, radius);
-        nvgLineTo(args.vg, lineX, lineY);
-        nvgStrokeWidth(args.vg, 2.0f);
-        nvgStrokeColor(args.vg, nvgRGB(255, 255, 255));
-        nvgStroke(args.vg);
-        
-        nvgBeginPath(args.vg);
-        nvgCircle(args.vg, lineX, lineY, 2.0f);
-        nvgFillColor(args.vg, nvgRGB(255, 255, 255));
-        nvgFill(args.vg);
-    }
-    
-    void onButton(const event::Button& e) override {
-        if (e.action == GLFW_PRESS && e.button == GLFW_MOUSE_BUTTON_LEFT) {
-            accumDelta = 0.0f;
-            e.consume(this);
-        }
-        ParamWidget::onButton(e);
-    }
-    
-    void onDragMove(const event::DragMove& e) override {
-        ParamQuantity* pq = getParamQuantity();
-        if (!pq) return;
-        
-        accumDelta += (e.mouseDelta.x - e.mouseDelta.y);
-        float threshold = 30.0f;
-        
-        if (accumDelta >= threshold) {
-            float currentValue = pq->getValue();
-            float newValue = clamp(currentValue + 1.0f, pq->getMinValue(), pq->getMaxValue());
-            pq->setValue(newValue);
-            accumDelta = 0.0f;
-        }
-        else if (accumDelta <= -threshold) {
-            float currentValue = pq->getValue();
-            float newValue = clamp(currentValue - 1.0f, pq->getMinValue(), pq->getMaxValue());
-            pq->setValue(newValue);
-            accumDelta = 0.0f;
-        }
-    }
-    
-    void onDoubleClick(const event::DoubleClick& e) override {
-        ParamQuantity* pq = getParamQuantity();
-        if (!pq) return;
-        pq->reset();
-        e.consume(this);
-    }
-};
-
-struct WhiteKnob : ParamWidget {
-    bool isDragging = false;
-    
-    WhiteKnob() {
-        box.size = Vec(30, 30);
-    }
-    
-    float getDisplayAngle() {
-        ParamQuantity* pq = getParamQuantity();
-        if (!pq) return 0.0f;
-        float normalizedValue = pq->getScaledValue();
-        return rescale(normalizedValue, 0.0f, 1.0f, -0.75f * M_PI, 0.75f * M_PI);
-    }
-    
-    void draw(const DrawArgs& args) override {
-        float radius = box.size.x / 2.0f;
-        float angle = getDisplayAngle();
-        
-        nvgBeginPath(args.vg);
-        nvgCircle(args.vg, radius, radius, radius - 1);
-        nvgFillColor(args.vg, nvgRGB(30, 30, 30));
-        nvgFill(args.vg);
-        
-        nvgBeginPath(args.vg);
-        nvgCircle(args.vg, radius, radius, radius - 1);
-        nvgStrokeWidth(args.vg, 1.0f);
-        nvgStrokeColor(args.vg, nvgRGB(100, 100, 100));
-        nvgStroke(args.vg);
-        
-        nvgBeginPath(args.vg);
-        nvgCircle(args.vg, radius, radius, radius - 4);
-        nvgFillColor(args.vg, nvgRGB(255, 255, 255));
-        nvgFill(args.vg);
-        
-        float indicatorLength = radius - 8;
-        float lineX = radius + indicatorLength * std::sin(angle);
-        float lineY = radius - indicatorLength * std::cos(angle);
-        
-        nvgBeginPath(args.vg);
-        nvgMoveTo(args.vg, radius, radius);
-        nvgLineTo(args.vg, lineX, lineY);
-        nvgStrokeWidth(args.vg, 2.0f);
-        nvgStrokeColor(args.vg, nvgRGB(255, 133, 133));
-        nvgStroke(args.vg);
-        
-        nvgBeginPath(args.vg);
-        nvgCircle(args.vg, lineX, lineY, 2.0f);
-        nvgFillColor(args.vg, nvgRGB(255, 133, 133));
-        nvgFill(args.vg);
-    }
-    
-    void onButton(const event::Button& e) override {
-        if (e.action == GLFW_PRESS && e.button == GLFW_MOUSE_BUTTON_LEFT) {
-            isDragging = true;
-            e.consume(this);
-        }
-        else if (e.action == GLFW_RELEASE && e.button == GLFW_MOUSE_BUTTON_LEFT) {
-            isDragging = false;
-        }
-        ParamWidget::onButton(e);
-    }
-    
-    void onDragMove(const event::DragMove& e) override {
-        ParamQuantity* pq = getParamQuantity();
-        if (!isDragging || !pq) return;
-        
-        float sensitivity = 0.002f;
-        float deltaY = -e.mouseDelta.y;
-        float range = pq->getMaxValue() - pq->getMinValue();
-        float currentValue = pq->getValue();
-        float newValue = clamp(currentValue + deltaY * sensitivity * range, pq->getMinValue(), pq->getMaxValue());
-        pq->setValue(newValue);
-    }
-    
-    void onDoubleClick(const event::DoubleClick& e) override {
-        ParamQuantity* pq = getParamQuantity();
-        if (!pq) return;
-        pq->reset();
-        e.consume(this);
-    }
-};
-
-struct SmallGrayKnob : ParamWidget {
-    bool isDragging = false;
-    
-    SmallGrayKnob() {
-        box.size = Vec(21, 21);
-    }
-    
-    float getDisplayAngle() {
-        ParamQuantity* pq = getParamQuantity();
-        if (!pq) return 0.0f;
-        float normalizedValue = pq->getScaledValue();
-        return rescale(normalizedValue, 0.0f, 1.0f, -0.75f * M_PI, 0.75f * M_PI);
-    }
-    
-    void draw(const DrawArgs& args) override {
-        float radius = box.size.x / 2.0f;
-        float angle = getDisplayAngle();
-        
-        nvgBeginPath(args.vg);
-        nvgCircle(args.vg, radius, radius, radius - 1);
-        nvgFillColor(args.vg, nvgRGB(30, 30, 30));
-        nvgFill(args.vg);
-        
-        nvgBeginPath(args.vg);
-        nvgCircle(args.vg, radius, radius, radius - 1);
-        nvgStrokeWidth(args.vg, 1.0f);
-        nvgStrokeColor(args.vg, nvgRGB(100, 100, 100));
-        nvgStroke(args.vg);
-        
-        nvgBeginPath(args.vg);
-        nvgCircle(args.vg, radius, radius, radius - 3);
-        nvgFillColor(args.vg, nvgRGB(180, 180, 180));
-        nvgFill(args.vg);
-        
-        float indicatorLength = radius - 6;
-        float lineX = radius + indicatorLength * std::sin(angle);
-        float lineY = radius - indicatorLength * std::cos(angle);
-        
-        nvgBeginPath(args.vg);
-        nvgMoveTo(args.vg, radius, radius);
-        nvgLineTo(args.vg, lineX, lineY);
-        nvgStrokeWidth(args.vg, 1.5f);
-        nvgStrokeColor(args.vg, nvgRGB(255, 255, 255));
-        nvgStroke(args.vg);
-        
-        nvgBeginPath(args.vg);
-        nvgCircle(args.vg, lineX, lineY, 1.5f);
-        nvgFillColor(args.vg, nvgRGB(255, 255, 255));
-        nvgFill(args.vg);
-    }
-    
-    void onButton(const event::Button& e) override {
-        if (e.action == GLFW_PRESS && e.button == GLFW_MOUSE_BUTTON_LEFT) {
-            isDragging = true;
-            e.consume(this);
-        }
-        else if (e.action == GLFW_RELEASE && e.button == GLFW_MOUSE_BUTTON_LEFT) {
-            isDragging = false;
-        }
-        ParamWidget::onButton(e);
-    }
-    
-    void onDragMove(const event::DragMove& e) override {
-        ParamQuantity* pq = getParamQuantity();
-        if (!isDragging || !pq) return;
-        
-        float sensitivity = 0.002f;
-        float deltaY = -e.mouseDelta.y;
-        float range = pq->getMaxValue() - pq->getMinValue();
-        float currentValue = pq->getValue();
-        float newValue = clamp(currentValue + deltaY * sensitivity * range, pq->getMinValue(), pq->getMaxValue());
-        pq->setValue(newValue);
-    }
-    
-    void onDoubleClick(const event::DoubleClick& e) override {
-        ParamQuantity* pq = getParamQuantity();
-        if (!pq) return;
-        pq->reset();
-        e.consume(this);
-    }
-};
-
-struct MediumGrayKnob : ParamWidget {
-    bool isDragging = false;
-    
-    MediumGrayKnob() {
-        box.size = Vec(26, 26);
-    }
-    
-    float getDisplayAngle() {
-        ParamQuantity* pq = getParamQuantity();
-        if (!pq) return 0.0f;
-        float normalizedValue = pq->getScaledValue();
-        return rescale(normalizedValue, 0.0f, 1.0f, -0.75f * M_PI, 0.75f * M_PI);
-    }
-    
-    void draw(const DrawArgs& args) override {
-        float radius = box.size.x / 2.0f;
-        float angle = getDisplayAngle();
-        
-        nvgBeginPath(args.vg);
-        nvgCircle(args.vg, radius, radius, radius - 1);
-        nvgFillColor(args.vg, nvgRGB(30, 30, 30));
-        nvgFill(args.vg);
-        
-        nvgBeginPath(args.vg);
-        nvgCircle(args.vg, radius, radius, radius - 1);
-        nvgStrokeWidth(args.vg, 1.0f);
-        nvgStrokeColor(args.vg, nvgRGB(100, 100, 100));
-        nvgStroke(args.vg);
-        
-        nvgBeginPath(args.vg);
-        nvgCircle(args.vg, radius, radius, radius - 4);
-        nvgFillColor(args.vg, nvgRGB(130, 130, 130));
-        nvgFill(args.vg);
-        
-        float indicatorLength = radius - 8;
-        float lineX = radius + indicatorLength * std::sin(angle);
-        float lineY = radius - indicatorLength * std::cos(angle);
-        
-        nvgBeginPath(args.vg);
-        nvgMoveTo(args.vg, radius, radius);
-        nvgLineTo(args.vg, lineX, lineY);
-        nvgStrokeWidth(args.vg, 2.0f);
-        nvgStrokeColor(args.vg, nvgRGB(255, 255, 255));
-        nvgStroke(args.vg);
-        
-        nvgBeginPath(args.vg);
-        nvgCircle(args.vg, lineX, lineY, 2.0f);
-        nvgFillColor(args.vg, nvgRGB(255, 255, 255));
-        nvgFill(args.vg);
-    }
-    
-    void onButton(const event::Button& e) override {
-        if (e.action == GLFW_PRESS && e.button == GLFW_MOUSE_BUTTON_LEFT) {
-            isDragging = true;
-            e.consume(this);
-        }
-        else if (e.action == GLFW_RELEASE && e.button == GLFW_MOUSE_BUTTON_LEFT) {
-            isDragging = false;
-        }
-        ParamWidget::onButton(e);
-    }
-    
-    void onDragMove(const event::DragMove& e) override {
-        ParamQuantity* pq = getParamQuantity();
-        if (!isDragging || !pq) return;
-        
-        float sensitivity = 0.008f;
-        float deltaY = -e.mouseDelta.y;
-        float range = pq->getMaxValue() - pq->getMinValue();
-        float currentValue = pq->getValue();
-        float newValue = clamp(currentValue + deltaY * sensitivity * range, pq->getMinValue(), pq->getMaxValue());
-        pq->setValue(newValue);
-    }
-    
-    void onDoubleClick(const event::DoubleClick& e) override {
-        ParamQuantity* pq = getParamQuantity();
-        if (!pq) return;
-        pq->reset();
-        e.consume(this);
-    }
-};
-
-struct WhiteBackgroundBox : Widget {
-    WhiteBackgroundBox(Vec pos, Vec size) {
-        box.pos = pos;
-        box.size = size;
-    }
-    
-    void draw(const DrawArgs &args) override {
-        nvgBeginPath(args.vg);
-        nvgRect(args.vg, 0, 0, box.size.x, box.size.y);
-        nvgFillColor(args.vg, nvgRGB(255, 255, 255));
-        nvgFill(args.vg);
-        
-        nvgStrokeWidth(args.vg, 1.0f);
-        nvgStrokeColor(args.vg, nvgRGBA(200, 200, 200, 255));
-        nvgStroke(args.vg);
-    }
-};
+typedef MadzineSnapKnob<26, GrayKnobLook, 30> MADDYSnapKnob;
+typedef MadzineKnob<30, WhiteKnobLook> WhiteKnob;
+typedef MadzineKnob<21, LightGrayKnobLook> SmallGrayKnob;
+typedef MadzineKnob<26, GrayKnobLook, 8> MediumGrayKnob;
 
 struct SectionBox : Widget {
     SectionBox(Vec pos, Vec size) {
@@ -553,21 +98,7 @@ struct DivMultParamQuantity : ParamQuantity {
     }
 };
 
-std::vector<bool> generateMADDYEuclideanRhythm(int length, int fill, int shift) {
-    std::vector<bool> pattern(length, false);
-    if (fill == 0 || length == 0) return pattern;
-    if (fill > length) fill = length;
-
-    for (int i = 0; i < fill; ++i) {
-        int index = (int)std::floor((float)i * length / fill);
-        pattern[index] = true;
-    }
-    
-    std::rotate(pattern.begin(), pattern.begin() + shift, pattern.end());
-    return pattern;
-}
-
-struct MADDY : Module {
+struct MADDY : MeteredModule {
     enum ParamId {
         FREQ_PARAM,
         SWING_PARAM,
@@ -619,19 +150,13 @@ struct MADDY : Module {
         int divMultValue = 0;
         int division = 1;
         int multiplication = 1;
-        float dividedClockSeconds = 0.5f;
-        float multipliedClockSeconds = 0.5f;
-        float dividedProgressSeconds = 0.0f;
-        float gateSeconds = 0.0f;
-        int dividerCount = 0;
-        bool shouldStep = false;
-        bool prevMultipliedGate = false;
+        ClockDivMult clock;
         
         int currentStep = 0;
         int length = 16;
         int fill = 4;
         int shift = 0;
-        std::vector<bool> pattern;
+        uint64_t pattern = 0;
         bool gateState = false;
         dsp::PulseGenerator trigPulse;
         dsp::PulseGenerator patternTrigPulse;
@@ -654,13 +179,10 @@ struct MADDY : Module {
         bool justTriggered = false;
 
         void reset() {
-            dividedProgressSeconds = 0.0f;
-            dividerCount = 0;
-            shouldStep = false;
-            prevMultipliedGate = false;
+            clock.reset();
             currentStep = 0;
             shift = 0;
-            pattern.clear();
+            pattern = 0;
             gateState = false;
             envelopePhase = IDLE;
             envelopeOutput = 0.0f;
@@ -671,24 +193,6 @@ struct MADDY : Module {
             justTriggered = false;
         }
         
-        float applyCurve(float x, float curvature) {
-            x = clamp(x, 0.0f, 1.0f);
-            
-            if (curvature == 0.0f) {
-                return x;
-            }
-            
-            float k = curvature;
-            float abs_x = std::abs(x);
-            float denominator = k - 2.0f * k * abs_x + 1.0f;
-            
-            if (std::abs(denominator) < 1e-6f) {
-                return x;
-            }
-            
-            return (x - k * x) / denominator;
-        }
-        
         void updateDivMult(int divMultParam) {
             divMultValue = divMultParam;
             if (divMultValue > 0) {
@@ -703,45 +207,9 @@ struct MADDY : Module {
             }
         }
         
-        bool processClockDivMult(bool globalClock, float globalClockSeconds, float sampleTime) {
-            dividedClockSeconds = globalClockSeconds * (float)division;
-            multipliedClockSeconds = dividedClockSeconds / (float)multiplication;
-            gateSeconds = std::max(0.001f, multipliedClockSeconds * 0.5f);
-            
-            if (globalClock) {
-                if (dividerCount < 1) {
-                    dividedProgressSeconds = 0.0f;
-                } else {
-                    dividedProgressSeconds += sampleTime;
-                }
-                ++dividerCount;
-                if (dividerCount >= division) {
-                    dividerCount = 0;
-                }
-            } else {
-                dividedProgressSeconds += sampleTime;
-            }
-            
-            shouldStep = false;
-            if (dividedProgressSeconds < dividedClockSeconds) {
-                float multipliedProgressSeconds = dividedProgressSeconds / multipliedClockSeconds;
-                multipliedProgressSeconds -= (float)(int)multipliedProgressSeconds;
-                multipliedProgressSeconds *= multipliedClockSeconds;
-                
-                bool currentMultipliedGate = multipliedProgressSeconds <= gateSeconds;
-                
-                if (currentMultipliedGate && !prevMultipliedGate) {
-                    shouldStep = true;
-                }
-                prevMultipliedGate = currentMultipliedGate;
-            }
-            
-            return shouldStep;
-        }
-        
         void stepTrack() {
                currentStep = (currentStep + 1) % length;
-               gateState = !pattern.empty() && pattern[currentStep];
+               gateState = euclideanStep(pattern, currentStep);
                if (gateState) {
                   trigPulse.trigger(0.001f);
                   envelopePhase = ATTACK;
@@ -861,7 +329,7 @@ struct MADDY : Module {
     };
     ChainedSequence chain12, chain23, chain123;
 
-    float globalClockSeconds = 0.5f;
+    int64_t clockPeriodSamples = 0;
     bool internalClockTriggered = false;
     bool patternClockTriggered = false;
     
@@ -870,16 +338,25 @@ struct MADDY : Module {
     dsp::PulseGenerator gateOutPulse;
     
     int currentStep = 0, sequenceLength = 16, stepToKnobMapping[64];
+    // Chaos draws from its own generator. The seed is saved with the patch
+    // and restored on reset, so the same variations play back.
+    random::Xoroshiro128Plus mappingRng;
+    uint64_t mappingSeed = 0;
+    // What the current table was built from.
+    float mappingDensity = -1.0f, mappingChaos = -1.0f;
+    int mappingStyle = -1;
+    int remapsStat;
     float previousVoltage = -999.0f;
     int modeValue = 1;
     int clockSourceValue = 0;
 
     MADDY() {
         config(PARAMS_LEN, INPUTS_LEN, OUTPUTS_LEN, LIGHTS_LEN);
+        remapsStat = perf.addStat("remaps/s", PerfMeter::RATE);
         
         configParam(FREQ_PARAM, -3.0f, 7.0f, 1.0f, "Frequency", " Hz", 2.0f, 1.0f);
         configParam(SWING_PARAM, 0.0f, 1.0f, 0.0f, "Swing", "°", 0.0f, -90.0f, 180.0f);
-        configParam(LENGTH_PARAM, 1.0f, 32.0f, 16.0f, "Length");
+        configParam(LENGTH_PARAM, 1.0f, (float)EUCLIDEAN_MAX_LENGTH, 16.0f, "Length");
         getParamQuantity(LENGTH_PARAM)->snapEnabled = true;
         configParam(DECAY_PARAM, 0.0f, 1.0f, 0.3f, "Decay");
         
@@ -941,12 +418,39 @@ struct MADDY : Module {
         chain23.trackIndices = {1, 2};
         chain123.trackIndices = {0, 1, 0, 2};
         
+        mappingSeed = random::u64();
+        seedMapping();
         generateMapping();
     }
 
+    void seedMapping() {
+        mappingRng.seed(mappingSeed, 0x9e3779b97f4a7c15ull);
+    }
+
+    float chaosUniform() {
+        return (mappingRng() >> 40) / 16777216.f;
+    }
+
+    uint32_t chaosU32() {
+        return (uint32_t) (mappingRng() >> 32);
+    }
+
+    // Clock edges only rebuild the table if density, chaos or style moved
+    // since it was built, or chaos is up and re-rolls it every step.
+    void updateMapping() {
+        float density = params[DENSITY_PARAM].getValue();
+        float chaos = params[CHAOS_PARAM].getValue();
+        if (chaos > 0.0f || density != mappingDensity || chaos != mappingChaos || modeValue != mappingStyle)
+            generateMapping();
+    }
+
     void generateMapping() {
+        perf.add(remapsStat, 1.0f);
         float density = params[DENSITY_PARAM].getValue();
         float chaos = params[CHAOS_PARAM].getValue();
+        mappingDensity = density;
+        mappingChaos = chaos;
+        mappingStyle = modeValue;
         
         if (density < 0.2f) {
             sequenceLength = 8 + (int)(density * 20);
@@ -961,7 +465,7 @@ struct MADDY : Module {
         
         if (chaos > 0.0f) {
             float chaosRange = chaos * sequenceLength * 0.5f;
-            float randomOffset = (random::uniform() - 0.5f) * 2.0f * chaosRange;
+            float randomOffset = (chaosUniform() - 0.5f) * 2.0f * chaosRange;
             sequenceLength += (int)randomOffset;
             sequenceLength = clamp(sequenceLength, 4, 64);
         }
@@ -995,8 +499,8 @@ struct MADDY : Module {
         if (chaos > 0.3f) {
             int chaosSteps = (int)(chaos * sequenceLength * 0.3f);
             for (int i = 0; i < chaosSteps; i++) {
-                int randomStep = random::u32() % sequenceLength;
-                stepToKnobMapping[randomStep] = random::u32() % 5;
+                int randomStep = chaosU32() % sequenceLength;
+                stepToKnobMapping[randomStep] = chaosU32() % 5;
             }
         }
     }
@@ -1005,7 +509,7 @@ struct MADDY : Module {
         phase = 0.0f;
         swingPhase = 0.0f;
         isSwingBeat = false;
-        globalClockSeconds = 0.5f;
+        clockPeriodSamples = 0;
         for (int i = 0; i < 3; ++i) {
             tracks[i].reset();
         }
@@ -1014,12 +518,14 @@ struct MADDY : Module {
         chain123.reset();
         
         currentStep = 0;
+        seedMapping();
         generateMapping();
         previousVoltage = -999.0f;
     }
 
 json_t* dataToJson() override {
         json_t* rootJ = json_object();
+        json_object_set_new(rootJ, "mappingSeed", json_integer((long long) mappingSeed));
         json_object_set_new(rootJ, "modeValue", json_integer(modeValue));
         json_object_set_new(rootJ, "clockSourceValue", json_integer(clockSourceValue));
         
@@ -1041,6 +547,12 @@ json_t* dataToJson() override {
     }
 
     void dataFromJson(json_t* rootJ) override {
+        json_t* seedJ = json_object_get(rootJ, "mappingSeed");
+        if (seedJ) {
+            mappingSeed = (uint64_t) json_integer_value(seedJ);
+            seedMapping();
+        }
+        
    	 json_t* modeJ = json_object_get(rootJ, "modeValue");
 	    if (modeJ) {
 	        modeValue = json_integer_value(modeJ);
@@ -1075,8 +587,9 @@ json_t* dataToJson() override {
 	}
 
     void process(const ProcessArgs& args) override {
+        PerfMeter::Scope perfScope(perf, args.sampleRate);
         float freqParam = params[FREQ_PARAM].getValue();
-        float freq = std::pow(2.0f, freqParam) * 1.0f;
+        float freq = fastExp2(freqParam) * 1.0f;
         
         float swingParam = params[SWING_PARAM].getValue();
         float swing = clamp(swingParam, 0.0f, 1.0f);
@@ -1101,7 +614,7 @@ json_t* dataToJson() override {
             phase -= phaseThreshold;
             clockPulse.trigger(0.001f);
             internalClockTriggered = true;
-            globalClockSeconds = phaseThreshold / freq;
+            clockPeriodSamples = (int64_t)std::round(phaseThreshold / freq * args.sampleRate);
             isSwingBeat = !isSwingBeat;
         }
         
@@ -1109,7 +622,7 @@ json_t* dataToJson() override {
         outputs[CLK_OUTPUT].setVoltage(clockOutput);
 
         int globalLength = (int)std::round(params[LENGTH_PARAM].getValue());
-        globalLength = clamp(globalLength, 1, 32);
+        globalLength = clamp(globalLength, 1, EUCLIDEAN_MAX_LENGTH);
         
         float decayParam = params[DECAY_PARAM].getValue();
 
@@ -1125,11 +638,11 @@ json_t* dataToJson() override {
             float fillPercentage = clamp(fillParam, 0.0f, 100.0f);
             track.fill = (int)std::round((fillPercentage / 100.0f) * track.length);
 
-            track.pattern = generateMADDYEuclideanRhythm(track.length, track.fill, track.shift);
+            track.pattern = generateEuclideanPattern(track.length, track.fill, track.shift);
 
-            bool trackClockTrigger = track.processClockDivMult(internalClockTriggered, globalClockSeconds, args.sampleTime);
+            bool trackClockTrigger = track.clock.process(internalClockTriggered, clockPeriodSamples, track.division, track.multiplication);
 
-            if (trackClockTrigger && !track.pattern.empty()) {
+            if (trackClockTrigger) {
                 track.stepTrack();
             }
             
@@ -1225,7 +738,7 @@ json_t* dataToJson() override {
         
         if (patternClockTriggered) {
             currentStep = (currentStep + 1) % sequenceLength;
-            generateMapping();
+            updateMapping();
             
             int newActiveKnob = stepToKnobMapping[currentStep];
             float newVoltage = params[K1_PARAM + newActiveKnob].getValue();
@@ -1240,12 +753,13 @@ json_t* dataToJson() override {
     }
 };
 
-struct DynamicTextLabel : TransparentWidget {
+struct DynamicTextLabel : CachedTransparentWidget {
     Module* module;
     int paramId;
     std::vector<std::string> textOptions;
     float fontSize;
     NVGcolor color;
+    math::Rect textBounds;
     
     DynamicTextLabel(Vec pos, Vec size, Module* module, int paramId, 
                      std::vector<std::string> options, float fontSize = 8.f, 
@@ -1259,7 +773,16 @@ struct DynamicTextLabel : TransparentWidget {
         this->color = color;
     }
     
-    void draw(const DrawArgs &args) override {
+    float cacheKey() override {
+        MADDY* maddyModule = dynamic_cast<MADDY*>(module);
+        return maddyModule ? maddyModule->clockSourceValue : -1.f;
+    }
+    
+    math::Rect cacheBounds() override {
+        return box.zeroPos().expand(textBounds);
+    }
+    
+    void drawCached(const DrawArgs &args) override {
         if (!module) return;
         
         MADDY* maddyModule = dynamic_cast<MADDY*>(module);
@@ -1272,15 +795,8 @@ struct DynamicTextLabel : TransparentWidget {
         
         nvgFontSize(args.vg, fontSize);
         nvgFontFaceId(args.vg, APP->window->uiFont->handle);
-        nvgTextAlign(args.vg, NVG_ALIGN_CENTER | NVG_ALIGN_MIDDLE);
         nvgFillColor(args.vg, color);
-        
-        float offset = 0.3f;
-        nvgText(args.vg, box.size.x / 2.f - offset, box.size.y / 2.f, currentText.c_str(), NULL);
-        nvgText(args.vg, box.size.x / 2.f + offset, box.size.y / 2.f, currentText.c_str(), NULL);
-        nvgText(args.vg, box.size.x / 2.f, box.size.y / 2.f - offset, currentText.c_str(), NULL);
-        nvgText(args.vg, box.size.x / 2.f, box.size.y / 2.f + offset, currentText.c_str(), NULL);
-        nvgText(args.vg, box.size.x / 2.f, box.size.y / 2.f, currentText.c_str(), NULL);
+        textBounds = drawLabelText(args.vg, box.size, currentText, true);
     }
 };
 
@@ -1331,25 +847,25 @@ struct MADDYWidget : ModuleWidget {
         
         box.size = Vec(8 * RACK_GRID_WIDTH, RACK_GRID_HEIGHT);
         
-        addChild(new MADDYEnhancedTextLabel(Vec(0, 1), Vec(box.size.x, 20), "M A D D Y", 12.f, nvgRGB(255, 200, 0), true));
-        addChild(new MADDYEnhancedTextLabel(Vec(0, 13), Vec(box.size.x, 20), "MADZINE", 10.f, nvgRGB(255, 200, 0), false));
+        addChild(new EnhancedTextLabel(Vec(0, 1), Vec(box.size.x, 20), "M A D D Y", 12.f, nvgRGB(255, 200, 0), true));
+        addChild(new EnhancedTextLabel(Vec(0, 13), Vec(box.size.x, 20), "MADZINE", 10.f, nvgRGB(255, 200, 0), false));
         
-        addChild(new MADDYEnhancedTextLabel(Vec(48, 28), Vec(25, 15), "RST", 7.f, nvgRGB(255, 255, 255), true));
+        addChild(new EnhancedTextLabel(Vec(48, 28), Vec(25, 15), "RST", 7.f, nvgRGB(255, 255, 255), true));
         addInput(createInputCentered<PJ301MPort>(Vec(60, 52), module, MADDY::RESET_INPUT));
         
-        addChild(new MADDYEnhancedTextLabel(Vec(86, 28), Vec(25, 15), "FREQ", 7.f, nvgRGB(255, 255, 255), true));
+        addChild(new EnhancedTextLabel(Vec(86, 28), Vec(25, 15), "FREQ", 7.f, nvgRGB(255, 255, 255), true));
         addParam(createParamCentered<SmallGrayKnob>(Vec(98, 52), module, MADDY::FREQ_PARAM));
         
-        addChild(new MADDYEnhancedTextLabel(Vec(48, 61), Vec(25, 15), "SWING", 7.f, nvgRGB(255, 255, 255), true));
+        addChild(new EnhancedTextLabel(Vec(48, 61), Vec(25, 15), "SWING", 7.f, nvgRGB(255, 255, 255), true));
         addParam(createParamCentered<SmallGrayKnob>(Vec(60, 85), module, MADDY::SWING_PARAM));
         
-        addChild(new MADDYEnhancedTextLabel(Vec(86, 61), Vec(25, 15), "CLK", 7.f, nvgRGB(255, 255, 255), true));
+        addChild(new EnhancedTextLabel(Vec(86, 61), Vec(25, 15), "CLK", 7.f, nvgRGB(255, 255, 255), true));
         addOutput(createOutputCentered<PJ301MPort>(Vec(98, 85), module, MADDY::CLK_OUTPUT));
         
-        addChild(new MADDYEnhancedTextLabel(Vec(8, 28), Vec(25, 15), "LEN", 7.f, nvgRGB(255, 255, 255), true));
+        addChild(new EnhancedTextLabel(Vec(8, 28), Vec(25, 15), "LEN", 7.f, nvgRGB(255, 255, 255), true));
         addParam(createParamCentered<MediumGrayKnob>(Vec(20, 52), module, MADDY::LENGTH_PARAM));
         
-        addChild(new MADDYEnhancedTextLabel(Vec(8, 61), Vec(25, 15), "DECAY", 6.f, nvgRGB(255, 255, 255), true));
+        addChild(new EnhancedTextLabel(Vec(8, 61), Vec(25, 15), "DECAY", 6.f, nvgRGB(255, 255, 255), true));
         addParam(createParamCentered<MediumGrayKnob>(Vec(20, 85), module, MADDY::DECAY_PARAM));
         
         addChild(new VerticalLine(Vec(39, 55), Vec(1, 242)));
@@ -1360,39 +876,39 @@ struct MADDYWidget : ModuleWidget {
         for (int i = 0; i < 3; ++i) {
             float y = trackY[i];
             
-            addChild(new MADDYEnhancedTextLabel(Vec(8, y - 10), Vec(25, 10), string::f("T%d", i+1), 7.f, nvgRGB(255, 200, 100), true));
+            addChild(new EnhancedTextLabel(Vec(8, y - 10), Vec(25, 10), string::f("T%d", i+1), 7.f, nvgRGB(255, 200, 100), true));
             
-            addChild(new MADDYEnhancedTextLabel(Vec(8, y), Vec(25, 10), "FILL", 6.f, nvgRGB(255, 255, 255), true));
+            addChild(new EnhancedTextLabel(Vec(8, y), Vec(25, 10), "FILL", 6.f, nvgRGB(255, 255, 255), true));
             addParam(createParamCentered<MediumGrayKnob>(Vec(20, y + 20), module, MADDY::TRACK1_FILL_PARAM + i * 2));
             
-            addChild(new MADDYEnhancedTextLabel(Vec(8, y + 33), Vec(25, 10), "D/M", 6.f, nvgRGB(255, 255, 255), true));
+            addChild(new EnhancedTextLabel(Vec(8, y + 33), Vec(25, 10), "D/M", 6.f, nvgRGB(255, 255, 255), true));
             addParam(createParamCentered<MADDYSnapKnob>(Vec(20, y + 53), module, MADDY::TRACK1_DIVMULT_PARAM + i * 2));
         }
         
         float cvY[5] = {127, 172, 217, 262, 307};
         for (int i = 0; i < 5; ++i) {
-            addChild(new MADDYEnhancedTextLabel(Vec(40, cvY[i] - 30), Vec(40, 10), string::f("Step %d", i + 1), 7.f, nvgRGB(255, 255, 255), true));
-            addChild(new MADDYEnhancedTextLabel(Vec(48, cvY[i] - 15), Vec(25, 10), std::to_string(i + 1), 7.f, nvgRGB(255, 255, 255), true));
+            addChild(new EnhancedTextLabel(Vec(40, cvY[i] - 30), Vec(40, 10), string::f("Step %d", i + 1), 7.f, nvgRGB(255, 255, 255), true));
+            addChild(new EnhancedTextLabel(Vec(48, cvY[i] - 15), Vec(25, 10), std::to_string(i + 1), 7.f, nvgRGB(255, 255, 255), true));
             addParam(createParamCentered<WhiteKnob>(Vec(60, cvY[i] - 5), module, MADDY::K1_PARAM + i));
         }
         
-        addChild(new MADDYEnhancedTextLabel(Vec(86, 97), Vec(25, 10), "MODE", 7.f, nvgRGB(255, 255, 255), true));
+        addChild(new EnhancedTextLabel(Vec(86, 97), Vec(25, 10), "MODE", 7.f, nvgRGB(255, 255, 255), true));
         addChild(createLightCentered<MediumLight<RedGreenBlueLight>>(Vec(98, 116), module, MADDY::MODE_LIGHT_RED));
         addParam(createParamCentered<VCVButton>(Vec(98, 116), module, MADDY::MODE_PARAM));
         
-        addChild(new MADDYEnhancedTextLabel(Vec(86, 130), Vec(25, 10), "DENSITY", 7.f, nvgRGB(255, 255, 255), true));
+        addChild(new EnhancedTextLabel(Vec(86, 130), Vec(25, 10), "DENSITY", 7.f, nvgRGB(255, 255, 255), true));
         addParam(createParamCentered<WhiteKnob>(Vec(98, 154), module, MADDY::DENSITY_PARAM));
         
-        addChild(new MADDYEnhancedTextLabel(Vec(86, 170), Vec(25, 10), "CHAOS", 7.f, nvgRGB(255, 255, 255), true));
+        addChild(new EnhancedTextLabel(Vec(86, 170), Vec(25, 10), "CHAOS", 7.f, nvgRGB(255, 255, 255), true));
         addParam(createParamCentered<WhiteKnob>(Vec(98, 194), module, MADDY::CHAOS_PARAM));
         
-        addChild(new MADDYEnhancedTextLabel(Vec(86, 210), Vec(25, 10), "CV OUT", 7.f, nvgRGB(255, 255, 255), true));
+        addChild(new EnhancedTextLabel(Vec(86, 210), Vec(25, 10), "CV OUT", 7.f, nvgRGB(255, 255, 255), true));
         addOutput(createOutputCentered<PJ301MPort>(Vec(98, 234), module, MADDY::CV_OUTPUT));
         
-        addChild(new MADDYEnhancedTextLabel(Vec(86, 250), Vec(25, 10), "TRIG OUT", 7.f, nvgRGB(255, 255, 255), true));
+        addChild(new EnhancedTextLabel(Vec(86, 250), Vec(25, 10), "TRIG OUT", 7.f, nvgRGB(255, 255, 255), true));
         addOutput(createOutputCentered<PJ301MPort>(Vec(98, 274), module, MADDY::TRIG_OUTPUT));
         
-        addChild(new MADDYEnhancedTextLabel(Vec(86, 290), Vec(25, 10), "CLK SRC", 6.f, nvgRGB(255, 255, 255), true));
+        addChild(new EnhancedTextLabel(Vec(86, 290), Vec(25, 10), "CLK SRC", 6.f, nvgRGB(255, 255, 255), true));
         addChild(createLightCentered<MediumLight<RedGreenBlueLight>>(Vec(98, 308), module, MADDY::CLOCK_SOURCE_LIGHT_RED));
         addParam(createParamCentered<VCVButton>(Vec(98, 308), module, MADDY::CLOCK_SOURCE_PARAM));
         
@@ -1401,23 +917,23 @@ struct MADDYWidget : ModuleWidget {
         
         addChild(new WhiteBackgroundBox(Vec(0, 330), Vec(box.size.x, 50)));
         
-        addChild(new MADDYEnhancedTextLabel(Vec(-2, 337), Vec(20, 15), "T1", 6.f, nvgRGB(255, 133, 133), true));
+        addChild(new EnhancedTextLabel(Vec(-2, 337), Vec(20, 15), "T1", 6.f, nvgRGB(255, 133, 133), true));
         addOutput(createOutputCentered<PJ301MPort>(Vec(24, 343), module, MADDY::TRACK1_OUTPUT));
         
-        addChild(new MADDYEnhancedTextLabel(Vec(-2, 362), Vec(20, 15), "12", 6.f, nvgRGB(255, 133, 133), true));
+        addChild(new EnhancedTextLabel(Vec(-2, 362), Vec(20, 15), "12", 6.f, nvgRGB(255, 133, 133), true));
         addOutput(createOutputCentered<PJ301MPort>(Vec(24, 368), module, MADDY::CHAIN_12_OUTPUT));
         
-        addChild(new MADDYEnhancedTextLabel(Vec(38, 337), Vec(20, 15), "T2", 6.f, nvgRGB(255, 133, 133), true));
+        addChild(new EnhancedTextLabel(Vec(38, 337), Vec(20, 15), "T2", 6.f, nvgRGB(255, 133, 133), true));
         addOutput(createOutputCentered<PJ301MPort>(Vec(64, 343), module, MADDY::TRACK2_OUTPUT));
         
-        addChild(new MADDYEnhancedTextLabel(Vec(38, 362), Vec(20, 15), "23", 6.f, nvgRGB(255, 133, 133), true));
+        addChild(new EnhancedTextLabel(Vec(38, 362), Vec(20, 15), "23", 6.f, nvgRGB(255, 133, 133), true));
         addOutput(createOutputCentered<PJ301MPort>(Vec(64, 368), module, MADDY::CHAIN_23_OUTPUT));
         
-        addChild(new MADDYEnhancedTextLabel(Vec(75, 337), Vec(20, 15), "T3", 6.f, nvgRGB(255, 133, 133), true));
+        addChild(new EnhancedTextLabel(Vec(75, 337), Vec(20, 15), "T3", 6.f, nvgRGB(255, 133, 133), true));
         addOutput(createOutputCentered<PJ301MPort>(Vec(102, 343), module, MADDY::TRACK3_OUTPUT));
         
-        addChild(new MADDYEnhancedTextLabel(Vec(75, 365), Vec(20, 6), "12", 6.f, nvgRGB(255, 133, 133), true));
-        addChild(new MADDYEnhancedTextLabel(Vec(75, 371), Vec(20, 6), "13", 6.f, nvgRGB(255, 133, 133), true));
+        addChild(new EnhancedTextLabel(Vec(75, 365), Vec(20, 6), "12", 6.f, nvgRGB(255, 133, 133), true));
+        addChild(new EnhancedTextLabel(Vec(75, 371), Vec(20, 6), "13", 6.f, nvgRGB(255, 133, 133), true));
         addOutput(createOutputCentered<PJ301MPort>(Vec(102, 368), module, MADDY::CHAIN_123_OUTPUT));
         
         if (module) {
@@ -1443,6 +959,8 @@ struct MADDYWidget : ModuleWidget {
             clockSourceQuantity->snapEnabled = true;
             module->paramQuantities[MADDY::CLOCK_SOURCE_PARAM] = clockSourceQuantity;
           }
+
+        addChild(new PerfReadout(module, box.size.x));
     }
 
     struct AttackTimeItem : ui::MenuItem {
@@ -1587,6 +1105,8 @@ struct MADDYWidget : ModuleWidget {
             
             menu->addChild(new TrackShiftMenu(module, trackId));
         }
+
+        appendPerfMenu(menu, module);
     }
 }; 
 
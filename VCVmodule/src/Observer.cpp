@@ -1,6 +1,14 @@
 #include "plugin.hpp"
+#include <ctime>
+#include "cached.hpp"
+#include "capture.hpp"
+#include "minmax.hpp"
+#include "perf.hpp"
+#include "scope.hpp"
+#include "spectrum.hpp"
+#include "widgets.hpp"
 
-struct Observer : Module {
+struct Observer : ScopeModule {
     enum ParamIds {
         TIME_PARAM,
         TRIG_PARAM,
@@ -25,22 +33,64 @@ struct Observer : Module {
         NUM_LIGHTS
     };
 
-    struct ScopePoint {
-        float min = INFINITY;
-        float max = -INFINITY;
-    };
+    static const int SCOPE_BUFFER_SIZE = ScopeFrame::POINTS;
+    static constexpr float SCOPE_PUBLISH_RATE = 60.f;
+    static const int MAX_CHANNELS = ScopeFrame::MAX_CHANNELS;
+    static const int MAX_SLOTS = 8 * MAX_CHANNELS;
 
-    static constexpr int SCOPE_BUFFER_SIZE = 256; // Same as VCV Scope
-    
-    ScopePoint scopeBuffer[8][SCOPE_BUFFER_SIZE];
-    ScopePoint currentPoint[8];
-    int bufferIndex = 0;
-    int frameIndex = 0;
+    // Every channel of every input is kept in a min/max pyramid, and the
+    // sweep on screen is read back from it: point j of a sweep starting at
+    // sample sweepStart covers pointSamples samples, taken from the pyramid
+    // level whose blocks fit that width. Changing the time base only
+    // re-reads the history, so the current sweep redraws at the new scale
+    // straight away.
+    //
+    // The channels of all inputs are packed back to back into slots, four to
+    // a float_4 group, so eight mono inputs cost two groups and the work
+    // grows with the total channel count. When the channel counts change the
+    // packing moves, and history from before layoutStart is not used.
+    //
+    // The pyramid and the sweep live in the ScopeStorage, sized for the
+    // slots patched so far. While a new layout waits for bigger storage,
+    // scopeFits is false and nothing is recorded.
+    int64_t sweepStart = 0;
+    int pointSamples = 1;
+    int renderedPoints = 0;
+    int trackChannels[8] = {};
+    const float* slotSource[MAX_SLOTS] = {};
+    bool groupContiguous[MAX_SLOTS / 4] = {};
+    int slots = 0;
+    int64_t layoutStart = 0;
+    bool scopeFits = true;
+
+    // The rendered sweep goes out to the display through the storage's
+    // frames at most SCOPE_PUBLISH_RATE times a second and whenever a sweep
+    // completes.
+    int samplesSincePublish = 0;
     
     dsp::SchmittTrigger triggers[16];
 
-    Observer() {
+    // Disk capture: every track, one WAV channel per poly channel it had
+    // when the capture started (unpatched tracks get one silent channel).
+    DiskCapture capture;
+    std::string capturePath;
+
+    // Spectrum view: process() only feeds the tap while it is shown; the
+    // display does the FFTs. The display also creates the tap, the first time
+    // the view is on.
+    bool spectrumMode = false;
+    std::atomic<SpectrumTap*> spectrumTap;
+
+    // Poly inputs: all channels drawn over each other, or each in its own
+    // strip of the lane.
+    bool stackChannels = false;
+
+    int spectrumStat, captureStat;
+
+    Observer() : spectrumTap(NULL) {
         config(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS);
+        spectrumStat = perf.addStat("spectrum %", PerfMeter::MEAN);
+        captureStat = perf.addStat("capture %", PerfMeter::MEAN);
         
         // Time parameter (same as VCV Scope and QQ)
         const float maxTime = -std::log2(5e1f);
@@ -63,12 +113,34 @@ struct Observer : Module {
         configInput(TRACK8_INPUT, "Track 8");
     }
 
+    ~Observer() {
+        delete spectrumTap.load();
+    }
+
+    // Audio thread.
+    ScopeStorage& storage() {
+        return *scope.load(std::memory_order_relaxed);
+    }
+
     void process(const ProcessArgs& args) override {
+        PerfMeter::Scope perfScope(perf, args.sampleRate);
+        if (takeScope()) {
+            updateLayout();
+        }
+        MinMaxPyramid& history = storage().history;
         bool trig = !params[TRIG_PARAM].getValue();
         lights[TRIG_LIGHT].setBrightness(trig);
 
+        // Compute time
+        float deltaTime = dsp::exp2_taylor5(-params[TIME_PARAM].getValue()) / SCOPE_BUFFER_SIZE;
+        int frameCount = (int) std::ceil(deltaTime * args.sampleRate);
+        if (frameCount != pointSamples) {
+            pointSamples = frameCount;
+            renderedPoints = 0;
+        }
+
         // Detect trigger if no longer recording (100% copy from VCV Scope)
-        if (bufferIndex >= SCOPE_BUFFER_SIZE) {
+        if (history.written - sweepStart >= (int64_t) SCOPE_BUFFER_SIZE * pointSamples) {
             bool triggered = false;
 
             // Trigger immediately if trigger detection is disabled
@@ -95,73 +167,198 @@ struct Observer : Module {
                 for (int c = 0; c < 16; c++) {
                     triggers[c].reset();
                 }
-                bufferIndex = 0;
-                frameIndex = 0;
+                sweepStart = history.written;
+                renderedPoints = 0;
             }
         }
 
-        // Add point to buffer if recording (100% copy from VCV Scope logic)
-        if (bufferIndex < SCOPE_BUFFER_SIZE) {
-            // Compute time
-            float deltaTime = dsp::exp2_taylor5(-params[TIME_PARAM].getValue()) / SCOPE_BUFFER_SIZE;
-            int frameCount = (int) std::ceil(deltaTime * args.sampleRate);
+        // Get input, every channel (an unpatched input shows as one channel at 0 V)
+        bool layoutChanged = false;
+        for (int i = 0; i < 8; i++) {
+            int channels = std::max(1, inputs[TRACK1_INPUT + i].getChannels());
+            if (channels != trackChannels[i]) {
+                trackChannels[i] = channels;
+                layoutChanged = true;
+            }
+        }
+        if (layoutChanged) {
+            updateLayout();
+        }
+        if (scopeFits) {
+            recordScope(args);
+        }
+        SpectrumTap* tap = spectrumMode ? spectrumTap.load(std::memory_order_acquire) : NULL;
+        if (tap) {
+            float first[8];
+            for (int i = 0; i < 8; i++) {
+                first[i] = inputs[TRACK1_INPUT + i].getVoltage();
+            }
+            tap->push(first);
+            perf.add(spectrumStat, 100.0f);
+        }
 
-            // Get input
+        if (capture.isActive()) {
+            perf.add(captureStat, 100.0f);
+            float frame[DiskCapture::MAX_CHANNELS];
+            int n = 0;
             for (int i = 0; i < 8; i++) {
-                float x = inputs[TRACK1_INPUT + i].getVoltage();
-                currentPoint[i].min = std::min(currentPoint[i].min, x);
-                currentPoint[i].max = std::max(currentPoint[i].max, x);
+                int channels = inputs[TRACK1_INPUT + i].getChannels();
+                for (int c = 0; c < capture.getTrackChannels(i); c++) {
+                    frame[n++] = c < channels ? inputs[TRACK1_INPUT + i].getVoltage(c) : 0.f;
+                }
             }
+            capture.push(frame);
+        }
+    }
 
-            if (++frameIndex >= frameCount) {
-                frameIndex = 0;
-                // Push current point
-                for (int i = 0; i < 8; i++) {
-                    scopeBuffer[i][bufferIndex] = currentPoint[i];
+    void recordScope(const ProcessArgs& args) {
+        MinMaxPyramid& history = storage().history;
+        // Each group is read straight from the ports: one load when its four
+        // channels are consecutive in one input, else gathered lane by lane.
+        simd::float_4 x[MAX_SLOTS / 4];
+        for (int g = 0; g < history.getGroups(); g++) {
+            const float* const* source = slotSource + 4 * g;
+            if (groupContiguous[g])
+                x[g] = simd::float_4::load(source[0]);
+            else
+                x[g] = simd::float_4(*source[0], *source[1], *source[2], *source[3]);
+        }
+        history.push(x);
+
+        samplesSincePublish++;
+        if (renderedPoints < SCOPE_BUFFER_SIZE) {
+            bool sweepDone = history.written - sweepStart >= (int64_t) SCOPE_BUFFER_SIZE * pointSamples;
+            if (sweepDone || samplesSincePublish >= args.sampleRate / SCOPE_PUBLISH_RATE) {
+                samplesSincePublish = 0;
+                if (renderScope()) {
+                    publishScope();
                 }
-                // Reset current point
-                for (int i = 0; i < 8; i++) {
-                    currentPoint[i] = ScopePoint();
+            }
+        }
+    }
+
+    void updateLayout() {
+        static const float silence = 0.f;
+        slots = 0;
+        for (int i = 0; i < 8; i++) {
+            for (int c = 0; c < trackChannels[i]; c++) {
+                slotSource[slots] = &inputs[TRACK1_INPUT + i].getVoltages()[c];
+                slots++;
+            }
+        }
+        int groups = (slots + 3) / 4;
+        for (int s = slots; s < 4 * groups; s++) {
+            slotSource[s] = &silence;
+        }
+        for (int g = 0; g < groups; g++) {
+            const float* const* source = slotSource + 4 * g;
+            groupContiguous[g] = source[1] == source[0] + 1 && source[2] == source[0] + 2 && source[3] == source[0] + 3;
+        }
+        renderedPoints = 0;
+        ScopeStorage& s = storage();
+        scopeFits = 4 * groups <= s.slots;
+        if (!scopeFits) {
+            scopeSlotsWanted.store(4 * groups, std::memory_order_relaxed);
+            return;
+        }
+        s.history.setGroups(groups);
+        layoutStart = s.history.written;
+        // Points of the old layout belong to other channels now.
+        std::fill(s.sweep.begin(), s.sweep.end(), ScopePoint());
+    }
+
+    // Fills in every point of the sweep that has been recorded in full.
+    // Returns whether any point changed.
+    bool renderScope() {
+        ScopeStorage& s = storage();
+        int level = 0;
+        while (level + 1 < MinMaxPyramid::LEVELS && (2 << level) <= pointSamples) {
+            level++;
+        }
+        // Points are widened to whole blocks of their level, so each one is
+        // reduced from a block or two rather than from single samples.
+        int64_t grid = ~((int64_t(1) << level) - 1);
+        int firstPoint = renderedPoints;
+        for (; renderedPoints < SCOPE_BUFFER_SIZE; renderedPoints++) {
+            int64_t begin = sweepStart + (int64_t) renderedPoints * pointSamples;
+            int64_t end = begin + pointSamples;
+            if (end > s.history.written)
+                break;
+            // Before the current channel layout, or once the samples have
+            // dropped out of the pyramid, there is nothing to show.
+            if ((begin & grid) < layoutStart || !renderPoint(begin & grid, end & grid)) {
+                for (int slot = 0; slot < slots; slot++) {
+                    s.sweep[slot * SCOPE_BUFFER_SIZE + renderedPoints] = ScopePoint();
                 }
-                bufferIndex++;
             }
         }
+        return renderedPoints > firstPoint;
     }
-};
 
-struct EnhancedTextLabel : Widget {
-    std::string text;
-    float fontSize;
-    NVGcolor color;
-    bool bold;
-    
-    EnhancedTextLabel(Vec pos, Vec size, const std::string& text, float fontSize = 12.f, 
-                      NVGcolor color = nvgRGB(255, 255, 255), bool bold = true) {
-        box.pos = pos;
-        box.size = size;
-        this->text = text;
-        this->fontSize = fontSize;
-        this->color = color;
-        this->bold = bold;
+    // Point renderedPoints of every channel from samples [begin, end).
+    // Returns false, with the point partly written, if they are gone.
+    bool renderPoint(int64_t begin, int64_t end) {
+        ScopeStorage& s = storage();
+        MinMaxPyramid::Block block;
+        for (int g = 0; g < s.history.getGroups(); g++) {
+            if (!s.history.reduce(g, begin, end, block))
+                return false;
+            for (int lane = 0; lane < 4 && 4 * g + lane < slots; lane++) {
+                int slot = 4 * g + lane;
+                ScopePoint& point = s.sweep[slot * SCOPE_BUFFER_SIZE + renderedPoints];
+                point.min = block.min[lane];
+                point.max = block.max[lane];
+            }
+        }
+        return true;
     }
-    
-    void draw(const DrawArgs &args) override {
-        nvgFontSize(args.vg, fontSize);
-        nvgFontFaceId(args.vg, APP->window->uiFont->handle);
-        nvgTextAlign(args.vg, NVG_ALIGN_CENTER | NVG_ALIGN_MIDDLE);
-        nvgFillColor(args.vg, color);
-        
-        if (bold) {
-            float offset = 0.3f;
-            nvgText(args.vg, box.size.x / 2.f - offset, box.size.y / 2.f, text.c_str(), NULL);
-            nvgText(args.vg, box.size.x / 2.f + offset, box.size.y / 2.f, text.c_str(), NULL);
-            nvgText(args.vg, box.size.x / 2.f, box.size.y / 2.f - offset, text.c_str(), NULL);
-            nvgText(args.vg, box.size.x / 2.f, box.size.y / 2.f + offset, text.c_str(), NULL);
-            nvgText(args.vg, box.size.x / 2.f, box.size.y / 2.f, text.c_str(), NULL);
-        } else {
-            nvgText(args.vg, box.size.x / 2.f, box.size.y / 2.f, text.c_str(), NULL);
+
+    void publishScope() {
+        ScopeStorage& s = storage();
+        ScopeFrame& frame = s.frames.writeBuffer();
+        std::copy(trackChannels, trackChannels + 8, frame.channels);
+        std::copy(s.sweep.begin(), s.sweep.begin() + slots * SCOPE_BUFFER_SIZE, frame.points.begin());
+        s.frames.publish();
+    }
+
+    json_t* dataToJson() override {
+        json_t* rootJ = json_object();
+        json_object_set_new(rootJ, "spectrumMode", json_boolean(spectrumMode));
+        json_object_set_new(rootJ, "stackChannels", json_boolean(stackChannels));
+        return rootJ;
+    }
+
+    void dataFromJson(json_t* rootJ) override {
+        json_t* spectrumModeJ = json_object_get(rootJ, "spectrumMode");
+        if (spectrumModeJ) {
+            spectrumMode = json_boolean_value(spectrumModeJ);
+        }
+        json_t* stackChannelsJ = json_object_get(rootJ, "stackChannels");
+        if (stackChannelsJ) {
+            stackChannels = json_boolean_value(stackChannelsJ);
         }
     }
+
+    // UI thread.
+    bool startCapture() {
+        if (capture.isActive())
+            return false;
+        int channels[8];
+        for (int i = 0; i < 8; i++) {
+            channels[i] = std::max(1, inputs[TRACK1_INPUT + i].getChannels());
+        }
+        std::string dir = asset::user("MADZINE");
+        system::createDirectories(dir);
+        std::time_t now = std::time(NULL);
+        char name[64];
+        std::strftime(name, sizeof(name), "Observer-%Y%m%d-%H%M%S.wav", std::localtime(&now));
+        capturePath = dir + "/" + name;
+        return capture.start(capturePath, channels, 8, APP->engine->getSampleRate());
+    }
+
+    void stopCapture() {
+        capture.stop();
+    }
 };
 
 struct HiddenTimeKnob : ParamWidget {
@@ -194,30 +391,53 @@ struct HiddenTimeKnob : ParamWidget {
     }
 };
 
-struct WhiteBackgroundBox : Widget {
-    WhiteBackgroundBox(Vec pos, Vec size) {
-        box.pos = pos;
-        box.size = size;
-    }
-    
-    void draw(const DrawArgs &args) override {
-        nvgBeginPath(args.vg);
-        nvgRect(args.vg, 0, 0, box.size.x, box.size.y);
-        nvgFillColor(args.vg, nvgRGB(255, 255, 255));
-        nvgFill(args.vg);
-        
-        nvgStrokeWidth(args.vg, 1.0f);
-        nvgStrokeColor(args.vg, nvgRGBA(200, 200, 200, 255));
-        nvgStroke(args.vg);
-    }
-};
-
 struct ObserverScopeDisplay : LedDisplay {
     Observer* module;
     ModuleWidget* moduleWidget;
+    // Trace heights (0-1 within a track) of the last frame taken from the
+    // module; only recomputed when the module has published a new one.
+    int waveChannels[8];
+    float waveY[8][Observer::MAX_CHANNELS][Observer::SCOPE_BUFFER_SIZE];
+    // Created the first time the spectrum view is shown.
+    std::unique_ptr<SpectrumAnalyzer> analyzer;
     
     ObserverScopeDisplay() {
         box.size = Vec(120, 300); // 8HP width, adjusted height for 8 tracks
+        for (int t = 0; t < 8; t++) {
+            waveChannels[t] = 1;
+            for (int i = 0; i < Observer::SCOPE_BUFFER_SIZE; i++) {
+                waveY[t][0][i] = 0.5f;
+            }
+        }
+    }
+
+    // Storage the module asked for is built here, on the UI thread.
+    void step() override {
+        if (module) {
+            module->growScope();
+            if (module->spectrumMode && !module->spectrumTap.load(std::memory_order_relaxed))
+                module->spectrumTap.store(new SpectrumTap, std::memory_order_release);
+        }
+        LedDisplay::step();
+    }
+
+    void updateWaves() {
+        ScopeStorage* scope = module->scope.load(std::memory_order_acquire);
+        if (!scope->frames.consume())
+            return;
+        const ScopeFrame& frame = scope->frames.readBuffer();
+        for (int t = 0; t < 8; t++) {
+            waveChannels[t] = frame.channels[t];
+            for (int c = 0; c < frame.channels[t]; c++) {
+                const ScopePoint* points = frame.track(t, c);
+                for (int i = 0; i < Observer::SCOPE_BUFFER_SIZE; i++) {
+                    float max = points[i].max;
+                    if (!std::isfinite(max))
+                        max = 0.f;
+                    waveY[t][c][i] = max * -0.05f + 0.5f; // Scale for ±10V range
+                }
+            }
+        }
     }
     
     void drawWave(const DrawArgs& args, int track, NVGcolor color) {
@@ -229,30 +449,64 @@ struct ObserverScopeDisplay : LedDisplay {
         float trackHeight = box.size.y / 8.0f;
         float trackY = track * trackHeight;
         
-        Rect b = Rect(Vec(0, trackY), Vec(box.size.x, trackHeight));
-        nvgScissor(args.vg, RECT_ARGS(b));
+        Rect lane = Rect(Vec(0, trackY), Vec(box.size.x, trackHeight));
+        nvgScissor(args.vg, RECT_ARGS(lane));
         nvgBeginPath(args.vg);
         
-        for (int i = 0; i < Observer::SCOPE_BUFFER_SIZE; i++) {
-            const Observer::ScopePoint& point = module->scopeBuffer[track][i];
-            float max = point.max;
-            if (!std::isfinite(max))
-                max = 0.f;
+        // Poly channels either share the lane or split it into strips
+        int channels = waveChannels[track];
+        bool stack = module->stackChannels && channels > 1;
+        for (int c = 0; c < channels; c++) {
+            Rect b = lane;
+            if (stack) {
+                b.size.y = trackHeight / channels;
+                b.pos.y = trackY + c * b.size.y;
+            }
+            for (int i = 0; i < Observer::SCOPE_BUFFER_SIZE; i++) {
+                Vec p;
+                p.x = (float)i / (Observer::SCOPE_BUFFER_SIZE - 1);
+                p.y = waveY[track][c][i];
+                p = b.interpolate(p);
+                
+                if (i == 0)
+                    nvgMoveTo(args.vg, p.x, p.y);
+                else
+                    nvgLineTo(args.vg, p.x, p.y);
+            }
+        }
+        
+        nvgStrokeColor(args.vg, color);
+        nvgStrokeWidth(args.vg, channels > 1 ? 1.f : 1.5f);
+        nvgLineCap(args.vg, NVG_ROUND);
+        nvgStroke(args.vg);
+        nvgResetScissor(args.vg);
+        nvgRestore(args.vg);
+    }
+    
+    void drawSpectrum(const DrawArgs& args, int track, NVGcolor color) {
+        nvgSave(args.vg);
+
+        float trackHeight = box.size.y / 8.0f;
+        Rect b = Rect(Vec(0, track * trackHeight), Vec(box.size.x, trackHeight));
+        nvgScissor(args.vg, RECT_ARGS(b));
+        nvgBeginPath(args.vg);
 
+        const float* levels = analyzer->levels[track];
+        for (int i = 0; i < SpectrumAnalyzer::BANDS; i++) {
             Vec p;
-            p.x = (float)i / (Observer::SCOPE_BUFFER_SIZE - 1);
-            p.y = (max) * -0.05f + 0.5f; // Scale for ±10V range
+            p.x = (float)i / (SpectrumAnalyzer::BANDS - 1);
+            p.y = 1.f - rescale(levels[i], SpectrumAnalyzer::MIN_DB, SpectrumAnalyzer::MAX_DB, 0.f, 1.f);
             p = b.interpolate(p);
-            
+
             if (i == 0)
                 nvgMoveTo(args.vg, p.x, p.y);
             else
                 nvgLineTo(args.vg, p.x, p.y);
         }
-        
+
         nvgStrokeColor(args.vg, color);
-        nvgStrokeWidth(args.vg, 1.5f);
-        nvgLineCap(args.vg, NVG_ROUND);
+        nvgStrokeWidth(args.vg, 1.f);
+        nvgLineJoin(args.vg, NVG_ROUND);
         nvgStroke(args.vg);
         nvgResetScissor(args.vg);
         nvgRestore(args.vg);
@@ -308,6 +562,17 @@ struct ObserverScopeDisplay : LedDisplay {
         drawBackground(args);
         
         if (!module || !moduleWidget) return;
+
+        SpectrumTap* tap = module->spectrumTap.load(std::memory_order_acquire);
+        bool spectrum = module->spectrumMode && tap;
+        if (spectrum) {
+            if (!analyzer)
+                analyzer.reset(new SpectrumAnalyzer);
+            analyzer->update(*tap, APP->engine->getSampleRate());
+        }
+        else {
+            updateWaves();
+        }
         
         // Get input colors from cable connections, with white as default
         for (int i = 0; i < 8; i++) {
@@ -315,19 +580,36 @@ struct ObserverScopeDisplay : LedDisplay {
             CableWidget* cable = APP->scene->rack->getTopCable(inputPort);
             NVGcolor trackColor = cable ? cable->color : nvgRGB(255, 255, 255); // White when no cable
             
-            drawWave(args, i, trackColor);
+            if (spectrum)
+                drawSpectrum(args, i, trackColor);
+            else
+                drawWave(args, i, trackColor);
+        }
+
+        if (module->capture.isActive()) {
+            uint64_t overruns = module->capture.overruns.load();
+            std::string text = overruns ? string::f("REC  %llu dropped", (unsigned long long) overruns) : "REC";
+            nvgFontSize(args.vg, 9.f);
+            nvgFontFaceId(args.vg, APP->window->uiFont->handle);
+            nvgTextAlign(args.vg, NVG_ALIGN_RIGHT | NVG_ALIGN_TOP);
+            nvgFillColor(args.vg, nvgRGB(255, 60, 60));
+            nvgText(args.vg, box.size.x - 3, 3, text.c_str(), NULL);
         }
     }
 };
 
-struct ClickableLight : ParamWidget {
+struct ClickableLight : CachedParamWidget {
     Observer* module;
     
     ClickableLight() {
         box.size = Vec(8, 8);
     }
     
-    void draw(const DrawArgs& args) override {
+    float cacheKey() override {
+        return module && module->lights[Observer::TRIG_LIGHT].getBrightness() > 0.5f;
+    }
+    
+    void drawCached(const DrawArgs& args) override {
         if (!module) return;
         
         float brightness = module->lights[Observer::TRIG_LIGHT].getBrightness();
@@ -401,6 +683,36 @@ struct ObserverWidget : ModuleWidget {
         addInput(createInputCentered<PJ301MPort>(Vec(45, 368), module, Observer::TRACK6_INPUT));
         addInput(createInputCentered<PJ301MPort>(Vec(75, 368), module, Observer::TRACK7_INPUT));
         addInput(createInputCentered<PJ301MPort>(Vec(105, 368), module, Observer::TRACK8_INPUT));
+
+        addChild(new PerfReadout(module, box.size.x));
+    }
+
+    void appendContextMenu(Menu* menu) override {
+        Observer* module = getModule<Observer>();
+        if (!module) return;
+
+        menu->addChild(new MenuSeparator);
+        menu->addChild(createBoolPtrMenuItem("Spectrum view", "", &module->spectrumMode));
+        menu->addChild(createBoolPtrMenuItem("Stack poly channels", "", &module->stackChannels));
+
+        menu->addChild(new MenuSeparator);
+        menu->addChild(createMenuLabel("Disk Capture"));
+
+        if (module->capture.isActive()) {
+            menu->addChild(createMenuItem("Stop capture", "", [=]() {
+                module->stopCapture();
+            }));
+            menu->addChild(createMenuLabel(string::f("%d channels, %llu dropped frames", module->capture.getChannels(), (unsigned long long) module->capture.overruns.load())));
+        } else {
+            menu->addChild(createMenuItem("Start capture", "", [=]() {
+                module->startCapture();
+            }));
+        }
+        if (!module->capturePath.empty()) {
+            menu->addChild(createMenuLabel(module->capturePath));
+        }
+
+        appendPerfMenu(menu, module);
     }
 };
 
@@ -1,4 +1,7 @@
 #include "plugin.hpp"
+#include "eventdelay.hpp"
+#include "perf.hpp"
+#include "widgets.hpp"
 
 struct DensityParamQuantity : ParamQuantity {
     std::string getDisplayValueString() override {
@@ -24,7 +27,7 @@ struct DensityParamQuantity : ParamQuantity {
     }
 };
 
-struct PPaTTTerning : Module {
+struct PPaTTTerning : MeteredModule {
     enum ParamId {
         K1_PARAM, K2_PARAM, K3_PARAM, K4_PARAM, K5_PARAM,
         STYLE_PARAM, DENSITY_PARAM, CHAOS_PARAM,
@@ -52,6 +55,14 @@ struct PPaTTTerning : Module {
     dsp::PulseGenerator gateOutPulse, gate2OutPulse;
     
     int currentStep = 0, sequenceLength = 16, stepToKnobMapping[64];
+    // Chaos draws from its own generator. The seed is saved with the patch
+    // and restored on reset, so the same variations play back.
+    random::Xoroshiro128Plus mappingRng;
+    uint64_t mappingSeed = 0;
+    // What the current table was built from.
+    float mappingDensity = -1.0f, mappingChaos = -1.0f;
+    int mappingStyle = -1;
+    int remapsStat;
     float previousVoltage = -999.0f;
     int styleMode = 1;
     
@@ -59,13 +70,12 @@ struct PPaTTTerning : Module {
     float cvHistory[MAX_DELAY];
     int historyIndex = 0, track2Delay = 1;
     
-    static const int CVD_BUFFER_SIZE = 192000;
-    float cvdBuffer[CVD_BUFFER_SIZE];
-    int cvdWriteIndex = 0;
+    EventDelay<> cvdDelay;
     float sampleRate = 44100.0f;
     
     PPaTTTerning() {
         config(PARAMS_LEN, INPUTS_LEN, OUTPUTS_LEN, LIGHTS_LEN);
+        remapsStat = perf.addStat("remaps/s", PerfMeter::RATE);
         
         configParam(K1_PARAM, -10.0f, 10.0f, 0.0f, "K1", "V");
         configParam(K2_PARAM, -10.0f, 10.0f, 2.0f, "K2", "V");
@@ -107,7 +117,8 @@ struct PPaTTTerning : Module {
         updateOutputDescriptions();
         
         for (int i = 0; i < MAX_DELAY; i++) cvHistory[i] = 0.0f;
-        for (int i = 0; i < CVD_BUFFER_SIZE; i++) cvdBuffer[i] = 0.0f;
+        mappingSeed = random::u64();
+        seedMapping();
         generateMapping();
     }
     
@@ -122,12 +133,19 @@ struct PPaTTTerning : Module {
 
     json_t* dataToJson() override {
         json_t* rootJ = json_object();
+        json_object_set_new(rootJ, "mappingSeed", json_integer((long long) mappingSeed));
         json_object_set_new(rootJ, "track2Delay", json_integer(track2Delay));
         json_object_set_new(rootJ, "styleMode", json_integer(styleMode));
         return rootJ;
     }
 
     void dataFromJson(json_t* rootJ) override {
+        json_t* seedJ = json_object_get(rootJ, "mappingSeed");
+        if (seedJ) {
+            mappingSeed = (uint64_t) json_integer_value(seedJ);
+            seedMapping();
+        }
+        
         json_t* t2 = json_object_get(rootJ, "track2Delay");
         if (t2) {
             track2Delay = clamp((int)json_integer_value(t2), 0, 5);
@@ -143,10 +161,35 @@ struct PPaTTTerning : Module {
         updateOutputDescriptions();
     }
 
+    void seedMapping() {
+        mappingRng.seed(mappingSeed, 0x9e3779b97f4a7c15ull);
+    }
+    
+    float chaosUniform() {
+        return (mappingRng() >> 40) / 16777216.f;
+    }
+    
+    uint32_t chaosU32() {
+        return (uint32_t) (mappingRng() >> 32);
+    }
+    
+    // Clock edges only rebuild the table if density, chaos or style moved
+    // since it was built, or chaos is up and re-rolls it every step.
+    void updateMapping() {
+        float density = params[DENSITY_PARAM].getValue();
+        float chaos = params[CHAOS_PARAM].getValue();
+        if (chaos > 0.0f || density != mappingDensity || chaos != mappingChaos || styleMode != mappingStyle)
+            generateMapping();
+    }
+    
     void generateMapping() {
+        perf.add(remapsStat, 1.0f);
         int style = styleMode;
         float density = params[DENSITY_PARAM].getValue();
         float chaos = params[CHAOS_PARAM].getValue();
+        mappingDensity = density;
+        mappingChaos = chaos;
+        mappingStyle = styleMode;
         
         if (density < 0.2f) {
             sequenceLength = 8 + (int)(density * 20);
@@ -161,7 +204,7 @@ struct PPaTTTerning : Module {
         
         if (chaos > 0.0f) {
             float chaosRange = chaos * sequenceLength * 0.5f;
-            float randomOffset = (random::uniform() - 0.5f) * 2.0f * chaosRange;
+            float randomOffset = (chaosUniform() - 0.5f) * 2.0f * chaosRange;
             sequenceLength += (int)randomOffset;
             sequenceLength = clamp(sequenceLength, 4, 64);
         }
@@ -210,21 +253,22 @@ struct PPaTTTerning : Module {
         if (chaos > 0.3f) {
             int chaosSteps = (int)(chaos * sequenceLength * 0.3f);
             for (int i = 0; i < chaosSteps; i++) {
-                int randomStep = random::u32() % sequenceLength;
-                stepToKnobMapping[randomStep] = random::u32() % 5;
+                int randomStep = chaosU32() % sequenceLength;
+                stepToKnobMapping[randomStep] = chaosU32() % 5;
             }
         }
     }
 
     void process(const ProcessArgs& args) override {
+        PerfMeter::Scope perfScope(perf, args.sampleRate);
         if (resetTrigger.process(inputs[RESET_INPUT].getVoltage())) {
             currentStep = 0;
+            seedMapping();
             generateMapping();
             previousVoltage = -999.0f;
             for (int i = 0; i < MAX_DELAY; i++) cvHistory[i] = 0.0f;
-            for (int i = 0; i < CVD_BUFFER_SIZE; i++) cvdBuffer[i] = 0.0f;
+            cvdDelay.reset();
             historyIndex = 0;
-            cvdWriteIndex = 0;
         }
         
         if (styleTrigger.process(params[STYLE_PARAM].getValue())) {
@@ -255,7 +299,7 @@ struct PPaTTTerning : Module {
             cvHistory[historyIndex] = voltage;
             
             currentStep = (currentStep + 1) % sequenceLength;
-            generateMapping();
+            updateMapping();
             
             int newActiveKnob = stepToKnobMapping[currentStep];
             float newVoltage = params[K1_PARAM + newActiveKnob].getValue();
@@ -287,20 +331,9 @@ struct PPaTTTerning : Module {
             delayTimeMs = (cvdCV / 10.0f) * knobValue * 1000.0f;
         }
         
-        if (delayTimeMs <= 0.001f) {
-            outputs[CV2_OUTPUT].setVoltage(shiftRegisterCV);
-        } else {
-            cvdBuffer[cvdWriteIndex] = shiftRegisterCV;
-            cvdWriteIndex = (cvdWriteIndex + 1) % CVD_BUFFER_SIZE;
-            
-            int delaySamples = (int)(delayTimeMs * sampleRate / 1000.0f);
-            delaySamples = clamp(delaySamples, 0, CVD_BUFFER_SIZE - 1);
-            
-            int readIndex = (cvdWriteIndex - delaySamples + CVD_BUFFER_SIZE) % CVD_BUFFER_SIZE;
-            float delayedCV = cvdBuffer[readIndex];
-            
-            outputs[CV2_OUTPUT].setVoltage(delayedCV);
-        }
+        // Recorded even while bypassed, so turning CVD up plays back real history.
+        float delayedCV = cvdDelay.process(shiftRegisterCV, delayTimeMs * sampleRate / 1000.0f);
+        outputs[CV2_OUTPUT].setVoltage(delayTimeMs <= 0.001f ? shiftRegisterCV : delayedCV);
         
         outputs[TRIG2_OUTPUT].setVoltage(gate2OutPulse.process(args.sampleTime) ? 10.0f : 0.0f);
     }
@@ -340,127 +373,6 @@ struct StyleParamQuantity : ParamQuantity {
     }
 };
 
-struct EnhancedTextLabel : TransparentWidget {
-    std::string text;
-    float fontSize;
-    NVGcolor color;
-    bool bold;
-    
-    EnhancedTextLabel(Vec pos, Vec size, std::string text, float fontSize = 12.f, 
-                      NVGcolor color = nvgRGB(255, 255, 255), bool bold = true) {
-        box.pos = pos; box.size = size; this->text = text; this->fontSize = fontSize; this->color = color; this->bold = bold;
-    }
-    
-    void draw(const DrawArgs &args) override {
-        nvgFontSize(args.vg, fontSize);
-        nvgFontFaceId(args.vg, APP->window->uiFont->handle);
-        nvgTextAlign(args.vg, NVG_ALIGN_CENTER | NVG_ALIGN_MIDDLE);
-        nvgFillColor(args.vg, color);
-        
-        if (bold) {
-            float offset = 0.3f;
-            nvgText(args.vg, box.size.x / 2.f - offset, box.size.y / 2.f, text.c_str(), NULL);
-            nvgText(args.vg, box.size.x / 2.f + offset, box.size.y / 2.f, text.c_str(), NULL);
-            nvgText(args.vg, box.size.x / 2.f, box.size.y / 2.f - offset, text.c_str(), NULL);
-            nvgText(args.vg, box.size.x / 2.f, box.size.y / 2.f + offset, text.c_str(), NULL);
-        }
-        nvgText(args.vg, box.size.x / 2.f, box.size.y / 2.f, text.c_str(), NULL);
-    }
-};
-
-struct StandardBlackKnob : ParamWidget {
-    bool isDragging = false;
-    
-    StandardBlackKnob() { box.size = Vec(30, 30); }
-    
-    float getDisplayAngle() {
-        ParamQuantity* pq = getParamQuantity();
-        if (!pq) return 0.0f;
-        float normalizedValue = pq->getScaledValue();
-        return rescale(normalizedValue, 0.0f, 1.0f, -0.75f * M_PI, 0.75f * M_PI);
-    }
-    
-    void draw(const DrawArgs& args) override {
-        float radius = box.size.x / 2.0f;
-        float angle = getDisplayAngle();
-        
-        nvgBeginPath(args.vg);
-        nvgCircle(args.vg, radius, radius, radius - 1);
-        nvgFillColor(args.vg, nvgRGB(30, 30, 30));
-        nvgFill(args.vg);
-        
-        nvgBeginPath(args.vg);
-        nvgCircle(args.vg, radius, radius, radius - 1);
-        nvgStrokeWidth(args.vg, 1.0f);
-        nvgStrokeColor(args.vg, nvgRGB(100, 100, 100));
-        nvgStroke(args.vg);
-        
-        nvgBeginPath(args.vg);
-        nvgCircle(args.vg, radius, radius, radius - 4);
-        nvgFillColor(args.vg, nvgRGB(50, 50, 50));
-        nvgFill(args.vg);
-        
-        float indicatorLength = radius - 8;
-        float lineX = radius + indicatorLength * std::sin(angle);
-        float lineY = radius - indicatorLength * std::cos(angle);
-        
-        nvgBeginPath(args.vg);
-        nvgMoveTo(args.vg, radius, radius);
-        nvgLineTo(args.vg, lineX, lineY);
-        nvgStrokeWidth(args.vg, 2.0f);
-        nvgStrokeColor(args.vg, nvgRGB(255, 255, 255));
-        nvgStroke(args.vg);
-        
-        nvgBeginPath(args.vg);
-        nvgCircle(args.vg, lineX, lineY, 2.0f);
-        nvgFillColor(args.vg, nvgRGB(255, 255, 255));
-        nvgFill(args.vg);
-    }
-    
-    void onButton(const event::Button& e) override {
-        if (e.action == GLFW_PRESS && e.button == GLFW_MOUSE_BUTTON_LEFT) {
-            isDragging = true;
-            e.consume(this);
-        } else if (e.action == GLFW_RELEASE && e.button == GLFW_MOUSE_BUTTON_LEFT) {
-            isDragging = false;
-        }
-        ParamWidget::onButton(e);
-    }
-    
-    void onDragMove(const event::DragMove& e) override {
-        ParamQuantity* pq = getParamQuantity();
-        if (!isDragging || !pq) return;
-        
-        float sensitivity = 0.002f;
-        float deltaY = -e.mouseDelta.y;
-        float range = pq->getMaxValue() - pq->getMinValue();
-        float currentValue = pq->getValue();
-        float newValue = clamp(currentValue + deltaY * sensitivity * range, pq->getMinValue(), pq->getMaxValue());
-        pq->setValue(newValue);
-    }
-    
-    void onDoubleClick(const event::DoubleClick& e) override {
-        ParamQuantity* pq = getParamQuantity();
-        if (!pq) return;
-        pq->reset();
-        e.consume(this);
-    }
-};
-
-struct WhiteBackgroundBox : Widget {
-    WhiteBackgroundBox(Vec pos, Vec size) { box.pos = pos; box.size = size; }
-    
-    void draw(const DrawArgs &args) override {
-        nvgBeginPath(args.vg);
-        nvgRect(args.vg, 0, 0, box.size.x, box.size.y);
-        nvgFillColor(args.vg, nvgRGB(255, 255, 255));
-        nvgFill(args.vg);
-        nvgStrokeWidth(args.vg, 1.0f);
-        nvgStrokeColor(args.vg, nvgRGBA(200, 200, 200, 255));
-        nvgStroke(args.vg);
-    }
-};
-
 struct PPaTTTerningWidget : ModuleWidget {
     PPaTTTerningWidget(PPaTTTerning* module) {
         setModule(module);
@@ -478,7 +390,7 @@ struct PPaTTTerningWidget : ModuleWidget {
         addInput(createInputCentered<PJ301MPort>(Vec(centerX + 15, 55), module, PPaTTTerning::RESET_INPUT));
         
         addChild(new EnhancedTextLabel(Vec(8, 69), Vec(15, 15), "1", 8.f, nvgRGB(255, 255, 255), true));
-        addParam(createParamCentered<StandardBlackKnob>(Vec(centerX - 15, 97), module, PPaTTTerning::K1_PARAM));
+        addParam(createParamCentered<LargeBlackKnob>(Vec(centerX - 15, 97), module, PPaTTTerning::K1_PARAM));
         
         addChild(new EnhancedTextLabel(Vec(38, 74), Vec(15, 15), "MODE", 7.f, nvgRGB(255, 255, 255), true));
         addChild(createLightCentered<MediumLight<RedGreenBlueLight>>(Vec(centerX + 15, 97), module, PPaTTTerning::STYLE_LIGHT_RED));
@@ -497,25 +409,25 @@ struct PPaTTTerningWidget : ModuleWidget {
         }
         
         addChild(new EnhancedTextLabel(Vec(8, 114), Vec(15, 15), "2", 8.f, nvgRGB(255, 255, 255), true));
-        addParam(createParamCentered<StandardBlackKnob>(Vec(centerX - 15, 142), module, PPaTTTerning::K2_PARAM));
+        addParam(createParamCentered<LargeBlackKnob>(Vec(centerX - 15, 142), module, PPaTTTerning::K2_PARAM));
         
         addChild(new EnhancedTextLabel(Vec(32, 114), Vec(26, 15), "DENSITY", 7.f, nvgRGB(255, 255, 255), true));
-        addParam(createParamCentered<StandardBlackKnob>(Vec(centerX + 15, 142), module, PPaTTTerning::DENSITY_PARAM));
+        addParam(createParamCentered<LargeBlackKnob>(Vec(centerX + 15, 142), module, PPaTTTerning::DENSITY_PARAM));
         
         addChild(new EnhancedTextLabel(Vec(8, 159), Vec(15, 15), "3", 8.f, nvgRGB(255, 255, 255), true));
-        addParam(createParamCentered<StandardBlackKnob>(Vec(centerX - 15, 187), module, PPaTTTerning::K3_PARAM));
+        addParam(createParamCentered<LargeBlackKnob>(Vec(centerX - 15, 187), module, PPaTTTerning::K3_PARAM));
         
         addChild(new EnhancedTextLabel(Vec(35, 159), Vec(20, 15), "CHAOS", 7.f, nvgRGB(255, 255, 255), true));
-        addParam(createParamCentered<StandardBlackKnob>(Vec(centerX + 15, 187), module, PPaTTTerning::CHAOS_PARAM));
+        addParam(createParamCentered<LargeBlackKnob>(Vec(centerX + 15, 187), module, PPaTTTerning::CHAOS_PARAM));
         
         addChild(new EnhancedTextLabel(Vec(8, 204), Vec(15, 15), "4", 8.f, nvgRGB(255, 255, 255), true));
-        addParam(createParamCentered<StandardBlackKnob>(Vec(centerX - 15, 232), module, PPaTTTerning::K4_PARAM));
+        addParam(createParamCentered<LargeBlackKnob>(Vec(centerX - 15, 232), module, PPaTTTerning::K4_PARAM));
         
         addChild(new EnhancedTextLabel(Vec(32, 204), Vec(26, 15), "CV OUT", 7.f, nvgRGB(255, 255, 255), true));
         addOutput(createOutputCentered<PJ301MPort>(Vec(centerX + 15, 232), module, PPaTTTerning::CV_OUTPUT));
         
         addChild(new EnhancedTextLabel(Vec(8, 249), Vec(15, 15), "5", 8.f, nvgRGB(255, 255, 255), true));
-        addParam(createParamCentered<StandardBlackKnob>(Vec(centerX - 15, 277), module, PPaTTTerning::K5_PARAM));
+        addParam(createParamCentered<LargeBlackKnob>(Vec(centerX - 15, 277), module, PPaTTTerning::K5_PARAM));
         
         addChild(new EnhancedTextLabel(Vec(30, 249), Vec(30, 15), "TRIG", 7.f, nvgRGB(255, 255, 255), true));
         addOutput(createOutputCentered<PJ301MPort>(Vec(centerX + 15, 277), module, PPaTTTerning::TRIG_OUTPUT));
@@ -548,6 +460,15 @@ struct PPaTTTerningWidget : ModuleWidget {
         addChild(new EnhancedTextLabel(Vec(5, 360), Vec(20, 15), "CVD", 7.f, nvgRGB(255, 133, 133), true));
         addParam(createParamCentered<Trimpot>(Vec(15, 370), module, PPaTTTerning::CVD_ATTEN_PARAM));
         addInput(createInputCentered<PJ301MPort>(Vec(45, 370), module, PPaTTTerning::CVD_CV_INPUT));
+
+        addChild(new PerfReadout(module, box.size.x));
+    }
+
+    void appendContextMenu(Menu* menu) override {
+        PPaTTTerning* module = getModule<PPaTTTerning>();
+        if (!module) return;
+
+        appendPerfMenu(menu, module);
     }
 };
 
@@ -1,150 +1,16 @@
 #include "plugin.hpp"
+#include "aafilter.hpp"
+#include "denormal.hpp"
+#include "fastmath.hpp"
+#include "noise.hpp"
+#include "perf.hpp"
+#include "widgets.hpp"
 #include <cmath>
 #include <algorithm>
 #include <random>
 
 using namespace rack;
 
-namespace ripples
-{
-struct SOSCoefficients
-{
-    float b[3];
-    float a[2];
-};
-
-template <typename T, int max_num_sections>
-class SOSFilter
-{
-public:
-    SOSFilter()
-    {
-        Init(0);
-    }
-    SOSFilter(int num_sections)
-    {
-        Init(num_sections);
-    }
-    void Init(int num_sections)
-    {
-        num_sections_ = num_sections;
-        Reset();
-    }
-    void Init(int num_sections, const SOSCoefficients* sections)
-    {
-        num_sections_ = num_sections;
-        Reset();
-        SetCoefficients(sections);
-    }
-    void Reset()
-    {
-        for (int n = 0; n < num_sections_; n++)
-        {
-            x_[n][0] = 0.f;
-            x_[n][1] = 0.f;
-            x_[n][2] = 0.f;
-        }
-        x_[num_sections_][0] = 0.f;
-        x_[num_sections_][1] = 0.f;
-        x_[num_sections_][2] = 0.f;
-    }
-    void SetCoefficients(const SOSCoefficients* sections)
-    {
-        for (int n = 0; n < num_sections_; n++)
-        {
-            sections_[n].b[0] = sections[n].b[0];
-            sections_[n].b[1] = sections[n].b[1];
-            sections_[n].b[2] = sections[n].b[2];
-            sections_[n].a[0] = sections[n].a[0];
-            sections_[n].a[1] = sections[n].a[1];
-        }
-    }
-    T Process(T in)
-    {
-        for (int n = 0; n < num_sections_; n++)
-        {
-            x_[n][2] = x_[n][1];
-            x_[n][1] = x_[n][0];
-            x_[n][0] = in;
-            T out = 0.f;
-            out += sections_[n].b[0] * x_[n][0];
-            out += sections_[n].b[1] * x_[n][1];
-            out += sections_[n].b[2] * x_[n][2];
-            out -= sections_[n].a[0] * x_[n+1][0];
-            out -= sections_[n].a[1] * x_[n+1][1];
-            in = out;
-        }
-        x_[num_sections_][2] = x_[num_sections_][1];
-        x_[num_sections_][1] = x_[num_sections_][0];
-        x_[num_sections_][0] = in;
-        return in;
-    }
-protected:
-    int num_sections_;
-    SOSCoefficients sections_[max_num_sections];
-    T x_[max_num_sections + 1][3];
-};
-
-template <typename T>
-class AAFilter
-{
-public:
-    void Init(float sample_rate)
-    {
-        InitFilter(sample_rate);
-    }
-
-    T ProcessUp(T in)
-    {
-        return up_filter_.Process(in);
-    }
-
-    T ProcessDown(T in)
-    {
-        return down_filter_.Process(in);
-    }
-
-    int GetOversamplingFactor(void)
-    {
-        return oversampling_factor_;
-    }
-
-protected:
-    struct CascadedSOS
-    {
-        float sample_rate;
-        int oversampling_factor;
-        int num_sections;
-        const SOSCoefficients* coeffs;
-    };
-
-    static constexpr int kMaxNumSections = 7;
-
-    SOSFilter<T, kMaxNumSections> up_filter_;
-    SOSFilter<T, kMaxNumSections> down_filter_;
-    int oversampling_factor_;
-
-    void InitFilter(float sample_rate)
-    {
-
-    const SOSCoefficients kFilter48000x3[6] = 
-    {
-        { {1.96007199e-04,  3.15285921e-04,  1.96007199e-04,  }, {-1.49750952e+00, 5.79487424e-01,  } },
-        { {1.00000000e+00,  1.64502383e-01,  1.00000000e+00,  }, {-1.43900370e+00, 6.63196513e-01,  } },
-        { {1.00000000e+00,  -5.92180251e-01, 1.00000000e+00,  }, {-1.36241892e+00, 7.75058824e-01,  } },
-        { {1.00000000e+00,  -9.07488127e-01, 1.00000000e+00,  }, {-1.30223398e+00, 8.69165582e-01,  } },
-        { {1.00000000e+00,  -1.04177534e+00, 1.00000000e+00,  }, {-1.26951947e+00, 9.34679234e-01,  } },
-        { {1.00000000e+00,  -1.09276235e+00, 1.00000000e+00,  }, {-1.26454687e+00, 9.80322986e-01,  } },
-    };
-    
-    up_filter_.Init(6, kFilter48000x3);
-    down_filter_.Init(6, kFilter48000x3);
-    oversampling_factor_ = 3;
-    }
-};
-
-}
-
 static const float kFreqKnobMin = 20.f;
 static const float kFreqKnobMax = 20000.f;
 static const float kFreqKnobVoltage = std::log2f(kFreqKnobMax / kFreqKnobMin);
@@ -189,30 +55,15 @@ static const float kBP2Gain = -100e3f / 39e3f;
 static const float kVtoICollectorVSat = -10.f;
 static const float kOpampSatV = 10.6f;
 
-template <int QUALITY = 8>
-struct PinkNoiseGenerator {
-    int frame = -1;
-    float values[QUALITY] = {};
+// Below this the resonator counts as silent (-100 dB re 10 V).
+static const float kIdleThresholdV = 1e-4f;
+// How long it has to stay silent before the module sleeps; comfortably longer
+// than the AA filters take to ring out.
+static const float kIdleHoldTime = 0.01f;
+// Freq/decay movement (in normalised knob units) that wakes a sleeping module.
+static const float kIdleWakeDelta = 1e-4f;
 
-    float process() {
-        int lastFrame = frame;
-        frame++;
-        if (frame >= (1 << QUALITY))
-            frame = 0;
-        int diff = lastFrame ^ frame;
-
-        float sum = 0.f;
-        for (int i = 0; i < QUALITY; i++) {
-            if (diff & (1 << i)) {
-                values[i] = random::uniform() - 0.5f;
-            }
-            sum += values[i];
-        }
-        return sum;
-    }
-};
-
-struct Pinpple : Module {
+struct Pinpple : MeteredModule {
     enum ParamId {
         FREQ_PARAM,
         RESONANCE_PARAM,
@@ -242,11 +93,58 @@ struct Pinpple : Module {
         LIGHTS_LEN
     };
 
+    // The audio, v_oct and i_reso paths of four voices. They share one
+    // upsampling filter, so its three section chains run interleaved.
+    struct EngineInputs {
+        simd::float_4 audio;
+        simd::float_4 v_oct;
+        simd::float_4 i_reso;
+        
+        EngineInputs() {}
+        EngineInputs(float x) : audio(x), v_oct(x), i_reso(x) {}
+        EngineInputs(simd::float_4 audio, simd::float_4 v_oct, simd::float_4 i_reso) : audio(audio), v_oct(v_oct), i_reso(i_reso) {}
+        
+        EngineInputs& operator+=(const EngineInputs& b) {
+            audio += b.audio;
+            v_oct += b.v_oct;
+            i_reso += b.i_reso;
+            return *this;
+        }
+        EngineInputs& operator-=(const EngineInputs& b) {
+            audio -= b.audio;
+            v_oct -= b.v_oct;
+            i_reso -= b.i_reso;
+            return *this;
+        }
+        friend EngineInputs operator*(float k, const EngineInputs& x) {
+            return EngineInputs(k * x.audio, k * x.v_oct, k * x.i_reso);
+        }
+        friend EngineInputs flushDenormal(const EngineInputs& x) {
+            return EngineInputs(flushDenormal(x.audio), flushDenormal(x.v_oct), flushDenormal(x.i_reso));
+        }
+    };
+    
+    // Four voices side by side, one per SIMD lane. Cell n of every voice lives
+    // in cell_voltage_[n], and the audio, v_oct and i_reso paths each have
+    // their own RC filter, so nothing is ever shuffled between lanes.
+    //
+    // A lone voice would leave three lanes idle in every vector, so while
+    // setSingleVoice() is on, lane 0 runs packed instead: lane n of
+    // voice_cells_ is cell n, one upsampling filter carries (audio, v_oct,
+    // i_reso) and one RC filter (feedforward, freq, res).
     struct RipplesBPFEngine {
         float sample_time_;
-        simd::float_4 cell_voltage_;
-        ripples::AAFilter<simd::float_4> aa_filter_;
-        dsp::TRCFilter<simd::float_4> rc_filters_;
+        simd::float_4 cell_voltage_[4];
+        ripples::AAFilter<EngineInputs> up_filter_;
+        ripples::AAFilter<simd::float_4> down_filter_;
+        dsp::TRCFilter<simd::float_4> ff_filter_;
+        dsp::TRCFilter<simd::float_4> freq_filter_;
+        dsp::TRCFilter<simd::float_4> res_filter_;
+        
+        bool single_voice_ = false;
+        simd::float_4 voice_cells_;
+        ripples::AAFilter<simd::float_4> voice_filter_;
+        dsp::TRCFilter<simd::float_4> voice_rc_;
         
         RipplesBPFEngine() {
             setSampleRate(44100.f);
@@ -254,97 +152,222 @@ struct Pinpple : Module {
         
         void setSampleRate(float sample_rate) {
             sample_time_ = 1.f / sample_rate;
-            cell_voltage_ = simd::float_4(0.f);
-            aa_filter_.Init(sample_rate);
+            for (int n = 0; n < 4; n++) {
+                cell_voltage_[n] = simd::float_4(0.f);
+            }
+            voice_cells_ = simd::float_4(0.f);
+            up_filter_.Init(sample_rate);
+            down_filter_.Init(sample_rate);
+            voice_filter_.Init(sample_rate);
             
-            float oversample_rate = sample_rate * aa_filter_.GetOversamplingFactor();
+            float oversample_rate = sample_rate * down_filter_.GetOversamplingFactor();
             float freq_cut = 1.f / (2.f * M_PI * kFreqAmpR * kFreqAmpC);
             float res_cut  = 1.f / (2.f * M_PI * kResAmpR  * kResAmpC);
             float ff_cut = 1.f / (2.f * M_PI * kFeedforwardR * kFeedforwardC);
             
-            auto cutoffs = simd::float_4(ff_cut, freq_cut, res_cut, 0.f);
-            rc_filters_.setCutoffFreq(cutoffs / oversample_rate);
+            ff_filter_.setCutoffFreq(simd::float_4(ff_cut / oversample_rate));
+            freq_filter_.setCutoffFreq(simd::float_4(freq_cut / oversample_rate));
+            res_filter_.setCutoffFreq(simd::float_4(res_cut / oversample_rate));
+            // The spare lane repeats the feedforward cutoff; a zero cutoff
+            // would fill it with NaN.
+            voice_rc_.setCutoffFreq(simd::float_4(ff_cut, freq_cut, res_cut, ff_cut) / oversample_rate);
         }
         
-        float process(float input, float freq_knob, float res_knob, float fm_cv) {
-            float v_oct = 0.f;
-            v_oct += (freq_knob - 1.f) * kFreqKnobVoltage;
-            v_oct += fm_cv;
-            v_oct = std::min(v_oct, 0.f);
+        // Hands lane 0 between the four-voice and the packed layout. Lanes
+        // 1-3 come back with their cells and audio path at rest and their
+        // control paths where lane 0's are.
+        void setSingleVoice(bool single) {
+            if (single == single_voice_)
+                return;
+            single_voice_ = single;
+            if (single) {
+                voice_cells_ = simd::float_4(cell_voltage_[0][0], cell_voltage_[1][0], cell_voltage_[2][0], cell_voltage_[3][0]);
+                voice_filter_.CopyUpState(up_filter_, [](const EngineInputs& x) {
+                    return simd::float_4(x.audio[0], x.v_oct[0], x.i_reso[0], 0.f);
+                });
+                voice_filter_.CopyDownState(down_filter_, [](simd::float_4 x) {
+                    return simd::float_4(x[0], 0.f, 0.f, 0.f);
+                });
+                voice_rc_.xstate[0] = simd::float_4(ff_filter_.xstate[0][0], freq_filter_.xstate[0][0], res_filter_.xstate[0][0], 0.f);
+                voice_rc_.ystate[0] = simd::float_4(ff_filter_.ystate[0][0], freq_filter_.ystate[0][0], res_filter_.ystate[0][0], 0.f);
+            } else {
+                for (int n = 0; n < 4; n++) {
+                    cell_voltage_[n] = simd::float_4(voice_cells_[n], 0.f, 0.f, 0.f);
+                }
+                up_filter_.CopyUpState(voice_filter_, [](simd::float_4 x) {
+                    return EngineInputs(simd::float_4(x[0], 0.f, 0.f, 0.f), simd::float_4(x[1]), simd::float_4(x[2]));
+                });
+                down_filter_.CopyDownState(voice_filter_, [](simd::float_4 x) {
+                    return simd::float_4(x[0], 0.f, 0.f, 0.f);
+                });
+                simd::float_4 x = voice_rc_.xstate[0];
+                simd::float_4 y = voice_rc_.ystate[0];
+                ff_filter_.xstate[0] = simd::float_4(x[0], 0.f, 0.f, 0.f);
+                ff_filter_.ystate[0] = simd::float_4(y[0], 0.f, 0.f, 0.f);
+                freq_filter_.xstate[0] = simd::float_4(x[1]);
+                freq_filter_.ystate[0] = simd::float_4(y[1]);
+                res_filter_.xstate[0] = simd::float_4(x[2]);
+                res_filter_.ystate[0] = simd::float_4(y[2]);
+            }
+        }
+        
+        // With setSingleVoice() on, only lane 0 is processed, and its output
+        // fills every lane.
+        simd::float_4 process(simd::float_4 input, simd::float_4 freq_knob, simd::float_4 res_knob, simd::float_4 fm_cv) {
+            if (single_voice_)
+                return simd::float_4(ProcessVoice(input[0], freq_knob[0], res_knob[0], fm_cv[0]));
+            
+            simd::float_4 v_oct = (freq_knob - 1.f) * kFreqKnobVoltage + fm_cv;
+            v_oct = simd::fmin(v_oct, 0.f);
             
-            float i_reso = VtoIConverter(kResAmpR, 0.f, kResInputR, res_knob * kResKnobV, kResKnobR);
+            simd::float_4 i_reso = VtoIConverter(kResAmpR, 0.f, kResInputR, res_knob * kResKnobV, kResKnobR);
             
-            int oversampling_factor = aa_filter_.GetOversamplingFactor();
+            int oversampling_factor = down_filter_.GetOversamplingFactor();
             float timestep = sample_time_ / oversampling_factor;
-            float audio_input = input + 1e-6 * (random::uniform() - 0.5f);
-            auto inputs = simd::float_4(audio_input, v_oct, i_reso, 0.f);
-            inputs *= oversampling_factor;
+            simd::float_4 audio_input = input + 1e-6f * (random::uniform() - 0.5f);
+            EngineInputs inputs(audio_input * oversampling_factor, v_oct * oversampling_factor, i_reso * oversampling_factor);
             simd::float_4 outputs;
             
             for (int i = 0; i < oversampling_factor; i++) {
-                inputs = aa_filter_.ProcessUp((i == 0) ? inputs : 0.f);
-                outputs = CoreProcess(inputs, timestep);
-                outputs = aa_filter_.ProcessDown(outputs);
+                EngineInputs upsampled = up_filter_.ProcessUp((i == 0) ? inputs : EngineInputs(0.f));
+                outputs = CoreProcess(upsampled.audio, upsampled.v_oct, upsampled.i_reso, timestep);
+                outputs = down_filter_.ProcessDown(outputs);
             }
             
-            return outputs[0];
+            return outputs;
+        }
+        
+        // Whether all four cells and the audio path through both AA filters
+        // are below `threshold` in every voice. v_oct and i_reso are steady
+        // control voltages, so their upsampling state is left out.
+        int getOversamplingFactor() {
+            return down_filter_.GetOversamplingFactor();
+        }
+        
+        bool isQuiet(float threshold) const {
+            if (single_voice_) {
+                return simd::movemask(simd::abs(voice_cells_) < threshold) == 0xf
+                    && voice_filter_.IsQuiet([=](simd::float_4 x) { return std::fabs(x[0]) < threshold; });
+            }
+            simd::float_4 quiet = simd::abs(cell_voltage_[0]) < threshold;
+            for (int n = 1; n < 4; n++) {
+                quiet = quiet & (simd::abs(cell_voltage_[n]) < threshold);
+            }
+            if (simd::movemask(quiet) != 0xf)
+                return false;
+            auto below = [=](simd::float_4 x) {
+                return simd::movemask(simd::abs(x) < threshold) == 0xf;
+            };
+            return down_filter_.IsQuiet(below)
+                && up_filter_.IsQuiet([=](const EngineInputs& x) { return below(x.audio); });
         }
         
     private:
-        simd::float_4 CoreProcess(simd::float_4 inputs, float timestep) {
-            rc_filters_.process(inputs);
+        float ProcessVoice(float input, float freq_knob, float res_knob, float fm_cv) {
+            float v_oct = std::min((freq_knob - 1.f) * kFreqKnobVoltage + fm_cv, 0.f);
+            float i_reso = VtoIConverter(kResAmpR, 0.f, kResInputR, simd::float_4(res_knob * kResKnobV), kResKnobR)[0];
+            
+            int oversampling_factor = voice_filter_.GetOversamplingFactor();
+            float timestep = sample_time_ / oversampling_factor;
+            float audio_input = input + 1e-6f * (random::uniform() - 0.5f);
+            simd::float_4 inputs = simd::float_4(audio_input, v_oct, i_reso, 0.f) * oversampling_factor;
+            simd::float_4 outputs;
+            
+            for (int i = 0; i < oversampling_factor; i++) {
+                simd::float_4 upsampled = voice_filter_.ProcessUp((i == 0) ? inputs : simd::float_4(0.f));
+                outputs = voice_filter_.ProcessDown(simd::float_4(CoreProcessVoice(upsampled, timestep), 0.f, 0.f, 0.f));
+            }
             
-            simd::float_4 control = rc_filters_.lowpass();
-            float v_oct = control[1];
-            float i_reso = control[2];
+            return outputs[0];
+        }
+        
+        // CoreProcess() for the packed voice.
+        float CoreProcessVoice(simd::float_4 upsampled, float timestep) {
+            voice_rc_.process(upsampled);
+            voice_rc_.ystate[0] = flushDenormal(voice_rc_.ystate[0]);
             
-            float feedforward = rc_filters_.highpass()[0];
+            simd::float_4 lowpass = voice_rc_.lowpass();
+            float v_oct = lowpass[1];
+            float i_reso = lowpass[2];
+            float feedforward = voice_rc_.highpass()[0];
             
-            simd::float_4 rad_per_s = -std::exp2f(v_oct) / kFilterCellRC;
+            float rad_per_s = -fastExp2(v_oct) / kFilterCellRC;
+            float vp = feedforward * kFeedforwardGain;
+            float in = upsampled[0] * kFilterInputGain;
             
-            cell_voltage_ = StepRK2(timestep, cell_voltage_, [&](simd::float_4 vout) {
-                simd::float_4 vin = _mm_shuffle_ps(vout.v, vout.v, _MM_SHUFFLE(2, 1, 0, 3));
-                
-                float vp = feedforward * kFeedforwardGain;
-                float vn = vout[3] * kFeedbackGain;
-                float res = kFilterCellR * OTAVCA(vp, vn, i_reso);
-                simd::float_4 in = inputs[0] * kFilterInputGain + res;
-                
-                vin = _mm_move_ss(vin.v, in.v);
-                
-                simd::float_4 vsum = vin + vout;
-                simd::float_4 dvout = rad_per_s * vsum;
-                
-                dvout *= (1.f + vsum * kFilterCellSelfModulation);
-                
-                return dvout;
-            });
+            simd::float_4 k1 = VoiceDerivatives(voice_cells_, rad_per_s, vp, in, i_reso);
+            simd::float_4 k2 = VoiceDerivatives(voice_cells_ + k1 * timestep / 2.f, rad_per_s, vp, in, i_reso);
+            voice_cells_ = flushDenormal(simd::clamp(voice_cells_ + timestep * k2, -kOpampSatV, kOpampSatV));
             
-            cell_voltage_ = simd::clamp(cell_voltage_, -kOpampSatV, kOpampSatV);
+            return (voice_cells_[0] + voice_cells_[1]) * kBP2Gain;
+        }
+        
+        // CellDerivatives() for the packed voice: lane n is driven by lane
+        // n - 1, lane 0 by the input plus the resonance feedback.
+        simd::float_4 VoiceDerivatives(simd::float_4 vout, float rad_per_s, float vp, float in, float i_reso) {
+            float res = kFilterCellR * OTAVCA(vp, vout[3] * kFeedbackGain, i_reso);
+            simd::float_4 vin(in + res, vout[0], vout[1], vout[2]);
+            simd::float_4 vsum = vin + vout;
+            return rad_per_s * vsum * (1.f + vsum * kFilterCellSelfModulation);
+        }
+        
+        simd::float_4 CoreProcess(simd::float_4 audio, simd::float_4 v_oct_in, simd::float_4 i_reso_in, float timestep) {
+            ff_filter_.process(audio);
+            freq_filter_.process(v_oct_in);
+            res_filter_.process(i_reso_in);
+            // With the freq knob fully up or the decay at zero, v_oct or
+            // i_reso settle to exactly 0 and the lowpass states decay with it.
+            freq_filter_.ystate[0] = flushDenormal(freq_filter_.ystate[0]);
+            res_filter_.ystate[0] = flushDenormal(res_filter_.ystate[0]);
+            
+            simd::float_4 v_oct = freq_filter_.lowpass();
+            simd::float_4 i_reso = res_filter_.lowpass();
+            simd::float_4 feedforward = ff_filter_.highpass();
+            
+            simd::float_4 rad_per_s = -fastExp2(v_oct) / kFilterCellRC;
+            simd::float_4 vp = feedforward * kFeedforwardGain;
+            simd::float_4 in = audio * kFilterInputGain;
             
-            float lp1 = cell_voltage_[0];
-            float lp2 = cell_voltage_[1];
-            float bp2 = (lp1 + lp2) * kBP2Gain;
+            simd::float_4 k1[4];
+            simd::float_4 k2[4];
+            simd::float_4 mid[4];
+            CellDerivatives(cell_voltage_, k1, rad_per_s, vp, in, i_reso);
+            for (int n = 0; n < 4; n++) {
+                mid[n] = cell_voltage_[n] + k1[n] * timestep / 2.f;
+            }
+            CellDerivatives(mid, k2, rad_per_s, vp, in, i_reso);
+            for (int n = 0; n < 4; n++) {
+                cell_voltage_[n] = flushDenormal(simd::clamp(cell_voltage_[n] + timestep * k2[n], -kOpampSatV, kOpampSatV));
+            }
             
-            return simd::float_4(bp2, 0.f, 0.f, 0.f);
+            simd::float_4 lp1 = cell_voltage_[0];
+            simd::float_4 lp2 = cell_voltage_[1];
+            return (lp1 + lp2) * kBP2Gain;
         }
         
-        template <typename T, typename F>
-        T StepRK2(float dt, T y, F f) {
-            T k1 = f(y);
-            T k2 = f(y + k1 * dt / 2.f);
-            return y + dt * k2;
+        // Each cell is driven by the one before it; the first by the input
+        // plus the OTA resonance feedback taken from the last.
+        void CellDerivatives(const simd::float_4* vout, simd::float_4* dvout, simd::float_4 rad_per_s,
+                             simd::float_4 vp, simd::float_4 in, simd::float_4 i_reso) {
+            simd::float_4 vn = vout[3] * kFeedbackGain;
+            simd::float_4 res = kFilterCellR * OTAVCA(vp, vn, i_reso);
+            
+            for (int n = 0; n < 4; n++) {
+                simd::float_4 vin = (n == 0) ? in + res : vout[n - 1];
+                simd::float_4 vsum = vin + vout[n];
+                dvout[n] = rad_per_s * vsum * (1.f + vsum * kFilterCellSelfModulation);
+            }
         }
         
-        float VtoIConverter(float rfb, float vc, float rc, float vp = 0.f, float rp = 1e12f) {
-            float vnom = -(vc * rfb / rc + vp * rfb / rp);
-            float vout = std::max(vnom, kVtoICollectorVSat);
+        simd::float_4 VtoIConverter(float rfb, float vc, float rc, simd::float_4 vp, float rp) {
+            simd::float_4 vnom = -(vc * rfb / rc + vp * rfb / rp);
+            simd::float_4 vout = simd::fmax(vnom, kVtoICollectorVSat);
             float nrc = rp * rfb;
             float nrp = rc * rfb;
             float nrfb = rc * rp;
-            float vneg = (vc * nrc + vp * nrp + vout * nrfb) / (nrc + nrp + nrfb);
-            float iout = (vneg - vout) / rfb;
-            return std::max(iout, 0.f);
+            simd::float_4 vneg = (vc * nrc + vp * nrp + vout * nrfb) / (nrc + nrp + nrfb);
+            simd::float_4 iout = (vneg - vout) / rfb;
+            return simd::fmax(iout, 0.f);
         }
         
         template <typename T>
@@ -394,79 +417,146 @@ struct Pinpple : Module {
         }
     };
 
+    // Four voices, one per lane, like the engine. Each lane's cutoff follows
+    // its own envelope, so the lowpass coefficients are worked out per lane
+    // rather than through BiquadFilter::setParameters().
     struct SimpleLPG {
-        dsp::SchmittTrigger trigger;
-        dsp::BiquadFilter lpf;
-        float env = 0.0f;
+        dsp::SchmittTrigger trigger[4];
+        simd::float_4 env = 0.0f;
+        // Lane masks.
+        simd::float_4 attacking = 0.0f;
+        simd::float_4 decaying = 0.0f;
         float attackTime = 0.00001f;
-        float decayTime = 0.05f;
-        bool attacking = false;
-        bool decaying = false;
         float sampleRate = 44100.0f;
         
+        simd::float_4 b0 = 0.0f;
+        simd::float_4 a1 = 0.0f;
+        simd::float_4 a2 = 0.0f;
+        simd::float_4 x[2] = {0.0f, 0.0f};
+        simd::float_4 y[2] = {0.0f, 0.0f};
+        
         void setSampleRate(float sr) {
             sampleRate = sr;
         }
         
         void reset() {
-            trigger.reset();
+            for (int i = 0; i < 4; i++) {
+                trigger[i].reset();
+            }
             env = 0.0f;
-            attacking = false;
-            decaying = false;
+            attacking = 0.0f;
+            decaying = 0.0f;
+        }
+        
+        bool isClosed() const {
+            return simd::movemask(attacking | decaying | (env != 0.0f)) == 0;
+        }
+        
+        // tan(x) for 0 <= x < 1.45, within 1e-5.
+        static simd::float_4 tanApprox(simd::float_4 x) {
+            x = simd::fmin(x, 1.45f);
+            simd::float_4 x2 = x * x;
+            return x * (945.0f - x2 * (105.0f - x2)) / (945.0f - x2 * (420.0f - 15.0f * x2));
         }
         
-        float process(float triggerInput, float resonanceParam, float input, float vcaAmount, float sampleTime) {
-            if (trigger.process(triggerInput)) {
-                attacking = true;
-                decaying = false;
-                env = 0.0f;
+        simd::float_4 filter(simd::float_4 input) {
+            simd::float_4 out = b0 * (input + 2.0f * x[0] + x[1]) - a1 * y[0] - a2 * y[1];
+            x[1] = x[0];
+            x[0] = input;
+            y[1] = y[0];
+            y[0] = flushDenormal(out);
+            return y[0];
+        }
+        
+        // Keeps the filter following its input while the gate is closed, so
+        // it opens on the same state it would have had. The cutoff is parked
+        // at its minimum then, so the coefficients need no update.
+        void track(simd::float_4 input) {
+            filter(input);
+        }
+        
+        simd::float_4 process(simd::float_4 triggerInput, simd::float_4 resonanceParam, simd::float_4 input, simd::float_4 vcaAmount, float sampleTime) {
+            float triggered[4];
+            for (int i = 0; i < 4; i++) {
+                triggered[i] = trigger[i].process(triggerInput[i]) ? 1.0f : 0.0f;
             }
+            simd::float_4 retrigger = simd::float_4::load(triggered) > 0.0f;
+            attacking = attacking | retrigger;
+            decaying = simd::ifelse(retrigger, 0.0f, decaying);
+            env = simd::ifelse(retrigger, 0.0f, env);
             
-            if (attacking) {
-                env += sampleTime / attackTime;
-                if (env >= 1.0f) {
-                    env = 1.0f;
-                    attacking = false;
-                    decaying = true;
-                }
-            }
+            env = simd::ifelse(attacking, env + sampleTime / attackTime, env);
+            simd::float_4 attacked = attacking & (env >= 1.0f);
+            env = simd::ifelse(attacked, 1.0f, env);
+            attacking = simd::ifelse(attacked, 0.0f, attacking);
+            decaying = decaying | attacked;
             
-            if (decaying) {
-                decayTime = 0.01f + resonanceParam * 0.5f;
-                float decayRate = 1.0f / decayTime;
-                env -= env * decayRate * sampleTime * 10.0f;
-                if (env <= 0.001f) {
-                    env = 0.0f;
-                    decaying = false;
-                }
-            }
+            simd::float_4 decayTime = 0.01f + resonanceParam * 0.5f;
+            simd::float_4 decayRate = 1.0f / decayTime;
+            env = simd::ifelse(decaying, env - env * decayRate * sampleTime * 10.0f, env);
+            simd::float_4 decayed = decaying & (env <= 0.001f);
+            env = simd::ifelse(decayed, 0.0f, env);
+            decaying = simd::ifelse(decayed, 0.0f, decaying);
             
-            float cutoffFreq = 200.0f + env * 18000.0f;
-            lpf.setParameters(dsp::BiquadFilter::LOWPASS, cutoffFreq / sampleRate, 0.707f, 1.0f);
+            const float Q = 0.707f;
+            simd::float_4 cutoffFreq = 200.0f + env * 18000.0f;
+            simd::float_4 K = tanApprox(cutoffFreq * ((float) M_PI / sampleRate));
+            simd::float_4 K2 = K * K;
+            simd::float_4 norm = 1.0f / (1.0f + K / Q + K2);
+            b0 = K2 * norm;
+            a1 = 2.0f * (K2 - 1.0f) * norm;
+            a2 = (1.0f - K / Q + K2) * norm;
             
-            float filtered = lpf.process(input);
-            float level = vcaAmount * env;
+            simd::float_4 filtered = filter(input);
+            simd::float_4 level = vcaAmount * env;
             return filtered * level;
         }
     };
 
-    RipplesBPFEngine bpfEngine;
-    TriggerGenerator trigGen;
-    SimpleLPG lpg;
+    // Idle detection, per group of four voices: once every LPG in the group
+    // is closed and its resonators have rung out, the engine state is frozen
+    // and process() only watches for a trigger or a freq/decay change. The
+    // closed LPG blocks the FM/noise input, so nothing else can excite the
+    // resonator while it sleeps; only the LPG's own filter keeps running.
+    struct VoiceGroup {
+        RipplesBPFEngine bpfEngine;
+        SimpleLPG lpg;
+        int idleSamples = 0;
+        bool sleeping = false;
+        simd::float_4 sleepFreq = 0.0f;
+        simd::float_4 sleepResonance = 0.0f;
+        
+        void setSampleRate(float sr) {
+            bpfEngine.setSampleRate(sr);
+            lpg.setSampleRate(sr);
+            idleSamples = 0;
+            sleeping = false;
+        }
+    };
+
+    static const int kMaxVoices = PORT_MAX_CHANNELS;
+    static const int kNumGroups = kMaxVoices / 4;
+
+    VoiceGroup groups[kNumGroups];
+    TriggerGenerator trigGens[kMaxVoices];
     PinkNoiseGenerator<8> pinkNoiseGenerator;
     float lastPink = 0.0f;
     
 public:
-    RandomModulation randomMod;
+    RandomModulation randomMod[kMaxVoices];
     
     float originalFreqParam = 0.5f;
     float originalResonanceParam = 0.5f;
     
     dsp::SchmittTrigger muteTrigger;
     bool muteState = false;
+    int voicesStat, awakeStat, oversamplingStat;
     
     Pinpple() {
         config(PARAMS_LEN, INPUTS_LEN, OUTPUTS_LEN, LIGHTS_LEN);
+        voicesStat = perf.addStat("voices", PerfMeter::MEAN);
+        awakeStat = perf.addStat("awake", PerfMeter::MEAN);
+        oversamplingStat = perf.addStat("oversampling", PerfMeter::MEAN);
         
         configParam(FREQ_PARAM, std::log2(kFreqKnobMin), std::log2(kFreqKnobMax), std::log2(kFreqKnobMax), "Frequency", " Hz", 2.f);
         configParam(RESONANCE_PARAM, 0.0f, 1.0f, 0.5f, "Decay");
@@ -491,49 +581,42 @@ public:
 
     void onSampleRateChange() override {
         float sr = APP->engine->getSampleRate();
-        bpfEngine.setSampleRate(sr);
-        lpg.setSampleRate(sr);
+        for (int g = 0; g < kNumGroups; g++) {
+            groups[g].setSampleRate(sr);
+        }
     }
 
     void process(const ProcessArgs& args) override {
+        PerfMeter::Scope perfScope(perf, args.sampleRate);
         if (muteTrigger.process(params[MUTE_PARAM].getValue())) {
             muteState = !muteState;
             params[MUTE_PARAM].setValue(muteState ? 1.0f : 0.0f);
         }
         
-        float triggerInput = inputs[TRIG_INPUT].getVoltage();
-        bool newTrigger = trigGen.process(triggerInput);
-        if (newTrigger) {
-            randomMod.trigger();
+        int channels = std::max({1, inputs[TRIG_INPUT].getChannels(), inputs[FREQ_CV_INPUT].getChannels(),
+                                 inputs[RESONANCE_CV_INPUT].getChannels(), inputs[FM_INPUT].getChannels()});
+        
+        float pingInput[kMaxVoices] = {};
+        float trigger2ms[kMaxVoices] = {};
+        float freqOffset[kMaxVoices] = {};
+        float decayOffset[kMaxVoices] = {};
+        for (int c = 0; c < channels; c++) {
+            float triggerInput = inputs[TRIG_INPUT].getPolyVoltage(c);
+            if (trigGens[c].process(triggerInput)) {
+                randomMod[c].trigger();
+                pingInput[c] = 10.0f;
+            }
+            trigger2ms[c] = trigGens[c].getTrigger(args.sampleTime);
+            freqOffset[c] = randomMod[c].freqOffset;
+            decayOffset[c] = randomMod[c].decayOffset;
         }
-        float trigger2ms = trigGen.getTrigger(args.sampleTime);
         
         float freqParam = rescale(params[FREQ_PARAM].getValue(), std::log2(kFreqKnobMin), std::log2(kFreqKnobMax), 0.f, 1.f);
-        float freqCV = 0.0f;
-        if (inputs[FREQ_CV_INPUT].isConnected()) {
-            float freqCVAttenuation = params[FREQ_CV_ATTEN_PARAM].getValue();
-            freqCV = inputs[FREQ_CV_INPUT].getVoltage() * freqCVAttenuation;
-        }
-        float finalFreq = clamp(freqParam + freqCV * 0.1f + randomMod.freqOffset, 0.0f, 1.0f);
-        
+        float freqCVAttenuation = params[FREQ_CV_ATTEN_PARAM].getValue();
         float resonanceParam = params[RESONANCE_PARAM].getValue();
-        float resonanceCV = 0.0f;
-        if (inputs[RESONANCE_CV_INPUT].isConnected()) {
-            float resonanceCVAttenuation = params[RESONANCE_CV_ATTEN_PARAM].getValue();
-            resonanceCV = inputs[RESONANCE_CV_INPUT].getVoltage() / 10.0f * resonanceCVAttenuation;
-        }
-        float finalResonance = clamp(resonanceParam + resonanceCV + randomMod.decayOffset, 0.0f, 1.0f);
-        
+        float resonanceCVAttenuation = params[RESONANCE_CV_ATTEN_PARAM].getValue();
         float fmAmountParam = params[FM_AMOUNT_PARAM].getValue();
-        
-        float fmModCV = 0.0f;
-        if (inputs[FM_MOD_CV_INPUT].isConnected()) {
-            float fmModCVAttenuation = params[FM_MOD_CV_ATTEN_PARAM].getValue();
-            fmModCV = inputs[FM_MOD_CV_INPUT].getVoltage() / 10.0f * fmModCVAttenuation;
-        }
-        
-        float dynamicFMAmount = clamp(fmAmountParam + fmModCV, 0.0f, 1.0f);
-        
+        float fmModCVAttenuation = params[FM_MOD_CV_ATTEN_PARAM].getValue();
         float noiseMixParam = params[NOISE_MIX_PARAM].getValue();
         
         float pinkNoise = pinkNoiseGenerator.process() / 0.816f;
@@ -544,40 +627,87 @@ public:
         pinkNoise *= noiseGain * 0.8f;
         blueNoise *= noiseGain * 1.5f;
         
-        float fmInput = inputs[FM_INPUT].getVoltage();
-        float mixedInput;
-        
-        if (noiseMixParam <= 0.5f) {
-            float mix = noiseMixParam * 2.0f;
-            mixedInput = pinkNoise * (1.0f - mix) + fmInput * mix;
-        } else {
-            float mix = (noiseMixParam - 0.5f) * 2.0f;
-            mixedInput = fmInput * (1.0f - mix) + blueNoise * mix;
-        }
-        
-        float processedFM = lpg.process(trigger2ms, finalResonance, mixedInput, dynamicFMAmount, args.sampleTime);
-        
-        float pingInput = newTrigger ? 10.0f : 0.0f;
-        float bpfOutput = bpfEngine.process(pingInput, finalFreq, finalResonance, processedFM);
-        
         bool isMuted = muteState;
         float volume = params[VOLUME_PARAM].getValue();
-        float finalOutput = isMuted ? 0.0f : bpfOutput * volume;
-        
         lights[MUTE_LIGHT].setBrightness(isMuted ? 1.0f : 0.0f);
         
-        outputs[OUT_OUTPUT].setVoltage(finalOutput);
+        outputs[OUT_OUTPUT].setChannels(channels);
+        perf.add(voicesStat, channels);
+        perf.add(oversamplingStat, groups[0].bpfEngine.getOversamplingFactor());
+        groups[0].bpfEngine.setSingleVoice(channels == 1);
+        
+        for (int c = 0; c < channels; c += 4) {
+            VoiceGroup& group = groups[c / 4];
+            
+            simd::float_4 freqCV = 0.0f;
+            if (inputs[FREQ_CV_INPUT].isConnected()) {
+                freqCV = inputs[FREQ_CV_INPUT].getPolyVoltageSimd<simd::float_4>(c) * freqCVAttenuation;
+            }
+            simd::float_4 finalFreq = simd::clamp(freqParam + freqCV * 0.1f + simd::float_4::load(&freqOffset[c]), 0.0f, 1.0f);
+            
+            simd::float_4 resonanceCV = 0.0f;
+            if (inputs[RESONANCE_CV_INPUT].isConnected()) {
+                resonanceCV = inputs[RESONANCE_CV_INPUT].getPolyVoltageSimd<simd::float_4>(c) / 10.0f * resonanceCVAttenuation;
+            }
+            simd::float_4 finalResonance = simd::clamp(resonanceParam + resonanceCV + simd::float_4::load(&decayOffset[c]), 0.0f, 1.0f);
+            
+            simd::float_4 fmModCV = 0.0f;
+            if (inputs[FM_MOD_CV_INPUT].isConnected()) {
+                fmModCV = inputs[FM_MOD_CV_INPUT].getPolyVoltageSimd<simd::float_4>(c) / 10.0f * fmModCVAttenuation;
+            }
+            simd::float_4 dynamicFMAmount = simd::clamp(fmAmountParam + fmModCV, 0.0f, 1.0f);
+            
+            simd::float_4 fmInput = inputs[FM_INPUT].getPolyVoltageSimd<simd::float_4>(c);
+            simd::float_4 mixedInput;
+            
+            if (noiseMixParam <= 0.5f) {
+                float mix = noiseMixParam * 2.0f;
+                mixedInput = pinkNoise * (1.0f - mix) + fmInput * mix;
+            } else {
+                float mix = (noiseMixParam - 0.5f) * 2.0f;
+                mixedInput = fmInput * (1.0f - mix) + blueNoise * mix;
+            }
+            
+            simd::float_4 ping = simd::float_4::load(&pingInput[c]);
+            simd::float_4 pulse = simd::float_4::load(&trigger2ms[c]);
+            bool triggered = simd::movemask((ping != 0.0f) | (pulse != 0.0f)) != 0;
+            
+            if (group.sleeping) {
+                simd::float_4 moved = (simd::abs(finalFreq - group.sleepFreq) >= kIdleWakeDelta)
+                    | (simd::abs(finalResonance - group.sleepResonance) >= kIdleWakeDelta);
+                if (!triggered && simd::movemask(moved) == 0) {
+                    group.lpg.track(mixedInput);
+                    outputs[OUT_OUTPUT].setVoltageSimd(simd::float_4(0.0f), c);
+                    continue;
+                }
+                group.sleeping = false;
+                group.idleSamples = 0;
+            }
+            perf.add(awakeStat, std::min(4, channels - c));
+            
+            simd::float_4 processedFM = group.lpg.process(pulse, finalResonance, mixedInput, dynamicFMAmount, args.sampleTime);
+            simd::float_4 bpfOutput = group.bpfEngine.process(ping, finalFreq, finalResonance, processedFM);
+            
+            simd::float_4 finalOutput = isMuted ? simd::float_4(0.0f) : bpfOutput * volume;
+            outputs[OUT_OUTPUT].setVoltageSimd(finalOutput, c);
+            
+            if (!triggered && group.lpg.isClosed() && simd::movemask(simd::abs(bpfOutput) < kIdleThresholdV) == 0xf
+                && group.bpfEngine.isQuiet(kIdleThresholdV)) {
+                if (++group.idleSamples >= (int)(kIdleHoldTime * args.sampleRate)) {
+                    group.sleeping = true;
+                    group.sleepFreq = finalFreq;
+                    group.sleepResonance = finalResonance;
+                }
+            } else {
+                group.idleSamples = 0;
+            }
+        }
     }
 };
 
-struct RandomizedKnob : ParamWidget {
+struct RandomizedKnob : LargeBlackKnob {
     Module* module = nullptr;
     int paramId = -1;
-    bool isDragging = false;
-    
-    RandomizedKnob() {
-        box.size = Vec(30, 30);
-    }
     
     float getVisualValue() {
         ParamQuantity* pq = getParamQuantity();
@@ -590,9 +720,9 @@ struct RandomizedKnob : ParamWidget {
             Pinpple* pinppleModule = dynamic_cast<Pinpple*>(module);
             if (pinppleModule) {
                 if (paramId == Pinpple::FREQ_PARAM) {
-                    randomOffset = pinppleModule->randomMod.freqOffset * 80.0f;
+                    randomOffset = pinppleModule->randomMod[0].freqOffset * 80.0f;
                 } else if (paramId == Pinpple::RESONANCE_PARAM) {
-                    randomOffset = pinppleModule->randomMod.decayOffset * 80.0f;
+                    randomOffset = pinppleModule->randomMod[0].decayOffset * 80.0f;
                 }
             }
         }
@@ -601,7 +731,7 @@ struct RandomizedKnob : ParamWidget {
         return clamp(visualValue, pq->getMinValue(), pq->getMaxValue());
     }
     
-    float getDisplayAngle() {
+    float getDisplayAngle() override {
         ParamQuantity* pq = getParamQuantity();
         if (!pq) return 0.0f;
         
@@ -612,137 +742,18 @@ struct RandomizedKnob : ParamWidget {
         return angle;
     }
     
-    void draw(const DrawArgs& args) override {
-        float radius = box.size.x / 2.0f;
-        float angle = getDisplayAngle();
-        
-        nvgBeginPath(args.vg);
-        nvgCircle(args.vg, radius, radius, radius - 1);
-        nvgFillColor(args.vg, nvgRGB(30, 30, 30));
-        nvgFill(args.vg);
-        
-        nvgBeginPath(args.vg);
-        nvgCircle(args.vg, radius, radius, radius - 1);
-        nvgStrokeWidth(args.vg, 1.0f);
-        nvgStrokeColor(args.vg, nvgRGB(100, 100, 100));
-        nvgStroke(args.vg);
-        
-        nvgBeginPath(args.vg);
-        nvgCircle(args.vg, radius, radius, radius - 4);
-        nvgFillColor(args.vg, nvgRGB(50, 50, 50));
-        nvgFill(args.vg);
-        
-        float indicatorLength = radius - 8;
-        float lineX = radius + indicatorLength * std::sin(angle);
-        float lineY = radius - indicatorLength * std::cos(angle);
-        
-        nvgBeginPath(args.vg);
-        nvgMoveTo(args.vg, radius, radius);
-        nvgLineTo(args.vg, lineX, lineY);
-        nvgStrokeWidth(args.vg, 2.0f);
-        nvgStrokeColor(args.vg, nvgRGB(255, 255, 255));
-        nvgStroke(args.vg);
-        
-        nvgBeginPath(args.vg);
-        nvgCircle(args.vg, lineX, lineY, 2.0f);
-        nvgFillColor(args.vg, nvgRGB(255, 255, 255));
-        nvgFill(args.vg);
-    }
-    
-    void onButton(const event::Button& e) override {
-        if (e.action == GLFW_PRESS && e.button == GLFW_MOUSE_BUTTON_LEFT) {
-            isDragging = true;
-            e.consume(this);
-        }
-        else if (e.action == GLFW_RELEASE && e.button == GLFW_MOUSE_BUTTON_LEFT) {
-            isDragging = false;
-        }
-        ParamWidget::onButton(e);
-    }
-    
-    void onDragMove(const event::DragMove& e) override {
-        ParamQuantity* pq = getParamQuantity();
-        if (!isDragging || !pq) return;
-        
-        float sensitivity = 0.002f;
-        float deltaY = -e.mouseDelta.y;
-        
-        float range = pq->getMaxValue() - pq->getMinValue();
-        float currentValue = pq->getValue();
-        float newValue = currentValue + deltaY * sensitivity * range;
-        newValue = clamp(newValue, pq->getMinValue(), pq->getMaxValue());
-        
-        pq->setValue(newValue);
-    }
-    
-    void onDoubleClick(const event::DoubleClick& e) override {
-        ParamQuantity* pq = getParamQuantity();
-        if (!pq) return;
-        
-        pq->reset();
-        e.consume(this);
-    }
-    
     void step() override {
         ParamQuantity* pq = getParamQuantity();
         if (pq) {
             module = pq->module;
             paramId = pq->paramId;
         }
-        ParamWidget::step();
+        LargeBlackKnob::step();
     }
-};
-
-struct EnhancedTextLabel : TransparentWidget {
-    std::string text;
-    float fontSize;
-    NVGcolor color;
-    bool bold;
     
-    EnhancedTextLabel(Vec pos, Vec size, std::string text, float fontSize = 12.f, 
-                      NVGcolor color = nvgRGB(255, 255, 255), bool bold = true) {
-        box.pos = pos;
-        box.size = size;
-        this->text = text;
-        this->fontSize = fontSize;
-        this->color = color;
-        this->bold = bold;
-    }
-    
-    void draw(const DrawArgs &args) override {
-        nvgFontSize(args.vg, fontSize);
-        nvgFontFaceId(args.vg, APP->window->uiFont->handle);
-        nvgTextAlign(args.vg, NVG_ALIGN_CENTER | NVG_ALIGN_MIDDLE);
-        nvgFillColor(args.vg, color);
-        
-        if (bold) {
-            float offset = 0.3f;
-            nvgText(args.vg, box.size.x / 2.f - offset, box.size.y / 2.f, text.c_str(), NULL);
-            nvgText(args.vg, box.size.x / 2.f + offset, box.size.y / 2.f, text.c_str(), NULL);
-            nvgText(args.vg, box.size.x / 2.f, box.size.y / 2.f - offset, text.c_str(), NULL);
-            nvgText(args.vg, box.size.x / 2.f, box.size.y / 2.f + offset, text.c_str(), NULL);
-            nvgText(args.vg, box.size.x / 2.f, box.size.y / 2.f, text.c_str(), NULL);
-        } else {
-            nvgText(args.vg, box.size.x / 2.f, box.size.y / 2.f, text.c_str(), NULL);
-        }
-    }
-};
-
-struct WhiteBackgroundBox : Widget {
-    WhiteBackgroundBox(Vec pos, Vec size) {
-        box.pos = pos;
-        box.size = size;
-    }
-    
-    void draw(const DrawArgs &args) override {
-        nvgBeginPath(args.vg);
-        nvgRect(args.vg, 0, 0, box.size.x, box.size.y);
-        nvgFillColor(args.vg, nvgRGB(255, 255, 255));
-        nvgFill(args.vg);
-        
-        nvgStrokeWidth(args.vg, 1.0f);
-        nvgStrokeColor(args.vg, nvgRGBA(200, 200, 200, 255));
-        nvgStroke(args.vg);
+    // The random modulation moves the pointer too.
+    float cacheKey() override {
+        return getVisualValue();
     }
 };
 
@@ -825,6 +836,15 @@ addParam(createParamCentered<RandomizedKnob>(Vec(centerX, 226), module, Pinpple:
                 noiseMixQuantity->name = "LPG IN MIX";
                 module->paramQuantities[Pinpple::NOISE_MIX_PARAM] = noiseMixQuantity;
         }
+
+        addChild(new PerfReadout(module, box.size.x));
+    }
+
+    void appendContextMenu(Menu* menu) override {
+        Pinpple* module = getModule<Pinpple>();
+        if (!module) return;
+
+        appendPerfMenu(menu, module);
     }
 };
 
@@ -1,6 +1,11 @@
 #include "plugin.hpp"
+#include "cached.hpp"
+#include "envelope.hpp"
+#include "perf.hpp"
+#include "triplebuffer.hpp"
+#include "widgets.hpp"
 
-struct QQ : Module {
+struct QQ : MeteredModule {
     enum ParamIds {
         TRACK1_DECAY_TIME_PARAM,
         TRACK1_SHAPE_PARAM,
@@ -51,10 +56,21 @@ struct QQ : Module {
     
     static constexpr float ATTACK_TIME = 0.001f;
     static constexpr int SCOPE_BUFFER_SIZE = 128;
+    static constexpr float SCOPE_PUBLISH_RATE = 60.f;
+
+    // Oldest point first, so the display can draw it as it is.
+    struct ScopeFrame {
+        ScopePoint points[3][SCOPE_BUFFER_SIZE];
+    };
     
+    // Ring buffer written on the audio thread; unrolled into scopeFrames for
+    // the display at most SCOPE_PUBLISH_RATE times a second.
     ScopePoint scopeBuffer[3][SCOPE_BUFFER_SIZE];
     int scopeBufferIndex = 0;
     int scopeFrameIndex = 0;
+    bool scopePending = false;
+    int samplesSincePublish = 0;
+    TripleBuffer<ScopeFrame> scopeFrames;
 
     QQ() {
         config(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS);
@@ -93,28 +109,8 @@ struct QQ : Module {
         configLight(TRACK3_TRIG_LIGHT, "Track 3 Trigger");
     }
 
-    float smoothDecayEnvelope(float t, float totalTime, float shapeParam) {
-        if (t >= totalTime) return 0.f;
-        
-        float normalizedT = t / totalTime;
-        
-        float frontK = -0.9f + shapeParam * 0.5f;
-        float backK = -1.0f + 1.6f * std::pow(shapeParam, 0.3f);
-        
-        float transition = normalizedT * normalizedT * (3.f - 2.f * normalizedT);
-        float k = frontK + (backK - frontK) * transition;
-        
-        float absT = std::abs(normalizedT);
-        float denominator = k - 2.f * k * absT + 1.f;
-        if (std::abs(denominator) < 1e-10f) {
-            return 1.f - normalizedT;
-        }
-        
-        float curveResult = (normalizedT - k * normalizedT) / denominator;
-        return 1.f - curveResult;
-    }
-
     void process(const ProcessArgs& args) override {
+        PerfMeter::Scope perfScope(perf, args.sampleRate);
         for (int i = 0; i < 3; i++) {
             bool triggered = tracks[i].trigTrigger.process(inputs[TRACK1_TRIG_INPUT + i].getVoltage(), 0.1f, 2.f);
             
@@ -190,14 +186,32 @@ struct QQ : Module {
                 scopeBuffer[i][scopeBufferIndex].value = outputs[TRACK1_ENV_OUTPUT + i].getVoltage();
             }
             scopeBufferIndex = (scopeBufferIndex + 1) % SCOPE_BUFFER_SIZE;
+            scopePending = true;
+        }
+
+        samplesSincePublish++;
+        if (scopePending && samplesSincePublish >= args.sampleRate / SCOPE_PUBLISH_RATE) {
+            publishScope();
+        }
+    }
+
+    void publishScope() {
+        ScopeFrame& frame = scopeFrames.writeBuffer();
+        int head = SCOPE_BUFFER_SIZE - scopeBufferIndex;
+        for (int i = 0; i < 3; i++) {
+            std::memcpy(frame.points[i], scopeBuffer[i] + scopeBufferIndex, head * sizeof(ScopePoint));
+            std::memcpy(frame.points[i] + head, scopeBuffer[i], scopeBufferIndex * sizeof(ScopePoint));
         }
+        scopeFrames.publish();
+        scopePending = false;
+        samplesSincePublish = 0;
     }
 };
 
-struct StandardBlackKnob : ParamWidget {
+struct QQKnob : CachedParamWidget {
     bool isDragging = false;
     
-    StandardBlackKnob() {
+    QQKnob() {
         box.size = Vec(30, 30);
     }
     
@@ -210,7 +224,7 @@ struct StandardBlackKnob : ParamWidget {
         return angle;
     }
     
-    void draw(const DrawArgs& args) override {
+    void drawCached(const DrawArgs& args) override {
         float radius = box.size.x / 2.0f;
         float angle = getDisplayAngle();
         
@@ -282,59 +296,6 @@ struct StandardBlackKnob : ParamWidget {
     }
 };
 
-struct EnhancedTextLabel : Widget {
-    std::string text;
-    float fontSize;
-    NVGcolor color;
-    bool bold;
-    
-    EnhancedTextLabel(Vec pos, Vec size, const std::string& text, float fontSize = 12.f, 
-                      NVGcolor color = nvgRGB(255, 255, 255), bool bold = true) {
-        box.pos = pos;
-        box.size = size;
-        this->text = text;
-        this->fontSize = fontSize;
-        this->color = color;
-        this->bold = bold;
-    }
-    
-    void draw(const DrawArgs &args) override {
-        nvgFontSize(args.vg, fontSize);
-        nvgFontFaceId(args.vg, APP->window->uiFont->handle);
-        nvgTextAlign(args.vg, NVG_ALIGN_CENTER | NVG_ALIGN_MIDDLE);
-        nvgFillColor(args.vg, color);
-        
-        if (bold) {
-            float offset = 0.3f;
-            nvgText(args.vg, box.size.x / 2.f - offset, box.size.y / 2.f, text.c_str(), NULL);
-            nvgText(args.vg, box.size.x / 2.f + offset, box.size.y / 2.f, text.c_str(), NULL);
-            nvgText(args.vg, box.size.x / 2.f, box.size.y / 2.f - offset, text.c_str(), NULL);
-            nvgText(args.vg, box.size.x / 2.f, box.size.y / 2.f + offset, text.c_str(), NULL);
-            nvgText(args.vg, box.size.x / 2.f, box.size.y / 2.f, text.c_str(), NULL);
-        } else {
-            nvgText(args.vg, box.size.x / 2.f, box.size.y / 2.f, text.c_str(), NULL);
-        }
-    }
-};
-
-struct WhiteBackgroundBox : Widget {
-    WhiteBackgroundBox(Vec pos, Vec size) {
-        box.pos = pos;
-        box.size = size;
-    }
-    
-    void draw(const DrawArgs &args) override {
-        nvgBeginPath(args.vg);
-        nvgRect(args.vg, 0, 0, box.size.x, box.size.y);
-        nvgFillColor(args.vg, nvgRGB(255, 255, 255));
-        nvgFill(args.vg);
-        
-        nvgStrokeWidth(args.vg, 1.0f);
-        nvgStrokeColor(args.vg, nvgRGBA(200, 200, 200, 255));
-        nvgStroke(args.vg);
-    }
-};
-
 struct CVConnectionLine : Widget {
     int trackNumber;
     
@@ -432,9 +393,29 @@ struct HiddenAttenuatorKnob : ParamWidget {
 struct QQScopeDisplay : LedDisplay {
     QQ* module;
     ModuleWidget* moduleWidget;
+    // Trace heights (0-1 within a track) of the last frame taken from the
+    // module; only recomputed when the module has published a new one.
+    float waveY[3][QQ::SCOPE_BUFFER_SIZE];
     
     QQScopeDisplay() {
         box.size = Vec(60, 51);
+        for (int t = 0; t < 3; t++) {
+            for (int i = 0; i < QQ::SCOPE_BUFFER_SIZE; i++) {
+                waveY[t][i] = 1.f;
+            }
+        }
+    }
+
+    void updateWaves() {
+        if (!module->scopeFrames.consume())
+            return;
+        const QQ::ScopeFrame& frame = module->scopeFrames.readBuffer();
+        for (int t = 0; t < 3; t++) {
+            for (int i = 0; i < QQ::SCOPE_BUFFER_SIZE; i++) {
+                float value = clamp(frame.points[t][i].value, 0.f, 10.f);
+                waveY[t][i] = 1.f - (value / 10.f); // Invert for proper display
+            }
+        }
     }
     
     void drawWave(const DrawArgs& args, int track, NVGcolor color) {
@@ -452,12 +433,9 @@ struct QQScopeDisplay : LedDisplay {
         nvgBeginPath(args.vg);
         
         for (int i = 0; i < QQ::SCOPE_BUFFER_SIZE; i++) {
-            float value = module->scopeBuffer[track][(i + module->scopeBufferIndex) % QQ::SCOPE_BUFFER_SIZE].value;
-            value = clamp(value, 0.f, 10.f);
-            
             Vec p;
             p.x = (float)i / (QQ::SCOPE_BUFFER_SIZE - 1);
-            p.y = 1.f - (value / 10.f); // Invert for proper display
+            p.y = waveY[track][i];
             p = b.interpolate(p);
             
             if (i == 0)
@@ -525,6 +503,8 @@ struct QQScopeDisplay : LedDisplay {
         drawBackground(args);
         
         if (!module || !moduleWidget) return;
+
+        updateWaves();
         
         // Get input colors from cable connections
         for (int i = 0; i < 3; i++) {
@@ -557,13 +537,13 @@ struct QQWidget : ModuleWidget {
         addChild(new CVConnectionLine(Vec(0, 0), Vec(box.size.x, 120), 1));
         
         addChild(new EnhancedTextLabel(Vec(5, 55), Vec(20, 20), "DECAY", 8.f, nvgRGB(255, 255, 255), true));
-        addParam(createParamCentered<StandardBlackKnob>(Vec(15, 85), module, QQ::TRACK1_DECAY_TIME_PARAM));
+        addParam(createParamCentered<QQKnob>(Vec(15, 85), module, QQ::TRACK1_DECAY_TIME_PARAM));
         
         // Track 1 Decay CV input (moved up 2px)
         addInput(createInputCentered<PJ301MPort>(Vec(centerX + 15, 63), module, QQ::TRACK1_DECAY_CV_INPUT));
         
         addChild(new EnhancedTextLabel(Vec(35, 70), Vec(20, 20), "SHAPE", 8.f, nvgRGB(255, 255, 255), true));
-        addParam(createParamCentered<StandardBlackKnob>(Vec(45, 100), module, QQ::TRACK1_SHAPE_PARAM));
+        addParam(createParamCentered<QQKnob>(Vec(45, 100), module, QQ::TRACK1_SHAPE_PARAM));
         
         // Hidden attenuator knob (positioned below CV input, not overlapping)
         addParam(createParam<HiddenAttenuatorKnob>(Vec(centerX + 15 - 12, 65), module, QQ::TRACK1_DECAY_CV_ATTEN_PARAM));
@@ -576,13 +556,13 @@ struct QQWidget : ModuleWidget {
         addChild(new CVConnectionLine(Vec(0, 0), Vec(box.size.x, 200), 2));
         
         addChild(new EnhancedTextLabel(Vec(5, 135), Vec(20, 20), "DECAY", 8.f, nvgRGB(255, 255, 255), true));
-        addParam(createParamCentered<StandardBlackKnob>(Vec(15, 165), module, QQ::TRACK2_DECAY_TIME_PARAM));
+        addParam(createParamCentered<QQKnob>(Vec(15, 165), module, QQ::TRACK2_DECAY_TIME_PARAM));
         
         // Track 2 Decay CV input
         addInput(createInputCentered<PJ301MPort>(Vec(centerX + 15, 143), module, QQ::TRACK2_DECAY_CV_INPUT));
         
         addChild(new EnhancedTextLabel(Vec(35, 150), Vec(20, 20), "SHAPE", 8.f, nvgRGB(255, 255, 255), true));
-        addParam(createParamCentered<StandardBlackKnob>(Vec(45, 180), module, QQ::TRACK2_SHAPE_PARAM));
+        addParam(createParamCentered<QQKnob>(Vec(45, 180), module, QQ::TRACK2_SHAPE_PARAM));
         
         // Track 2 Hidden attenuator knob
         addParam(createParam<HiddenAttenuatorKnob>(Vec(centerX + 15 - 12, 145), module, QQ::TRACK2_DECAY_CV_ATTEN_PARAM));
@@ -595,13 +575,13 @@ struct QQWidget : ModuleWidget {
         addChild(new CVConnectionLine(Vec(0, 0), Vec(box.size.x, 280), 3));
         
         addChild(new EnhancedTextLabel(Vec(5, 215), Vec(20, 20), "DECAY", 8.f, nvgRGB(255, 255, 255), true));
-        addParam(createParamCentered<StandardBlackKnob>(Vec(15, 245), module, QQ::TRACK3_DECAY_TIME_PARAM));
+        addParam(createParamCentered<QQKnob>(Vec(15, 245), module, QQ::TRACK3_DECAY_TIME_PARAM));
         
         // Track 3 Decay CV input
         addInput(createInputCentered<PJ301MPort>(Vec(centerX + 15, 223), module, QQ::TRACK3_DECAY_CV_INPUT));
         
         addChild(new EnhancedTextLabel(Vec(35, 230), Vec(20, 20), "SHAPE", 8.f, nvgRGB(255, 255, 255), true));
-        addParam(createParamCentered<StandardBlackKnob>(Vec(45, 260), module, QQ::TRACK3_SHAPE_PARAM));
+        addParam(createParamCentered<QQKnob>(Vec(45, 260), module, QQ::TRACK3_SHAPE_PARAM));
         
         // Track 3 Hidden attenuator knob
         addParam(createParam<HiddenAttenuatorKnob>(Vec(centerX + 15 - 12, 225), module, QQ::TRACK3_DECAY_CV_ATTEN_PARAM));
@@ -622,6 +602,15 @@ struct QQWidget : ModuleWidget {
         addOutput(createOutputCentered<PJ301MPort>(Vec(45, 343), module, QQ::TRACK1_ENV_OUTPUT));
         addOutput(createOutputCentered<PJ301MPort>(Vec(15, 368), module, QQ::TRACK2_ENV_OUTPUT));
         addOutput(createOutputCentered<PJ301MPort>(Vec(45, 368), module, QQ::TRACK3_ENV_OUTPUT));
+
+        addChild(new PerfReadout(module, box.size.x));
+    }
+
+    void appendContextMenu(Menu* menu) override {
+        QQ* module = getModule<QQ>();
+        if (!module) return;
+
+        appendPerfMenu(menu, module);
     }
 };
 
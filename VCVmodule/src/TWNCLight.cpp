@@ -1,405 +1,15 @@
 #include "plugin.hpp"
+#include "divmult.hpp"
+#include "envelope.hpp"
+#include "euclidean.hpp"
+#include "perf.hpp"
+#include "widgets.hpp"
 #include <vector>
 #include <algorithm>
 
-struct TWNCLightEnhancedTextLabel : TransparentWidget {
-    std::string text;
-    float fontSize;
-    NVGcolor color;
-    bool bold;
-    
-    TWNCLightEnhancedTextLabel(Vec pos, Vec size, std::string text, float fontSize = 12.f, 
-                      NVGcolor color = nvgRGB(255, 255, 255), bool bold = true) {
-        box.pos = pos;
-        box.size = size;
-        this->text = text;
-        this->fontSize = fontSize;
-        this->color = color;
-        this->bold = bold;
-    }
-    
-    void draw(const DrawArgs &args) override {
-        nvgFontSize(args.vg, fontSize);
-        nvgFontFaceId(args.vg, APP->window->uiFont->handle);
-        nvgTextAlign(args.vg, NVG_ALIGN_CENTER | NVG_ALIGN_MIDDLE);
-        nvgFillColor(args.vg, color);
-        
-        if (bold) {
-            float offset = 0.3f;
-            nvgText(args.vg, box.size.x / 2.f - offset, box.size.y / 2.f, text.c_str(), NULL);
-            nvgText(args.vg, box.size.x / 2.f + offset, box.size.y / 2.f, text.c_str(), NULL);
-            nvgText(args.vg, box.size.x / 2.f, box.size.y / 2.f - offset, text.c_str(), NULL);
-            nvgText(args.vg, box.size.x / 2.f, box.size.y / 2.f + offset, text.c_str(), NULL);
-            nvgText(args.vg, box.size.x / 2.f, box.size.y / 2.f, text.c_str(), NULL);
-        } else {
-            nvgText(args.vg, box.size.x / 2.f, box.size.y / 2.f, text.c_str(), NULL);
-        }
-    }
-};
-
-struct TWNCLightLargeBlackKnob : ParamWidget {
-    bool isDragging = false;
-    
-    TWNCLightLargeBlackKnob() {
-        box.size = Vec(30, 30);
-    }
-    
-    float getDisplayAngle() {
-        ParamQuantity* pq = getParamQuantity();
-        if (!pq) return 0.0f;
-        
-        float normalizedValue = pq->getScaledValue();
-        float angle = rescale(normalizedValue, 0.0f, 1.0f, -0.75f * M_PI, 0.75f * M_PI);
-        return angle;
-    }
-    
-    void draw(const DrawArgs& args) override {
-        float radius = box.size.x / 2.0f;
-        float angle = getDisplayAngle();
-        
-        nvgBeginPath(args.vg);
-        nvgCircle(args.vg, radius, radius, radius - 1);
-        nvgFillColor(args.vg, nvgRGB(30, 30, 30));
-        nvgFill(args.vg);
-        
-        nvgBeginPath(args.vg);
-        nvgCircle(args.vg, radius, radius, radius - 1);
-        nvgStrokeWidth(args.vg, 1.0f);
-        nvgStrokeColor(args.vg, nvgRGB(100, 100, 100));
-        nvgStroke(args.vg);
-        
-        nvgBeginPath(args.vg);
-        nvgCircle(args.vg, radius, radius, radius - 4);
-        nvgFillColor(args.vg, nvgRGB(50, 50, 50));
-        nvgFill(args.vg);
-        
-        float indicatorLength = radius - 8;
-        float lineX = radius + indicatorLength * std::sin(angle);
-        float lineY = radius - indicatorLength * std::cos(angle);
-        
-        nvgBeginPath(args.vg);
-        nvgMoveTo(args.vg, radius, radius);
-        nvgLineTo(args.vg, lineX, lineY);
-        nvgStrokeWidth(args.vg, 2.0f);
-        nvgStrokeColor(args.vg, nvgRGB(255, 255, 255));
-        nvgStroke(args.vg);
-        
-        nvgBeginPath(args.vg);
-        nvgCircle(args.vg, lineX, lineY, 2.0f);
-        nvgFillColor(args.vg, nvgRGB(255, 255, 255));
-        nvgFill(args.vg);
-    }
-    
-    void onButton(const event::Button& e) override {
-        if (e.action == GLFW_PRESS && e.button == GLFW_MOUSE_BUTTON_LEFT) {
-            isDragging = true;
-            e.consume(this);
-        }
-        else if (e.action == GLFW_RELEASE && e.button == GLFW_MOUSE_BUTTON_LEFT) {
-            isDragging = false;
-        }
-        ParamWidget::onButton(e);
-    }
-    
-    void onDragMove(const event::DragMove& e) override {
-        ParamQuantity* pq = getParamQuantity();
-        if (!isDragging || !pq) return;
-        
-        float sensitivity = 0.002f;
-        float deltaY = -e.mouseDelta.y;
-        
-        float range = pq->getMaxValue() - pq->getMinValue();
-        float currentValue = pq->getValue();
-        float newValue = currentValue + deltaY * sensitivity * range;
-        newValue = clamp(newValue, pq->getMinValue(), pq->getMaxValue());
-        
-        pq->setValue(newValue);
-    }
-    
-    void onDoubleClick(const event::DoubleClick& e) override {
-        ParamQuantity* pq = getParamQuantity();
-        if (!pq) return;
-        
-        pq->reset();
-        e.consume(this);
-    }
-};
-
-struct TWNCLightLargeSnapKnob : ParamWidget {
-    float accumDelta = 0.0f;
-    
-    TWNCLightLargeSnapKnob() {
-        box.size = Vec(30, 30);
-    }
-    
-    float getDisplayAngle() {
-        ParamQuantity* pq = getParamQuantity();
-        if (!pq) return 0.0f;
-        
-        float normalizedValue = pq->getScaledValue();
-        float angle = rescale(normalizedValue, 0.0f, 1.0f, -0.75f * M_PI, 0.75f * M_PI);
-        return angle;
-    }
-    
-    void draw(const DrawArgs& args) override {
-        float radius = box.size.x / 2.0f;
-        float angle = getDisplayAngle();
-        
-        nvgBeginPath(args.vg);
-        nvgCircle(args.vg, radius, radius, radius - 1);
-        nvgFillColor(args.vg, nvgRGB(30, 30, 30));
-        nvgFill(args.vg);
-        
-        nvgBeginPath(args.vg);
-        nvgCircle(args.vg, radius, radius, radius - 1);
-        nvgStrokeWidth(args.vg, 1.0f);
-        nvgStrokeColor(args.vg, nvgRGB(100, 100, 100));
-        nvgStroke(args.vg);
-        
-        nvgBeginPath(args.vg);
-        nvgCircle(args.vg, radius, radius, radius - 4);
-        nvgFillColor(args.vg, nvgRGB(50, 50, 50));
-        nvgFill(args.vg);
-        
-        float indicatorLength = radius - 8;
-        float lineX = radius + indicatorLength * std::sin(angle);
-        float lineY = radius - indicatorLength * std::cos(angle);
-        
-        nvgBeginPath(args.vg);
-        nvgMoveTo(args.vg, radius, radius);
-        nvgLineTo(args.vg, lineX, lineY);
-        nvgStrokeWidth(args.vg, 2.0f);
-        nvgStrokeColor(args.vg, nvgRGB(255, 255, 255));
-        nvgStroke(args.vg);
-        
-        nvgBeginPath(args.vg);
-        nvgCircle(args.vg, lineX, lineY, 2.0f);
-        nvgFillColor(args.vg, nvgRGB(255, 255, 255));
-        nvgFill(args.vg);
-    }
-    
-    void onButton(const event::Button& e) override {
-        if (e.action == GLFW_PRESS && e.button == GLFW_MOUSE_BUTTON_LEFT) {
-            accumDelta = 0.0f;
-            e.consume(this);
-        }
-        ParamWidget::onButton(e);
-    }
-    
-    void onDragMove(const event::DragMove& e) override {
-        ParamQuantity* pq = getParamQuantity();
-        if (!pq) return;
-        
-        accumDelta += (e.mouseDelta.x - e.mouseDelta.y);
-        
-        float threshold = 15.0f;
-        
-        if (accumDelta >= threshold) {
-            float currentValue = pq->getValue();
-            float newValue = currentValue + 1.0f;
-            newValue = clamp(newValue, pq->getMinValue(), pq->getMaxValue());
-            pq->setValue(newValue);
-            accumDelta = 0.0f;
-        }
-        else if (accumDelta <= -threshold) {
-            float currentValue = pq->getValue();
-            float newValue = currentValue - 1.0f;
-            newValue = clamp(newValue, pq->getMinValue(), pq->getMaxValue());
-            pq->setValue(newValue);
-            accumDelta = 0.0f;
-        }
-    }
-    
-    void onDoubleClick(const event::DoubleClick& e) override {
-        ParamQuantity* pq = getParamQuantity();
-        if (!pq) return;
-        
-        pq->reset();
-        e.consume(this);
-    }
-};
-
-struct TWNCLightStandardBlackKnob : ParamWidget {
-    bool isDragging = false;
-    
-    TWNCLightStandardBlackKnob() {
-        box.size = Vec(26, 26);
-    }
-    
-    float getDisplayAngle() {
-        ParamQuantity* pq = getParamQuantity();
-        if (!pq) return 0.0f;
-        
-        float normalizedValue = pq->getScaledValue();
-        float angle = rescale(normalizedValue, 0.0f, 1.0f, -0.75f * M_PI, 0.75f * M_PI);
-        return angle;
-    }
-    
-    void draw(const DrawArgs& args) override {
-        float radius = box.size.x / 2.0f;
-        float angle = getDisplayAngle();
-        
-        nvgBeginPath(args.vg);
-        nvgCircle(args.vg, radius, radius, radius - 1);
-        nvgFillColor(args.vg, nvgRGB(30, 30, 30));
-        nvgFill(args.vg);
-        
-        nvgBeginPath(args.vg);
-        nvgCircle(args.vg, radius, radius, radius - 1);
-        nvgStrokeWidth(args.vg, 1.0f);
-        nvgStrokeColor(args.vg, nvgRGB(100, 100, 100));
-        nvgStroke(args.vg);
-        
-        nvgBeginPath(args.vg);
-        nvgCircle(args.vg, radius, radius, radius - 3);
-        nvgFillColor(args.vg, nvgRGB(50, 50, 50));
-        nvgFill(args.vg);
-        
-        float indicatorLength = radius - 8;
-        float lineX = radius + indicatorLength * std::sin(angle);
-        float lineY = radius - indicatorLength * std::cos(angle);
-        
-        nvgBeginPath(args.vg);
-        nvgMoveTo(args.vg, radius, radius);
-        nvgLineTo(args.vg, lineX, lineY);
-        nvgStrokeWidth(args.vg, 2.0f);
-        nvgStrokeColor(args.vg, nvgRGB(255, 255, 255));
-        nvgStroke(args.vg);
-        
-        nvgBeginPath(args.vg);
-        nvgCircle(args.vg, lineX, lineY, 2.0f);
-        nvgFillColor(args.vg, nvgRGB(255, 255, 255));
-        nvgFill(args.vg);
-    }
-    
-    void onButton(const event::Button& e) override {
-        if (e.action == GLFW_PRESS && e.button == GLFW_MOUSE_BUTTON_LEFT) {
-            isDragging = true;
-            e.consume(this);
-        }
-        else if (e.action == GLFW_RELEASE && e.button == GLFW_MOUSE_BUTTON_LEFT) {
-            isDragging = false;
-        }
-        ParamWidget::onButton(e);
-    }
-    
-    void onDragMove(const event::DragMove& e) override {
-        ParamQuantity* pq = getParamQuantity();
-        if (!isDragging || !pq) return;
-        
-        float sensitivity = 0.002f;
-        float deltaY = -e.mouseDelta.y;
-        
-        float range = pq->getMaxValue() - pq->getMinValue();
-        float currentValue = pq->getValue();
-        float newValue = currentValue + deltaY * sensitivity * range;
-        newValue = clamp(newValue, pq->getMinValue(), pq->getMaxValue());
-        
-        pq->setValue(newValue);
-    }
-    
-    void onDoubleClick(const event::DoubleClick& e) override {
-        ParamQuantity* pq = getParamQuantity();
-        if (!pq) return;
-        
-        pq->reset();
-        e.consume(this);
-    }
-};
-
-struct TWNCLightSnapKnob : ParamWidget {
-    float accumDelta = 0.0f;
-    
-    TWNCLightSnapKnob() {
-        box.size = Vec(26, 26);
-    }
-    
-    float getDisplayAngle() {
-        ParamQuantity* pq = getParamQuantity();
-        if (!pq) return 0.0f;
-        
-        float normalizedValue = pq->getScaledValue();
-        float angle = rescale(normalizedValue, 0.0f, 1.0f, -0.75f * M_PI, 0.75f * M_PI);
-        return angle;
-    }
-    
-    void draw(const DrawArgs& args) override {
-        float radius = box.size.x / 2.0f;
-        float angle = getDisplayAngle();
-        
-        nvgBeginPath(args.vg);
-        nvgCircle(args.vg, radius, radius, radius - 1);
-        nvgFillColor(args.vg, nvgRGB(30, 30, 30));
-        nvgFill(args.vg);
-        
-        nvgBeginPath(args.vg);
-        nvgCircle(args.vg, radius, radius, radius - 1);
-        nvgStrokeWidth(args.vg, 1.0f);
-        nvgStrokeColor(args.vg, nvgRGB(100, 100, 100));
-        nvgStroke(args.vg);
-        
-        nvgBeginPath(args.vg);
-        nvgCircle(args.vg, radius, radius, radius - 4);
-        nvgFillColor(args.vg, nvgRGB(50, 50, 50));
-        nvgFill(args.vg);
-        
-        float indicatorLength = radius - 8;
-        float lineX = radius + indicatorLength * std::sin(angle);
-        float lineY = radius - indicatorLength * std::cos(angle);
-        
-        nvgBeginPath(args.vg);
-        nvgMoveTo(args.vg, radius, radius);
-        nvgLineTo(args.vg, lineX, lineY);
-        nvgStrokeWidth(args.vg, 2.0f);
-        nvgStrokeColor(args.vg, nvgRGB(255, 255, 255));
-        nvgStroke(args.vg);
-        
-        nvgBeginPath(args.vg);
-        nvgCircle(args.vg, lineX, lineY, 2.0f);
-        nvgFillColor(args.vg, nvgRGB(255, 255, 255));
-        nvgFill(args.vg);
-    }
-    
-    void onButton(const event::Button& e) override {
-        if (e.action == GLFW_PRESS && e.button == GLFW_MOUSE_BUTTON_LEFT) {
-            accumDelta = 0.0f;
-            e.consume(this);
-        }
-        ParamWidget::onButton(e);
-    }
-    
-    void onDragMove(const event::DragMove& e) override {
-        ParamQuantity* pq = getParamQuantity();
-        if (!pq) return;
-        
-        accumDelta += (e.mouseDelta.x - e.mouseDelta.y);
-        
-        float threshold = 15.0f;
-        
-        if (accumDelta >= threshold) {
-            float currentValue = pq->getValue();
-            float newValue = currentValue + 1.0f;
-            newValue = clamp(newValue, pq->getMinValue(), pq->getMaxValue());
-            pq->setValue(newValue);
-            accumDelta = 0.0f;
-        }
-        else if (accumDelta <= -threshold) {
-            float currentValue = pq->getValue();
-            float newValue = currentValue - 1.0f;
-            newValue = clamp(newValue, pq->getMinValue(), pq->getMaxValue());
-            pq->setValue(newValue);
-            accumDelta = 0.0f;
-        }
-    }
-    
-    void onDoubleClick(const event::DoubleClick& e) override {
-        ParamQuantity* pq = getParamQuantity();
-        if (!pq) return;
-        
-        pq->reset();
-        e.consume(this);
-    }
-};
+typedef MadzineSnapKnob<30, BlackKnobLook, 15> TWNCLightLargeSnapKnob;
+typedef MadzineKnob<26, NarrowRimBlackKnobLook> TWNCLightStandardBlackKnob;
+typedef MadzineSnapKnob<26, BlackKnobLook, 15> TWNCLightSnapKnob;
 
 struct TWNCLightDivMultParamQuantity : ParamQuantity {
     std::string getDisplayValueString() override {
@@ -422,113 +32,7 @@ struct TWNCLightVCAShiftParamQuantity : ParamQuantity {
     }
 };
 
-struct WhiteBackgroundBox : Widget {
-    WhiteBackgroundBox(Vec pos, Vec size) {
-        box.pos = pos;
-        box.size = size;
-    }
-    
-    void draw(const DrawArgs &args) override {
-        nvgBeginPath(args.vg);
-        nvgRect(args.vg, 0, 0, box.size.x, box.size.y);
-        nvgFillColor(args.vg, nvgRGB(255, 255, 255));
-        nvgFill(args.vg);
-        
-        nvgStrokeWidth(args.vg, 1.0f);
-        nvgStrokeColor(args.vg, nvgRGBA(200, 200, 200, 255));
-        nvgStroke(args.vg);
-    }
-};
-
-std::vector<bool> generateTWNCLightEuclideanRhythm(int length, int fill, int shift) {
-    std::vector<bool> pattern(length, false);
-    if (fill == 0 || length == 0) return pattern;
-    if (fill > length) fill = length;
-
-    shift = shift % length;
-    if (shift < 0) shift += length;
-
-    for (int i = 0; i < fill; ++i) {
-        int index = (int)std::floor((float)i * length / fill);
-        pattern[index] = true;
-    }
-    
-    std::rotate(pattern.begin(), pattern.begin() + shift, pattern.end());
-    return pattern;
-}
-
-struct UnifiedEnvelope {
-    dsp::SchmittTrigger trigTrigger;
-    dsp::PulseGenerator trigPulse;
-    float phase = 0.f;
-    bool gateState = false;
-    static constexpr float ATTACK_TIME = 0.001f;
-    
-    void reset() {
-        trigTrigger.reset();
-        trigPulse.reset();
-        phase = 0.f;
-        gateState = false;
-    }
-    
-    float smoothDecayEnvelope(float t, float totalTime, float shapeParam) {
-        if (t >= totalTime) return 0.f;
-        
-        float normalizedT = t / totalTime;
-        
-        float frontK = -0.9f + shapeParam * 0.5f;
-        float backK = -1.0f + 1.6f * std::pow(shapeParam, 0.3f);
-        
-        float transition = normalizedT * normalizedT * (3.f - 2.f * normalizedT);
-        float k = frontK + (backK - frontK) * transition;
-        
-        float absT = std::abs(normalizedT);
-        float denominator = k - 2.f * k * absT + 1.f;
-        if (std::abs(denominator) < 1e-10f) {
-            return 1.f - normalizedT;
-        }
-        
-        float curveResult = (normalizedT - k * normalizedT) / denominator;
-        return 1.f - curveResult;
-    }
-    
-    float process(float sampleTime, float triggerVoltage, float decayTime, float shapeParam) {
-        bool triggered = trigTrigger.process(triggerVoltage, 0.1f, 2.f);
-        
-        if (triggered) {
-            phase = 0.f;
-            gateState = true;
-            trigPulse.trigger(0.03f);
-        }
-        
-        float envOutput = 0.f;
-        
-        if (gateState) {
-            if (phase < ATTACK_TIME) {
-                envOutput = phase / ATTACK_TIME;
-            } else {
-                float decayPhase = phase - ATTACK_TIME;
-                
-                if (decayPhase >= decayTime) {
-                    gateState = false;
-                    envOutput = 0.f;
-                } else {
-                    envOutput = smoothDecayEnvelope(decayPhase, decayTime, shapeParam);
-                }
-            }
-            
-            phase += sampleTime;
-        }
-        
-        return clamp(envOutput, 0.f, 1.f);
-    }
-    
-    float getTrigger(float sampleTime) {
-        return trigPulse.process(sampleTime) ? 10.0f : 0.0f;
-    }
-};
-
-struct TWNCLight : Module {
+struct TWNCLight : MeteredModule {
     enum ParamId {
         GLOBAL_LENGTH_PARAM,
         TRACK1_FILL_PARAM,
@@ -562,8 +66,7 @@ struct TWNCLight : Module {
 
     dsp::SchmittTrigger clockTrigger;
     
-    float globalClockSeconds = 0.5f;
-    float secondsSinceLastClock = -1.0f;
+    ClockPeriod clockPeriod;
     int globalClockCount = 0;
 
     struct QuarterNoteClock {
@@ -598,19 +101,13 @@ struct TWNCLight : Module {
         int divMultValue = 0;
         int division = 1;
         int multiplication = 1;
-        float dividedClockSeconds = 0.5f;
-        float multipliedClockSeconds = 0.5f;
-        float dividedProgressSeconds = 0.0f;
-        float gateSeconds = 0.0f;
-        int dividerCount = 0;
-        bool shouldStep = false;
-        bool prevMultipliedGate = false;
+        ClockDivMult clock;
         
         int currentStep = 0;
         int length = 16;
         int fill = 4;
         int shift = 0;
-        std::vector<bool> pattern;
+        uint64_t pattern = 0;
         bool gateState = false;
         dsp::PulseGenerator trigPulse;
         
@@ -618,12 +115,9 @@ struct TWNCLight : Module {
         UnifiedEnvelope vcaEnvelope;
 
         void reset() {
-            dividedProgressSeconds = 0.0f;
-            dividerCount = 0;
-            shouldStep = false;
-            prevMultipliedGate = false;
+            clock.reset();
             currentStep = 0;
-            pattern.clear();
+            pattern = 0;
             gateState = false;
             envelope.reset();
             vcaEnvelope.reset();
@@ -633,10 +127,7 @@ struct TWNCLight : Module {
             int newDivMultValue = divMultParam;
             if (newDivMultValue != divMultValue) {
                 divMultValue = newDivMultValue;
-                dividedProgressSeconds = 0.0f;
-                dividerCount = 0;
-                shouldStep = false;
-                prevMultipliedGate = false;
+                clock.reset();
             }
             
             switch (divMultParam) {
@@ -667,45 +158,9 @@ struct TWNCLight : Module {
             }
         }
         
-        bool processClockDivMult(bool globalClock, float globalClockSeconds, float sampleTime) {
-            dividedClockSeconds = globalClockSeconds * (float)division;
-            multipliedClockSeconds = dividedClockSeconds / (float)multiplication;
-            gateSeconds = std::max(0.001f, multipliedClockSeconds * 0.5f);
-            
-            if (globalClock) {
-                if (dividerCount < 1) {
-                    dividedProgressSeconds = 0.0f;
-                } else {
-                    dividedProgressSeconds += sampleTime;
-                }
-                ++dividerCount;
-                if (dividerCount >= division) {
-                    dividerCount = 0;
-                }
-            } else {
-                dividedProgressSeconds += sampleTime;
-            }
-            
-            shouldStep = false;
-            if (dividedProgressSeconds < dividedClockSeconds) {
-                float multipliedProgressSeconds = dividedProgressSeconds / multipliedClockSeconds;
-                multipliedProgressSeconds -= (float)(int)multipliedProgressSeconds;
-                multipliedProgressSeconds *= multipliedClockSeconds;
-                
-                bool currentMultipliedGate = multipliedProgressSeconds <= gateSeconds;
-                
-                if (currentMultipliedGate && !prevMultipliedGate) {
-                    shouldStep = true;
-                }
-                prevMultipliedGate = currentMultipliedGate;
-            }
-            
-            return shouldStep;
-        }
-        
         void stepTrack() {
             currentStep = (currentStep + 1) % length;
-            gateState = !pattern.empty() && pattern[currentStep];
+            gateState = euclideanStep(pattern, currentStep);
             if (gateState) {
                 trigPulse.trigger(0.01f);
             }
@@ -714,6 +169,9 @@ struct TWNCLight : Module {
     TrackState tracks[2];
     QuarterNoteClock quarterClock;
     UnifiedEnvelope mainVCA;
+    // Hats fire three clocks after each accent.
+    int hatsDelayCounter = 0;
+    bool hatsDelayActive = false;
 
     TWNCLight() {
         config(PARAMS_LEN, INPUTS_LEN, OUTPUTS_LEN, LIGHTS_LEN);
@@ -724,7 +182,7 @@ struct TWNCLight : Module {
         configInput(HATS_FREQ_CV_INPUT, "Hats Frequency CV");
         configInput(HATS_DECAY_CV_INPUT, "Hats Decay CV");
         
-        configParam(GLOBAL_LENGTH_PARAM, 1.0f, 32.0f, 16.0f, "Global Length");
+        configParam(GLOBAL_LENGTH_PARAM, 1.0f, (float)EUCLIDEAN_MAX_LENGTH, 16.0f, "Global Length");
         getParamQuantity(GLOBAL_LENGTH_PARAM)->snapEnabled = true;
         
         configParam(TRACK1_FILL_PARAM, 0.0f, 100.0f, 25.0f, "Track 1 Fill", "%");
@@ -768,17 +226,19 @@ struct TWNCLight : Module {
     }
 
     void onReset() override {
-        secondsSinceLastClock = -1.0f;
-        globalClockSeconds = 0.5f;
+        clockPeriod.reset();
         globalClockCount = 0;
         for (int i = 0; i < 2; ++i) {
             tracks[i].reset();
         }
         quarterClock.reset();
         mainVCA.reset();
+        hatsDelayCounter = 0;
+        hatsDelayActive = false;
     }
 
     void process(const ProcessArgs& args) override {
+        PerfMeter::Scope perfScope(perf, args.sampleRate);
         bool globalClockActive = inputs[GLOBAL_CLOCK_INPUT].isConnected();
         bool globalClockTriggered = false;
         
@@ -798,28 +258,15 @@ struct TWNCLight : Module {
             }
         }
         
-        if (globalClockTriggered) {
-            if (secondsSinceLastClock > 0.0f) {
-                globalClockSeconds = secondsSinceLastClock;
-                globalClockSeconds = clamp(globalClockSeconds, 0.01f, 10.0f);
-            }
-            secondsSinceLastClock = 0.0f;
-        }
-        
-        if (secondsSinceLastClock >= 0.0f) {
-            secondsSinceLastClock += args.sampleTime;
-        }
+        int64_t clockPeriodSamples = clockPeriod.process(globalClockTriggered, args.sampleRate);
 
         int globalLength = (int)std::round(params[GLOBAL_LENGTH_PARAM].getValue());
-        globalLength = clamp(globalLength, 1, 32);
+        globalLength = clamp(globalLength, 1, EUCLIDEAN_MAX_LENGTH);
         
         int vcaShift = (int)std::round(params[VCA_SHIFT_PARAM].getValue());
         bool vcaTriggered = quarterClock.processStep(globalClockTriggered, globalLength, vcaShift);
         float vcaTrigger = quarterClock.getTrigger(args.sampleTime);
         
-        static int hatsDelayCounter = 0;
-        static bool hatsDelayActive = false;
-
         if (vcaTriggered) {
             hatsDelayCounter = 3;
             hatsDelayActive = true;
@@ -852,19 +299,18 @@ struct TWNCLight : Module {
 
             // 移除 Track 2 的 Euclidean shift，改用延後觸發
             track.shift = 0;  // 兩個軌道都不使用 Euclidean shift
-            track.pattern = generateTWNCLightEuclideanRhythm(track.length, track.fill, track.shift);
-
-            bool trackClockTrigger = track.processClockDivMult(globalClockTriggered, globalClockSeconds, args.sampleTime);
+            track.pattern = generateEuclideanPattern(track.length, track.fill, track.shift);
 
             if (i == 1) {
                 // Track 2：讓 D/M 作用於延後觸發
-                bool delayedClockTrigger = track.processClockDivMult(hatsManualTrigger, globalClockSeconds, args.sampleTime);
-                if (delayedClockTrigger && !track.pattern.empty() && globalClockActive) {
+                bool delayedClockTrigger = track.clock.process(hatsManualTrigger, clockPeriodSamples, track.division, track.multiplication);
+                if (delayedClockTrigger && globalClockActive) {
                     track.stepTrack();
                 }
             } else {
                 // Track 1：使用正常的時鐘觸發
-                if (trackClockTrigger && !track.pattern.empty() && globalClockActive) {
+                bool trackClockTrigger = track.clock.process(globalClockTriggered, clockPeriodSamples, track.division, track.multiplication);
+                if (trackClockTrigger && globalClockActive) {
                     track.stepTrack();
                 }
             }
@@ -912,69 +358,78 @@ struct TWNCLightWidget : ModuleWidget {
         
         box.size = Vec(4 * RACK_GRID_WIDTH, RACK_GRID_HEIGHT);
 
-        addChild(new TWNCLightEnhancedTextLabel(Vec(0, 1), Vec(box.size.x, 20), "TWNC LTE", 10.f, nvgRGB(255, 200, 0), true));
-        addChild(new TWNCLightEnhancedTextLabel(Vec(0, 13), Vec(box.size.x, 20), "MADZINE", 8.f, nvgRGB(255, 200, 0), false));
+        addChild(new EnhancedTextLabel(Vec(0, 1), Vec(box.size.x, 20), "TWNC LTE", 10.f, nvgRGB(255, 200, 0), true));
+        addChild(new EnhancedTextLabel(Vec(0, 13), Vec(box.size.x, 20), "MADZINE", 8.f, nvgRGB(255, 200, 0), false));
 
-        addChild(new TWNCLightEnhancedTextLabel(Vec(5, 30), Vec(20, 15), "CLK", 6.f, nvgRGB(255, 255, 255), true));
+        addChild(new EnhancedTextLabel(Vec(5, 30), Vec(20, 15), "CLK", 6.f, nvgRGB(255, 255, 255), true));
         addInput(createInputCentered<PJ301MPort>(Vec(15, 51), module, TWNCLight::GLOBAL_CLOCK_INPUT));
         
-        addChild(new TWNCLightEnhancedTextLabel(Vec(35, 30), Vec(20, 15), "LEN", 6.f, nvgRGB(255, 255, 255), true));
+        addChild(new EnhancedTextLabel(Vec(35, 30), Vec(20, 15), "LEN", 6.f, nvgRGB(255, 255, 255), true));
         addParam(createParamCentered<TWNCLightSnapKnob>(Vec(45, 53), module, TWNCLight::GLOBAL_LENGTH_PARAM));
 
         // Drum Track - 所有內容往下3px
         float drumY = 71;  // 從 68 改為 71
-        addChild(new TWNCLightEnhancedTextLabel(Vec(20, drumY), Vec(20, 10), "Drum", 6.f, nvgRGB(255, 200, 100), true));
+        addChild(new EnhancedTextLabel(Vec(20, drumY), Vec(20, 10), "Drum", 6.f, nvgRGB(255, 200, 100), true));
         
         // 第一排：FILL 和 DECAY（文字和旋鈕都往下3px）
-        addChild(new TWNCLightEnhancedTextLabel(Vec(5, drumY + 12), Vec(20, 10), "FILL", 5.f, nvgRGB(255, 255, 255), true));
+        addChild(new EnhancedTextLabel(Vec(5, drumY + 12), Vec(20, 10), "FILL", 5.f, nvgRGB(255, 255, 255), true));
         addParam(createParamCentered<TWNCLightStandardBlackKnob>(Vec(15, drumY + 33), module, TWNCLight::TRACK1_FILL_PARAM));
         
-        addChild(new TWNCLightEnhancedTextLabel(Vec(35, drumY + 12), Vec(20, 10), "DECAY", 5.f, nvgRGB(255, 255, 255), true));
+        addChild(new EnhancedTextLabel(Vec(35, drumY + 12), Vec(20, 10), "DECAY", 5.f, nvgRGB(255, 255, 255), true));
         addParam(createParamCentered<TWNCLightStandardBlackKnob>(Vec(45, drumY + 33), module, TWNCLight::TRACK1_DECAY_PARAM));
         
         // 第二排：ACCENT 和 A.DECAY（文字和旋鈕都往下3px）
-        addChild(new TWNCLightEnhancedTextLabel(Vec(5, drumY + 48), Vec(20, 10), "ACCNT", 5.f, nvgRGB(255, 255, 255), true));
+        addChild(new EnhancedTextLabel(Vec(5, drumY + 48), Vec(20, 10), "ACCNT", 5.f, nvgRGB(255, 255, 255), true));
         addParam(createParamCentered<TWNCLightSnapKnob>(Vec(15, drumY + 69), module, TWNCLight::VCA_SHIFT_PARAM));
         
-        addChild(new TWNCLightEnhancedTextLabel(Vec(35, drumY + 48), Vec(20, 10), "A.DEC", 5.f, nvgRGB(255, 255, 255), true));
+        addChild(new EnhancedTextLabel(Vec(35, drumY + 48), Vec(20, 10), "A.DEC", 5.f, nvgRGB(255, 255, 255), true));
         addParam(createParamCentered<TWNCLightStandardBlackKnob>(Vec(45, drumY + 69), module, TWNCLight::VCA_DECAY_PARAM));
         
         // 第三排：SHAPE 和 D.D CV（文字和控制項都往下3px）
-        addChild(new TWNCLightEnhancedTextLabel(Vec(5, drumY + 84), Vec(20, 10), "SHAPE", 5.f, nvgRGB(255, 255, 255), true));
+        addChild(new EnhancedTextLabel(Vec(5, drumY + 84), Vec(20, 10), "SHAPE", 5.f, nvgRGB(255, 255, 255), true));
         addParam(createParamCentered<TWNCLightStandardBlackKnob>(Vec(15, drumY + 105), module, TWNCLight::TRACK1_SHAPE_PARAM));
         
-        addChild(new TWNCLightEnhancedTextLabel(Vec(35, drumY + 84), Vec(20, 10), "D.D", 5.f, nvgRGB(255, 133, 133), true));
+        addChild(new EnhancedTextLabel(Vec(35, drumY + 84), Vec(20, 10), "D.D", 5.f, nvgRGB(255, 133, 133), true));
         addInput(createInputCentered<PJ301MPort>(Vec(45, drumY + 105), module, TWNCLight::DRUM_DECAY_CV_INPUT));
 
         // Hats Track - 所有內容往下10px
         float hatsY = 195;  // 從 185 改為 195
-        addChild(new TWNCLightEnhancedTextLabel(Vec(20, hatsY), Vec(20, 10), "HATs", 6.f, nvgRGB(255, 200, 100), true));
+        addChild(new EnhancedTextLabel(Vec(20, hatsY), Vec(20, 10), "HATs", 6.f, nvgRGB(255, 200, 100), true));
         
         // 第一排：FILL 和 D/M（文字和旋鈕都往下10px）
-        addChild(new TWNCLightEnhancedTextLabel(Vec(5, hatsY + 12), Vec(20, 10), "FILL", 5.f, nvgRGB(255, 255, 255), true));
+        addChild(new EnhancedTextLabel(Vec(5, hatsY + 12), Vec(20, 10), "FILL", 5.f, nvgRGB(255, 255, 255), true));
         addParam(createParamCentered<TWNCLightStandardBlackKnob>(Vec(15, hatsY + 33), module, TWNCLight::TRACK2_FILL_PARAM));
         
-        addChild(new TWNCLightEnhancedTextLabel(Vec(35, hatsY + 12), Vec(20, 10), "D/M", 5.f, nvgRGB(255, 255, 255), true));
+        addChild(new EnhancedTextLabel(Vec(35, hatsY + 12), Vec(20, 10), "D/M", 5.f, nvgRGB(255, 255, 255), true));
         addParam(createParamCentered<TWNCLightSnapKnob>(Vec(45, hatsY + 33), module, TWNCLight::TRACK2_DIVMULT_PARAM));
         
         // 第二排：DECAY 和 SHAPE（文字和旋鈕都往下10px）
-        addChild(new TWNCLightEnhancedTextLabel(Vec(5, hatsY + 48), Vec(20, 10), "DECAY", 5.f, nvgRGB(255, 255, 255), true));
+        addChild(new EnhancedTextLabel(Vec(5, hatsY + 48), Vec(20, 10), "DECAY", 5.f, nvgRGB(255, 255, 255), true));
         addParam(createParamCentered<TWNCLightStandardBlackKnob>(Vec(15, hatsY + 69), module, TWNCLight::TRACK2_DECAY_PARAM));
         
-        addChild(new TWNCLightEnhancedTextLabel(Vec(35, hatsY + 48), Vec(20, 10), "SHAPE", 5.f, nvgRGB(255, 255, 255), true));
+        addChild(new EnhancedTextLabel(Vec(35, hatsY + 48), Vec(20, 10), "SHAPE", 5.f, nvgRGB(255, 255, 255), true));
         addParam(createParamCentered<TWNCLightStandardBlackKnob>(Vec(45, hatsY + 69), module, TWNCLight::TRACK2_SHAPE_PARAM));
         
         // 第三排：H.D CV（文字和接口都往下10px）
-        addChild(new TWNCLightEnhancedTextLabel(Vec(35, hatsY + 84), Vec(20, 10), "H.D", 5.f, nvgRGB(255, 133, 133), true));
+        addChild(new EnhancedTextLabel(Vec(35, hatsY + 84), Vec(20, 10), "H.D", 5.f, nvgRGB(255, 133, 133), true));
         addInput(createInputCentered<PJ301MPort>(Vec(45, hatsY + 105), module, TWNCLight::HATS_DECAY_CV_INPUT));
         
         // 白色背景框和輸出
         addChild(new WhiteBackgroundBox(Vec(0, 330), Vec(60, 50)));
         
-        addChild(new TWNCLightEnhancedTextLabel(Vec(5, 335), Vec(20, 20), "ENVs", 8.f, nvgRGB(255, 133, 133), true));
+        addChild(new EnhancedTextLabel(Vec(5, 335), Vec(20, 20), "ENVs", 8.f, nvgRGB(255, 133, 133), true));
         addOutput(createOutputCentered<PJ301MPort>(Vec(45, 343), module, TWNCLight::MAIN_VCA_ENV_OUTPUT));
         addOutput(createOutputCentered<PJ301MPort>(Vec(15, 368), module, TWNCLight::TRACK1_FM_ENV_OUTPUT));
         addOutput(createOutputCentered<PJ301MPort>(Vec(45, 368), module, TWNCLight::TRACK2_VCA_ENV_OUTPUT));
+
+        addChild(new PerfReadout(module, box.size.x));
+    }
+
+    void appendContextMenu(Menu* menu) override {
+        TWNCLight* module = getModule<TWNCLight>();
+        if (!module) return;
+
+        appendPerfMenu(menu, module);
     }
 };
 
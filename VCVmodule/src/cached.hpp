@@ -0,0 +1,85 @@
+#pragma once
+#include "plugin.hpp"
+
+// Hand-drawn widgets rendered once into a framebuffer instead of every frame.
+//
+// A widget derives from FramebufferCached<Base> and puts its drawing in
+// drawCached() instead of draw(). That drawing goes into a FramebufferWidget
+// child, which redraws it only when setDirty() is called or the zoom
+// changes, and otherwise blits the texture. step() calls setDirty() whenever
+// cacheKey() returns something new, so a widget whose picture depends on
+// more than its size overrides cacheKey() with whatever it depends on.
+//
+// The framebuffer covers cacheBounds(), the box unless overridden, and the
+// drawing keeps the widget's own coordinates inside it. A widget that paints
+// past its box, like a label wider than its box, overrides cacheBounds() so
+// that part isn't clipped away.
+
+template <class TBase>
+struct FramebufferCached : TBase {
+    FramebufferWidget* fb;
+
+    FramebufferCached() {
+        fb = new FramebufferWidget;
+        face = new Face(this);
+        fb->addChild(face);
+        this->addChild(fb);
+    }
+
+    virtual void drawCached(const widget::Widget::DrawArgs& args) = 0;
+
+    virtual float cacheKey() {
+        return 0.f;
+    }
+
+    // The area drawCached() paints, in the widget's coordinates.
+    virtual math::Rect cacheBounds() {
+        return this->box.zeroPos();
+    }
+
+    void step() override {
+        math::Rect bounds = cacheBounds();
+        bool resized = !fb->box.equals(bounds) || !face->box.size.equals(this->box.size);
+        fb->box = bounds;
+        face->box.pos = bounds.pos.neg();
+        face->box.size = this->box.size;
+        float key = cacheKey();
+        if (resized || !keyed || key != lastKey) {
+            keyed = true;
+            lastKey = key;
+            fb->setDirty();
+        }
+        TBase::step();
+    }
+
+    void draw(const widget::Widget::DrawArgs& args) override {
+        TBase::draw(args);
+    }
+
+private:
+    struct Face : Widget {
+        FramebufferCached* owner;
+
+        explicit Face(FramebufferCached* owner) : owner(owner) {}
+
+        void draw(const DrawArgs& args) override {
+            owner->drawCached(args);
+        }
+    };
+
+    Face* face;
+    bool keyed = false;
+    float lastKey = 0.f;
+};
+
+typedef FramebufferCached<Widget> CachedWidget;
+typedef FramebufferCached<TransparentWidget> CachedTransparentWidget;
+
+// Knobs: redrawn when the parameter moves, whether by mouse, preset or
+// automation.
+struct CachedParamWidget : FramebufferCached<ParamWidget> {
+    float cacheKey() override {
+        ParamQuantity* pq = getParamQuantity();
+        return pq ? pq->getValue() : 0.f;
+    }
+};
@@ -0,0 +1,188 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Multichannel capture to a 32-bit float WAV file.
+//
+// The audio thread hands over whole frames with push(), which only copies
+// them into a preallocated single-producer/single-consumer ring: no locks,
+// no allocation, no syscalls. A writer thread drains the ring to disk in
+// large blocks. If the disk falls behind and the ring fills up, frames are
+// dropped and counted in `overruns` rather than stalling the engine.
+//
+// start() and stop() belong to the UI thread. stop() waits for the writer
+// to flush what is left and fill in the WAV header sizes. The file's channels
+// are laid out as tracks of one or more channels each; start() stores that
+// layout before it sets `active`, so the audio thread may read it once
+// isActive() has returned true.
+
+struct DiskCapture {
+    static const int MAX_CHANNELS = 128;
+    static const int MAX_TRACKS = 16;
+    // In floats: 16 MB, 11 s of eight channels at 48 kHz.
+    static const size_t RING_SIZE = size_t(1) << 22;
+    static const size_t BLOCK_SIZE = size_t(1) << 16;
+
+    std::atomic<uint64_t> overruns;
+    std::atomic<uint64_t> framesWritten;
+
+    DiskCapture() : overruns(0), framesWritten(0), active(false), stopping(false), head(0), tail(0) {}
+
+    ~DiskCapture() {
+        stop();
+    }
+
+    bool isActive() const {
+        return active.load(std::memory_order_acquire);
+    }
+
+    int getChannels() const {
+        return channels;
+    }
+
+    int getTracks() const {
+        return tracks;
+    }
+
+    int getTrackChannels(int track) const {
+        return trackChannels[track];
+    }
+
+    // Refused while a capture is running: the audio thread may be reading
+    // the layout.
+    bool start(const std::string& path, const int* trackChannels, int tracks, float sampleRate) {
+        if (isActive() || tracks < 1 || tracks > MAX_TRACKS)
+            return false;
+        int channels = 0;
+        for (int i = 0; i < tracks; i++) {
+            if (trackChannels[i] < 1)
+                return false;
+            channels += trackChannels[i];
+        }
+        if (channels > MAX_CHANNELS)
+            return false;
+        file = std::fopen(path.c_str(), "wb");
+        if (!file)
+            return false;
+        // Allocated once and kept, so push() never sees the ring move.
+        if (ring.empty())
+            ring.resize(RING_SIZE);
+        this->channels = channels;
+        this->tracks = tracks;
+        std::copy(trackChannels, trackChannels + tracks, this->trackChannels);
+        this->sampleRate = sampleRate;
+        head.store(0);
+        tail.store(0);
+        overruns.store(0);
+        framesWritten.store(0);
+        stopping.store(false);
+        writeHeader(0);
+        writer = std::thread(&DiskCapture::run, this);
+        active.store(true, std::memory_order_release);
+        return true;
+    }
+
+    void stop() {
+        if (!writer.joinable())
+            return;
+        active.store(false, std::memory_order_release);
+        stopping.store(true, std::memory_order_release);
+        writer.join();
+        std::fseek(file, 0, SEEK_SET);
+        writeHeader(framesWritten.load());
+        std::fclose(file);
+        file = NULL;
+    }
+
+    // Audio thread. `frame` holds getChannels() samples.
+    void push(const float* frame) {
+        if (!active.load(std::memory_order_acquire))
+            return;
+        size_t h = head.load(std::memory_order_relaxed);
+        size_t t = tail.load(std::memory_order_acquire);
+        if (RING_SIZE - (h - t) < (size_t) channels) {
+            overruns.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        for (int i = 0; i < channels; i++) {
+            ring[(h + i) & (RING_SIZE - 1)] = frame[i];
+        }
+        head.store(h + channels, std::memory_order_release);
+    }
+
+private:
+    std::vector<float> ring;
+    std::atomic<bool> active;
+    std::atomic<bool> stopping;
+    std::atomic<size_t> head;
+    std::atomic<size_t> tail;
+    std::thread writer;
+    std::FILE* file = NULL;
+    int channels = 0;
+    int tracks = 0;
+    int trackChannels[MAX_TRACKS] = {};
+    float sampleRate = 0.f;
+
+    void run() {
+        // push() only ever adds whole frames, so a block that is a whole
+        // number of frames never splits one.
+        std::vector<float> block(BLOCK_SIZE / channels * channels);
+        while (true) {
+            // Checked before draining, so a frame pushed before stop() is
+            // always written.
+            bool last = stopping.load(std::memory_order_acquire);
+            size_t t = tail.load(std::memory_order_relaxed);
+            size_t available = head.load(std::memory_order_acquire) - t;
+            if (available < block.size() && !last) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                continue;
+            }
+            if (available == 0)
+                break;
+            size_t n = std::min(available, block.size());
+            for (size_t i = 0; i < n; i++) {
+                block[i] = ring[(t + i) & (RING_SIZE - 1)];
+            }
+            tail.store(t + n, std::memory_order_release);
+            std::fwrite(block.data(), sizeof(float), n, file);
+            framesWritten.fetch_add(n / channels, std::memory_order_relaxed);
+        }
+    }
+
+    void put32(uint32_t x) {
+        uint8_t bytes[4] = {(uint8_t) x, (uint8_t) (x >> 8), (uint8_t) (x >> 16), (uint8_t) (x >> 24)};
+        std::fwrite(bytes, 1, 4, file);
+    }
+
+    void put16(uint16_t x) {
+        uint8_t bytes[2] = {(uint8_t) x, (uint8_t) (x >> 8)};
+        std::fwrite(bytes, 1, 2, file);
+    }
+
+    // WAVE_FORMAT_IEEE_FLOAT with a fact chunk; 58 bytes before the samples.
+    void writeHeader(uint64_t frames) {
+        uint32_t dataBytes = (uint32_t) std::min<uint64_t>(frames * channels * 4, 0xffffffffu - 50);
+        std::fwrite("RIFF", 1, 4, file);
+        put32(50 + dataBytes);
+        std::fwrite("WAVEfmt ", 1, 8, file);
+        put32(18);
+        put16(3);
+        put16(channels);
+        put32((uint32_t) sampleRate);
+        put32((uint32_t) sampleRate * channels * 4);
+        put16(channels * 4);
+        put16(32);
+        put16(0);
+        std::fwrite("fact", 1, 4, file);
+        put32(4);
+        put32((uint32_t) frames);
+        std::fwrite("data", 1, 4, file);
+        put32(dataBytes);
+    }
+};
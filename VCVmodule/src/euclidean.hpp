@@ -0,0 +1,92 @@
+#pragma once
+#include <cstdint>
+
+// Euclidean patterns as 64-bit masks, bit i = step i.
+//
+// Every (length, fill) pair is precomputed at compile time, so generating a
+// pattern on the audio thread is a table lookup plus a rotate and never
+// allocates. Shifting matches the old std::rotate-based generators: step i of
+// the shifted pattern is step (i + shift) % length of the unshifted one.
+
+static const int EUCLIDEAN_MAX_LENGTH = 64;
+
+namespace euclidean {
+
+constexpr uint64_t lengthMask(int length) {
+    return length >= 64 ? ~(uint64_t) 0 : (((uint64_t) 1 << length) - 1);
+}
+
+// Onsets at floor(i * length / fill) for i < fill.
+constexpr uint64_t onsets(int length, int fill, int i = 0) {
+    return i >= fill ? 0 : (((uint64_t) 1 << (i * length / fill)) | onsets(length, fill, i + 1));
+}
+
+constexpr uint64_t entry(int length, int fill) {
+    return (length <= 0 || fill <= 0) ? 0 : onsets(length, fill > length ? length : fill);
+}
+
+template <int... I>
+struct Seq {};
+
+template <int N, int... I>
+struct MakeSeq : MakeSeq<N - 1, N - 1, I...> {};
+
+template <int... I>
+struct MakeSeq<0, I...> {
+    typedef Seq<I...> type;
+};
+
+typedef MakeSeq<EUCLIDEAN_MAX_LENGTH + 1>::type Indices;
+
+struct Row {
+    uint64_t fill[EUCLIDEAN_MAX_LENGTH + 1];
+};
+
+struct Table {
+    Row length[EUCLIDEAN_MAX_LENGTH + 1];
+};
+
+template <int... F>
+constexpr Row makeRow(int length, Seq<F...>) {
+    return Row{{entry(length, F)...}};
+}
+
+template <int... L>
+constexpr Table makeTable(Seq<L...>) {
+    return Table{{makeRow(L, Indices())...}};
+}
+
+// Held in a class template so every translation unit shares one copy.
+template <typename T = void>
+struct Patterns {
+    static constexpr Table table = makeTable(Indices());
+};
+
+template <typename T>
+constexpr Table Patterns<T>::table;
+
+} // namespace euclidean
+
+inline uint64_t generateEuclideanPattern(int length, int fill, int shift) {
+    if (length <= 0)
+        return 0;
+    if (length > EUCLIDEAN_MAX_LENGTH)
+        length = EUCLIDEAN_MAX_LENGTH;
+    if (fill < 0)
+        fill = 0;
+    if (fill > length)
+        fill = length;
+
+    uint64_t pattern = euclidean::Patterns<>::table.length[length].fill[fill];
+
+    shift %= length;
+    if (shift < 0)
+        shift += length;
+    if (shift == 0)
+        return pattern;
+    return ((pattern >> shift) | (pattern << (length - shift))) & euclidean::lengthMask(length);
+}
+
+inline bool euclideanStep(uint64_t pattern, int step) {
+    return (unsigned) step < (unsigned) EUCLIDEAN_MAX_LENGTH && ((pattern >> step) & 1);
+}
@@ -0,0 +1,100 @@
+#pragma once
+#include "plugin.hpp"
+#include <cstdint>
+#include <memory>
+
+// Streaming min/max pyramid over groups of four channels (one float_4 each).
+//
+// Level k stores the min and max of consecutive blocks of 2^k samples in a
+// ring of BINS blocks, so it remembers the last BINS * 2^k samples: level 0
+// the last 512 samples, the top level the last 2^24, about 87 s at 192 kHz
+// and almost 6 minutes at 48 kHz.
+// push() writes level 0 and carries every completed pair of blocks up one
+// level, two block updates per sample and group on average. A range can
+// then be reduced from a few blocks per level instead of rescanning samples,
+// which is what lets a scope change its time base without recording again.
+//
+// The groups of one bin sit next to each other, packed for the current
+// group count, so a push touches one short run of memory per level and the
+// memory behind groups that aren't in use is never touched. Changing the
+// group count repacks nothing: the caller has to treat the history from
+// before the change as gone.
+
+struct MinMaxPyramid {
+    static const int LEVELS = 16;
+    static const int BINS = 512;
+
+    struct Block {
+        simd::float_4 min;
+        simd::float_4 max;
+    };
+
+    // Samples pushed so far; also the index of the next one.
+    int64_t written = 0;
+
+    explicit MinMaxPyramid(int maxGroups) : blocks(new Block[(size_t) LEVELS * (BINS * maxGroups + SKEW)]) {
+        setGroups(1);
+    }
+
+    int getGroups() const {
+        return groups;
+    }
+
+    void setGroups(int groups) {
+        this->groups = groups;
+        levelStride = (size_t) BINS * groups + SKEW;
+    }
+
+    // Pushes one sample of every group.
+    void push(const simd::float_4* x) {
+        int64_t n = written++;
+        Block* block = at(0, n);
+        for (int g = 0; g < groups; g++) {
+            block[g].min = block[g].max = x[g];
+        }
+        for (int k = 1; k < LEVELS && (n & 1); k++) {
+            n >>= 1;
+            const Block* lo = at(k - 1, 2 * n);
+            const Block* hi = at(k - 1, 2 * n + 1);
+            Block* up = at(k, n);
+            for (int g = 0; g < groups; g++) {
+                up[g].min = simd::fmin(lo[g].min, hi[g].min);
+                up[g].max = simd::fmax(lo[g].max, hi[g].max);
+            }
+        }
+    }
+
+    // Min and max of `group` over samples [begin, end), which must already be
+    // written. Returns false if part of the range has dropped out of the
+    // levels that would cover it; `out` is then incomplete.
+    bool reduce(int group, int64_t begin, int64_t end, Block& out) const {
+        out.min = INFINITY;
+        out.max = -INFINITY;
+        while (begin < end) {
+            int k = 0;
+            while (k + 1 < LEVELS && (begin & ((int64_t(2) << k) - 1)) == 0 && begin + (int64_t(2) << k) <= end)
+                k++;
+            int64_t index = begin >> k;
+            if (index < (written >> k) - BINS)
+                return false;
+            const Block& block = at(k, index)[group];
+            out.min = simd::fmin(out.min, block.min);
+            out.max = simd::fmax(out.max, block.max);
+            begin += int64_t(1) << k;
+        }
+        return true;
+    }
+
+private:
+    // Levels are spaced a few blocks further apart than they need to be, so
+    // the same bin of every level doesn't fall in the same cache set.
+    static const int SKEW = 3;
+
+    std::unique_ptr<Block[]> blocks;
+    int groups;
+    size_t levelStride;
+
+    Block* at(int level, int64_t index) const {
+        return &blocks[level * levelStride + (index & (BINS - 1)) * groups];
+    }
+};
@@ -0,0 +1,273 @@
+#pragma once
+#include "plugin.hpp"
+#include "cached.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+
+// What one instance's process() costs, and which of its optional engines
+// are running, for a readout on the panel and a JSON export of the patch.
+//
+// A module derives from MeteredModule and opens a PerfMeter::Scope at the
+// top of process(). While the readout is on, the scope times each call.
+// While it is off, the scope only counts the sample. A module can declare
+// up to MAX_STATS stats in its constructor and add() to them from
+// process():
+//   MEAN  average per sample, such as voices awake, or 100 while an engine
+//         runs to get a percentage
+//   RATE  count per second, such as table rebuilds
+// Every WINDOW seconds the audio thread publishes the figures, and the UI
+// reads those.
+
+struct PerfMeter {
+    static const int MAX_STATS = 4;
+    static constexpr float WINDOW = 0.5f;
+
+    enum Kind {
+        MEAN,
+        RATE
+    };
+
+    // Set by the UI thread.
+    std::atomic<bool> timing;
+
+    // Published by the audio thread. `windows` counts the publishes.
+    std::atomic<float> avgNs;
+    std::atomic<float> peakNs;
+    std::atomic<uint32_t> windows;
+
+    PerfMeter() : timing(false), avgNs(0.f), peakNs(0.f), windows(0) {
+        for (int i = 0; i < MAX_STATS; i++) {
+            stats[i].published = 0.f;
+        }
+    }
+
+    // Module constructor only. Returns the id to add() to.
+    int addStat(const char* name, Kind kind) {
+        Stat& stat = stats[statCount];
+        stat.name = name;
+        stat.kind = kind;
+        return statCount++;
+    }
+
+    int getStatCount() const {
+        return statCount;
+    }
+
+    const char* getStatName(int id) const {
+        return stats[id].name;
+    }
+
+    float getStat(int id) const {
+        return stats[id].published.load(std::memory_order_relaxed);
+    }
+
+    // Audio thread.
+    void add(int id, float value) {
+        stats[id].sum += value;
+    }
+
+    struct Scope {
+        PerfMeter& meter;
+        float sampleRate;
+        bool timed;
+        std::chrono::steady_clock::time_point start;
+
+        Scope(PerfMeter& meter, float sampleRate) : meter(meter), sampleRate(sampleRate) {
+            timed = meter.timing.load(std::memory_order_relaxed);
+            if (timed)
+                start = std::chrono::steady_clock::now();
+        }
+
+        ~Scope() {
+            float ns = -1.f;
+            if (timed)
+                ns = std::chrono::duration<float, std::nano>(std::chrono::steady_clock::now() - start).count();
+            meter.endSample(ns, sampleRate);
+        }
+    };
+
+private:
+    struct Stat {
+        const char* name = "";
+        Kind kind = MEAN;
+        float sum = 0.f;
+        std::atomic<float> published;
+    };
+
+    Stat stats[MAX_STATS];
+    int statCount = 0;
+
+    int samples = 0;
+    int timedSamples = 0;
+    double sumNs = 0.0;
+    float maxNs = 0.f;
+
+    void endSample(float ns, float sampleRate) {
+        if (ns >= 0.f) {
+            timedSamples++;
+            sumNs += ns;
+            maxNs = std::max(maxNs, ns);
+        }
+        if (++samples < (int) (WINDOW * sampleRate))
+            return;
+
+        avgNs.store(timedSamples ? (float) (sumNs / timedSamples) : 0.f, std::memory_order_relaxed);
+        peakNs.store(maxNs, std::memory_order_relaxed);
+        for (int i = 0; i < statCount; i++) {
+            Stat& stat = stats[i];
+            float divisor = (stat.kind == RATE) ? samples / sampleRate : samples;
+            stat.published.store(stat.sum / divisor, std::memory_order_relaxed);
+            stat.sum = 0.f;
+        }
+        windows.fetch_add(1, std::memory_order_release);
+        samples = 0;
+        timedSamples = 0;
+        sumNs = 0.0;
+        maxNs = 0.f;
+    }
+};
+
+struct MeteredModule : Module {
+    PerfMeter perf;
+    // What the last export from this module's menu wrote, or why it failed;
+    // shown in the menu. UI thread only.
+    std::string perfExport;
+};
+
+// Every MADZINE module in the patch.
+inline std::vector<MeteredModule*> meteredModules() {
+    std::vector<MeteredModule*> modules;
+    for (int64_t id : APP->engine->getModuleIds()) {
+        MeteredModule* module = dynamic_cast<MeteredModule*>(APP->engine->getModule(id));
+        if (module)
+            modules.push_back(module);
+    }
+    return modules;
+}
+
+// Writes the published figures of every MADZINE module in the patch to
+// <user folder>/MADZINE/perf-<time>.json. Returns the path, or "" if the
+// file can't be written.
+inline std::string exportPerfJson() {
+    float sampleRate = APP->engine->getSampleRate();
+    json_t* rootJ = json_object();
+    json_object_set_new(rootJ, "sampleRate", json_real(sampleRate));
+    json_t* modulesJ = json_array();
+    for (MeteredModule* module : meteredModules()) {
+        const PerfMeter& perf = module->perf;
+        json_t* moduleJ = json_object();
+        json_object_set_new(moduleJ, "id", json_integer(module->id));
+        json_object_set_new(moduleJ, "slug", json_string(module->model ? module->model->slug.c_str() : ""));
+        bool timing = perf.timing.load();
+        json_object_set_new(moduleJ, "timing", json_boolean(timing));
+        if (timing) {
+            float avgNs = perf.avgNs.load();
+            json_object_set_new(moduleJ, "avgNs", json_real(avgNs));
+            json_object_set_new(moduleJ, "peakNs", json_real(perf.peakNs.load()));
+            json_object_set_new(moduleJ, "samplePeriodPercent", json_real(avgNs * sampleRate * 1e-7f));
+        }
+        json_t* statsJ = json_object();
+        for (int i = 0; i < perf.getStatCount(); i++) {
+            json_object_set_new(statsJ, perf.getStatName(i), json_real(perf.getStat(i)));
+        }
+        json_object_set_new(moduleJ, "stats", statsJ);
+        json_array_append_new(modulesJ, moduleJ);
+    }
+    json_object_set_new(rootJ, "modules", modulesJ);
+
+    std::string dir = asset::user("MADZINE");
+    system::createDirectories(dir);
+    std::time_t now = std::time(NULL);
+    char name[64];
+    std::strftime(name, sizeof(name), "perf-%Y%m%d-%H%M%S.json", std::localtime(&now));
+    std::string path = dir + "/" + name;
+
+    char* text = json_dumps(rootJ, JSON_INDENT(2));
+    json_decref(rootJ);
+    FILE* file = text ? std::fopen(path.c_str(), "w") : NULL;
+    if (file) {
+        std::fputs(text, file);
+        std::fclose(file);
+    }
+    std::free(text);
+    return file ? path : "";
+}
+
+// Readout drawn over the top of the panel while timing is on.
+struct PerfReadout : CachedTransparentWidget {
+    static constexpr float LINE_HEIGHT = 9.f;
+
+    MeteredModule* module;
+
+    PerfReadout(MeteredModule* module, float width) : module(module) {
+        int lines = 3 + (module ? module->perf.getStatCount() : 0);
+        box.pos = Vec(2, 30);
+        box.size = Vec(width - 4, lines * LINE_HEIGHT + 4);
+    }
+
+    float cacheKey() override {
+        if (!module || !module->perf.timing.load(std::memory_order_relaxed))
+            return -1.f;
+        return module->perf.windows.load(std::memory_order_acquire);
+    }
+
+    void drawCached(const DrawArgs& args) override {
+        if (!module || !module->perf.timing.load(std::memory_order_relaxed))
+            return;
+        const PerfMeter& perf = module->perf;
+
+        nvgBeginPath(args.vg);
+        nvgRoundedRect(args.vg, 0, 0, box.size.x, box.size.y, 2);
+        nvgFillColor(args.vg, nvgRGBA(0, 0, 0, 210));
+        nvgFill(args.vg);
+
+        nvgFontSize(args.vg, 8.f);
+        nvgFontFaceId(args.vg, APP->window->uiFont->handle);
+        nvgTextAlign(args.vg, NVG_ALIGN_LEFT | NVG_ALIGN_TOP);
+        nvgFillColor(args.vg, nvgRGB(255, 255, 255));
+
+        float avgNs = perf.avgNs.load(std::memory_order_relaxed);
+        float y = 2.f;
+        std::string lines[3] = {
+            string::f("avg %.0f ns", avgNs),
+            string::f("peak %.0f ns", perf.peakNs.load(std::memory_order_relaxed)),
+            string::f("%.2f%% of period", avgNs * APP->engine->getSampleRate() * 1e-7f),
+        };
+        for (const std::string& line : lines) {
+            nvgText(args.vg, 3, y, line.c_str(), NULL);
+            y += LINE_HEIGHT;
+        }
+        nvgFillColor(args.vg, nvgRGB(255, 200, 0));
+        for (int i = 0; i < perf.getStatCount(); i++) {
+            std::string line = string::f("%s %.1f", perf.getStatName(i), perf.getStat(i));
+            nvgText(args.vg, 3, y, line.c_str(), NULL);
+            y += LINE_HEIGHT;
+        }
+    }
+};
+
+inline void appendPerfMenu(Menu* menu, MeteredModule* module) {
+    menu->addChild(new MenuSeparator);
+    menu->addChild(createMenuLabel("Performance"));
+    menu->addChild(createBoolMenuItem("Show readout", "",
+        [=]() { return module->perf.timing.load(); },
+        [=](bool on) { module->perf.timing = on; }));
+    menu->addChild(createMenuItem("Show on all MADZINE modules", "", []() {
+        for (MeteredModule* m : meteredModules())
+            m->perf.timing = true;
+    }));
+    menu->addChild(createMenuItem("Hide on all MADZINE modules", "", []() {
+        for (MeteredModule* m : meteredModules())
+            m->perf.timing = false;
+    }));
+    menu->addChild(createMenuItem("Export performance to JSON", "", [=]() {
+        std::string path = exportPerfJson();
+        module->perfExport = path.empty() ? "Export failed: can't write to " + asset::user("MADZINE") : path;
+    }));
+    if (!module->perfExport.empty()) {
+        menu->addChild(createMenuLabel(module->perfExport));
+    }
+}
@@ -0,0 +1,108 @@
+#pragma once
+#include "perf.hpp"
+#include "minmax.hpp"
+#include "triplebuffer.hpp"
+#include <atomic>
+#include <vector>
+
+// One sweep of up to eight poly tracks as the display draws it: for each
+// channel, the min and max of the input over each of POINTS points. Points
+// not rendered yet are empty (min > max).
+
+struct ScopePoint {
+    float min = INFINITY;
+    float max = -INFINITY;
+};
+
+struct ScopeFrame {
+    static const int TRACKS = 8;
+    static const int POINTS = 256; // Same as VCV Scope
+    static const int MAX_CHANNELS = 16;
+
+    int channels[TRACKS] = {};
+    // POINTS per channel, the channels of each track after those of the
+    // track before. Only as long as the frame was built for.
+    std::vector<ScopePoint> points;
+
+    explicit ScopeFrame(int slots = 0) : points((size_t) slots * POINTS) {}
+
+    const ScopePoint* track(int track, int channel) const {
+        int slot = channel;
+        for (int i = 0; i < track; i++)
+            slot += channels[i];
+        return &points[(size_t) slot * POINTS];
+    }
+};
+
+// Everything behind a scope that grows with the channel count, sized for a
+// number of slots (channels, in whole float_4 groups): the history, the
+// sweep being rendered, one row of POINTS per slot, and the frames handed to
+// the display.
+struct ScopeStorage {
+    const int slots;
+    MinMaxPyramid history;
+    std::vector<ScopePoint> sweep;
+    TripleBuffer<ScopeFrame> frames;
+
+    explicit ScopeStorage(int slots) : slots(slots), history(slots / 4), sweep((size_t) slots * ScopeFrame::POINTS), frames(ScopeFrame(slots)) {}
+};
+
+// A module that hands scope frames to its display. The storage lives on the
+// heap, sized for the most channels patched so far. process() never
+// allocates: when its layout outgrows the storage it sets scopeSlotsWanted,
+// the UI thread builds a bigger one in growScope(), and process() takes it
+// over in takeScope() and hands the old one back to be freed. Until then
+// the scope has nothing to record into.
+//
+// The display reads frames from `scope`. The bench, which has no UI
+// thread, calls growScope() between blocks and reads the frames the same
+// way.
+struct ScopeModule : MeteredModule {
+    // Eight mono tracks.
+    static const int MIN_SLOTS = 8;
+
+    std::atomic<ScopeStorage*> scope;
+    std::atomic<int> scopeSlotsWanted;
+
+    ScopeModule() : scope(new ScopeStorage(MIN_SLOTS)), scopeSlotsWanted(0), nextScope(NULL), oldScope(NULL) {}
+
+    ~ScopeModule() {
+        delete scope.load();
+        delete nextScope.load();
+        delete oldScope.load();
+    }
+
+    // UI thread. Frees the storage process() let go of, and builds the one
+    // it asked for unless a swap is still under way.
+    void growScope() {
+        delete oldScope.exchange(NULL, std::memory_order_acquire);
+        int wanted = scopeSlotsWanted.load(std::memory_order_relaxed);
+        // takeScope() sets oldScope before it clears nextScope, so with both
+        // empty nothing is in flight.
+        if (nextScope.load(std::memory_order_acquire) || oldScope.load(std::memory_order_acquire))
+            return;
+        if (wanted > scope.load(std::memory_order_acquire)->slots)
+            nextScope.store(new ScopeStorage(wanted), std::memory_order_release);
+    }
+
+    // Audio thread. Swaps in the storage growScope() built, if there is one.
+    // The new history carries on the old one's sample count but none of its
+    // samples, so the caller has to treat everything before the swap as
+    // gone. `scope` is updated first, so the display never reads storage
+    // that has been handed back.
+    bool takeScope() {
+        ScopeStorage* next = nextScope.load(std::memory_order_acquire);
+        if (!next)
+            return false;
+        ScopeStorage* old = scope.load(std::memory_order_relaxed);
+        next->history.written = old->history.written;
+        scope.store(next, std::memory_order_release);
+        oldScope.store(old, std::memory_order_release);
+        nextScope.store(NULL, std::memory_order_release);
+        return true;
+    }
+
+private:
+    std::atomic<ScopeStorage*> nextScope;
+    std::atomic<ScopeStorage*> oldScope;
+};
@@ -0,0 +1,129 @@
+#pragma once
+#include "plugin.hpp"
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+// Per-track spectra with everything but a copy kept off the audio thread.
+//
+// SpectrumTap is the audio side: process() copies each frame of eight
+// tracks into a ring and bumps a counter. SpectrumAnalyzer lives in the
+// widget and, once per drawn frame with new samples, copies the newest
+// FFT_SIZE frames out, windows them, runs dsp::RealFFT, and folds the bins
+// into log-spaced bands with a fast-attack/slow-release smoothing.
+//
+// The ring is four times the FFT length. The reader checks the counter
+// again after copying and drops the read if the writer could have lapped
+// it, so a stalled UI never draws a torn window.
+
+struct SpectrumTap {
+    static const int TRACKS = 8;
+    static const uint32_t SIZE = 8192;
+
+    float frames[SIZE][TRACKS];
+    std::atomic<uint32_t> written;
+
+    SpectrumTap() : written(0) {}
+
+    // Audio thread.
+    void push(const float* frame) {
+        uint32_t n = written.load(std::memory_order_relaxed);
+        std::memcpy(frames[n & (SIZE - 1)], frame, sizeof(frames[0]));
+        written.store(n + 1, std::memory_order_release);
+    }
+
+    // Copies the newest `length` frames into `out`, oldest first. Returns
+    // false if the writer overwrote any of them while they were copied.
+    bool read(float (*out)[TRACKS], uint32_t length, uint32_t& end) const {
+        end = written.load(std::memory_order_acquire);
+        uint32_t begin = end - length;
+        for (uint32_t i = 0; i < length; i++) {
+            std::memcpy(out[i], frames[(begin + i) & (SIZE - 1)], sizeof(frames[0]));
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        // push() fills slot `written` before it bumps the counter, so at
+        // begin + SIZE the writer may already be inside slot `begin`.
+        return written.load(std::memory_order_relaxed) - begin < SIZE;
+    }
+};
+
+struct SpectrumAnalyzer {
+    static const int TRACKS = SpectrumTap::TRACKS;
+    static const int FFT_SIZE = 2048;
+    static const int BANDS = 96;
+    static constexpr float MIN_FREQ = 20.f;
+    static constexpr float MAX_FREQ = 20000.f;
+    static constexpr float MIN_DB = -96.f;
+    static constexpr float MAX_DB = 24.f;
+
+    // Smoothed level of each band in dB re 1 V, MIN_DB to MAX_DB.
+    float levels[TRACKS][BANDS];
+
+    SpectrumAnalyzer() : fft(FFT_SIZE) {
+        for (int i = 0; i < FFT_SIZE; i++) {
+            window[i] = 0.5f - 0.5f * std::cos(2.f * M_PI * i / FFT_SIZE);
+        }
+        for (int t = 0; t < TRACKS; t++) {
+            for (int b = 0; b < BANDS; b++) {
+                levels[t][b] = MIN_DB;
+            }
+        }
+    }
+
+    // UI thread. Returns whether the levels changed.
+    bool update(const SpectrumTap& tap, float sampleRate) {
+        if (tap.written.load(std::memory_order_relaxed) == lastEnd)
+            return false;
+        uint32_t end;
+        if (!tap.read(frames, FFT_SIZE, end))
+            return false;
+        lastEnd = end;
+        if (sampleRate != bandRate)
+            layoutBands(sampleRate);
+
+        // Hann window: a full-scale sine of amplitude A peaks at A * N / 4.
+        const float scale = 4.f / FFT_SIZE;
+        for (int t = 0; t < TRACKS; t++) {
+            for (int i = 0; i < FFT_SIZE; i++) {
+                input[i] = frames[i][t] * window[i];
+            }
+            fft.rfft(input, output);
+            for (int b = 0; b < BANDS; b++) {
+                // Low bands are narrower than a bin and share one.
+                int last = std::max(bandBins[b] + 1, bandBins[b + 1]);
+                float peak = 0.f;
+                for (int k = bandBins[b]; k < last; k++) {
+                    float re = output[2 * k];
+                    float im = output[2 * k + 1];
+                    peak = std::max(peak, re * re + im * im);
+                }
+                float db = 10.f * std::log10(peak * scale * scale + 1e-12f);
+                db = clamp(db, MIN_DB, MAX_DB);
+                float& level = levels[t][b];
+                level = db > level ? db : level + 0.2f * (db - level);
+            }
+        }
+        return true;
+    }
+
+private:
+    dsp::RealFFT fft;
+    alignas(16) float input[FFT_SIZE];
+    alignas(16) float output[2 * FFT_SIZE];
+    float window[FFT_SIZE];
+    float frames[FFT_SIZE][TRACKS];
+    // FFT bins [bandBins[b], bandBins[b + 1]) make up band b.
+    int bandBins[BANDS + 1];
+    float bandRate = 0.f;
+    uint32_t lastEnd = 0;
+
+    void layoutBands(float sampleRate) {
+        bandRate = sampleRate;
+        float maxFreq = std::min((float) MAX_FREQ, 0.5f * sampleRate);
+        float binHz = sampleRate / FFT_SIZE;
+        for (int b = 0; b <= BANDS; b++) {
+            float freq = MIN_FREQ * std::pow(maxFreq / MIN_FREQ, (float) b / BANDS);
+            bandBins[b] = clamp((int) (freq / binHz + 0.5f), 1, FFT_SIZE / 2 - 1);
+        }
+    }
+};
@@ -0,0 +1,72 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+// Lock-free hand-off of whole frames from the audio thread to the UI.
+//
+// Three slots: the writer owns one, the reader owns one, and the third sits
+// in `shared` together with a "fresh" bit. publish() swaps the writer's slot
+// into `shared`, consume() swaps the reader's slot out for it, so each side
+// only ever touches a slot nobody else holds. Neither side waits on the
+// other, and the reader always sees a frame exactly as it was published. If
+// the writer publishes twice before the reader looks, the older frame is
+// simply dropped.
+//
+// One writer thread and one reader thread only.
+
+template <typename T>
+struct TripleBuffer {
+    TripleBuffer() : shared(2) {}
+
+    // All three slots start as copies of `prototype`, for frames whose
+    // size is set when they are built.
+    explicit TripleBuffer(const T& prototype) : shared(2) {
+        for (Slot& slot : slots)
+            slot.frame = prototype;
+    }
+
+    T& writeBuffer() {
+        return slots[writeIndex].frame;
+    }
+
+    void publish() {
+        slots[writeIndex].sequence = ++writeSequence;
+        uint32_t previous = shared.exchange(writeIndex | FRESH, std::memory_order_acq_rel);
+        writeIndex = previous & INDEX_MASK;
+    }
+
+    // Takes the newest published frame if one arrived since the last call.
+    // Returns false, and leaves readBuffer() as it was, otherwise.
+    bool consume() {
+        if (!(shared.load(std::memory_order_relaxed) & FRESH))
+            return false;
+        uint32_t previous = shared.exchange(readIndex, std::memory_order_acq_rel);
+        readIndex = previous & INDEX_MASK;
+        return true;
+    }
+
+    const T& readBuffer() const {
+        return slots[readIndex].frame;
+    }
+
+    // Number of the frame in readBuffer(), counting publishes from 1; 0 until
+    // the first frame has been consumed.
+    uint64_t readSequence() const {
+        return slots[readIndex].sequence;
+    }
+
+private:
+    static const uint32_t INDEX_MASK = 3;
+    static const uint32_t FRESH = 4;
+
+    struct Slot {
+        T frame = T();
+        uint64_t sequence = 0;
+    };
+
+    Slot slots[3];
+    std::atomic<uint32_t> shared;
+    uint32_t writeIndex = 0;
+    uint32_t readIndex = 1;
+    uint64_t writeSequence = 0;
+};
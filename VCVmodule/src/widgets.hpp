@@ -0,0 +1,242 @@
+#pragma once
+#include "plugin.hpp"
+#include "cached.hpp"
+
+// Panel widgets shared by every module.
+//
+// Knobs are one template over size, look and drag response, so modules that
+// use the same knob share one instantiation instead of each compiling its
+// own copy under its own name. Looks only differ in colours and proportions.
+
+struct BlackKnobLook {
+    static NVGcolor face() {
+        return nvgRGB(50, 50, 50);
+    }
+    static NVGcolor pointer() {
+        return nvgRGB(255, 255, 255);
+    }
+    // Width of the dark ring around the face.
+    static constexpr float RIM = 4.f;
+    // Distance from the pointer tip to the edge of the knob.
+    static constexpr float POINTER_GAP = 8.f;
+    static constexpr float POINTER_WIDTH = 2.f;
+};
+
+struct NarrowRimBlackKnobLook : BlackKnobLook {
+    static constexpr float RIM = 3.f;
+};
+
+struct GrayKnobLook : BlackKnobLook {
+    static NVGcolor face() {
+        return nvgRGB(130, 130, 130);
+    }
+};
+
+struct LightGrayKnobLook : BlackKnobLook {
+    static NVGcolor face() {
+        return nvgRGB(180, 180, 180);
+    }
+    static constexpr float RIM = 3.f;
+    static constexpr float POINTER_GAP = 6.f;
+    static constexpr float POINTER_WIDTH = 1.5f;
+};
+
+struct WhiteKnobLook : BlackKnobLook {
+    static NVGcolor face() {
+        return nvgRGB(255, 255, 255);
+    }
+    static NVGcolor pointer() {
+        return nvgRGB(255, 133, 133);
+    }
+};
+
+template <int SIZE, class TLook>
+struct KnobFace : CachedParamWidget {
+    KnobFace() {
+        box.size = Vec(SIZE, SIZE);
+    }
+
+    virtual float getDisplayAngle() {
+        ParamQuantity* pq = getParamQuantity();
+        if (!pq) return 0.0f;
+
+        return rescale(pq->getScaledValue(), 0.0f, 1.0f, -0.75f * M_PI, 0.75f * M_PI);
+    }
+
+    void drawCached(const DrawArgs& args) override {
+        float radius = box.size.x / 2.0f;
+        float angle = getDisplayAngle();
+
+        nvgBeginPath(args.vg);
+        nvgCircle(args.vg, radius, radius, radius - 1);
+        nvgFillColor(args.vg, nvgRGB(30, 30, 30));
+        nvgFill(args.vg);
+
+        nvgBeginPath(args.vg);
+        nvgCircle(args.vg, radius, radius, radius - 1);
+        nvgStrokeWidth(args.vg, 1.0f);
+        nvgStrokeColor(args.vg, nvgRGB(100, 100, 100));
+        nvgStroke(args.vg);
+
+        nvgBeginPath(args.vg);
+        nvgCircle(args.vg, radius, radius, radius - TLook::RIM);
+        nvgFillColor(args.vg, TLook::face());
+        nvgFill(args.vg);
+
+        float indicatorLength = radius - TLook::POINTER_GAP;
+        float lineX = radius + indicatorLength * std::sin(angle);
+        float lineY = radius - indicatorLength * std::cos(angle);
+
+        nvgBeginPath(args.vg);
+        nvgMoveTo(args.vg, radius, radius);
+        nvgLineTo(args.vg, lineX, lineY);
+        nvgStrokeWidth(args.vg, TLook::POINTER_WIDTH);
+        nvgStrokeColor(args.vg, TLook::pointer());
+        nvgStroke(args.vg);
+
+        nvgBeginPath(args.vg);
+        nvgCircle(args.vg, lineX, lineY, TLook::POINTER_WIDTH);
+        nvgFillColor(args.vg, TLook::pointer());
+        nvgFill(args.vg);
+    }
+
+    void onDoubleClick(const event::DoubleClick& e) override {
+        ParamQuantity* pq = getParamQuantity();
+        if (!pq) return;
+
+        pq->reset();
+        e.consume(this);
+    }
+};
+
+// Continuous knob: each pixel of vertical drag moves it DRAG_PERMILLE
+// thousandths of its range.
+template <int SIZE, class TLook = BlackKnobLook, int DRAG_PERMILLE = 2>
+struct MadzineKnob : KnobFace<SIZE, TLook> {
+    bool isDragging = false;
+
+    void onButton(const event::Button& e) override {
+        if (e.action == GLFW_PRESS && e.button == GLFW_MOUSE_BUTTON_LEFT) {
+            isDragging = true;
+            e.consume(this);
+        }
+        else if (e.action == GLFW_RELEASE && e.button == GLFW_MOUSE_BUTTON_LEFT) {
+            isDragging = false;
+        }
+        ParamWidget::onButton(e);
+    }
+
+    void onDragMove(const event::DragMove& e) override {
+        ParamQuantity* pq = this->getParamQuantity();
+        if (!isDragging || !pq) return;
+
+        float sensitivity = DRAG_PERMILLE * 0.001f;
+        float range = pq->getMaxValue() - pq->getMinValue();
+        float newValue = pq->getValue() - e.mouseDelta.y * sensitivity * range;
+        pq->setValue(clamp(newValue, pq->getMinValue(), pq->getMaxValue()));
+    }
+};
+
+// Stepped knob: moves one step per SNAP_PIXELS of drag up or to the right.
+template <int SIZE, class TLook = BlackKnobLook, int SNAP_PIXELS = 10>
+struct MadzineSnapKnob : KnobFace<SIZE, TLook> {
+    float accumDelta = 0.0f;
+
+    void onButton(const event::Button& e) override {
+        if (e.action == GLFW_PRESS && e.button == GLFW_MOUSE_BUTTON_LEFT) {
+            accumDelta = 0.0f;
+            e.consume(this);
+        }
+        ParamWidget::onButton(e);
+    }
+
+    void onDragMove(const event::DragMove& e) override {
+        ParamQuantity* pq = this->getParamQuantity();
+        if (!pq) return;
+
+        accumDelta += (e.mouseDelta.x - e.mouseDelta.y);
+
+        if (accumDelta >= SNAP_PIXELS) {
+            pq->setValue(clamp(pq->getValue() + 1.0f, pq->getMinValue(), pq->getMaxValue()));
+            accumDelta = 0.0f;
+        }
+        else if (accumDelta <= -SNAP_PIXELS) {
+            pq->setValue(clamp(pq->getValue() - 1.0f, pq->getMinValue(), pq->getMaxValue()));
+            accumDelta = 0.0f;
+        }
+    }
+};
+
+typedef MadzineKnob<26> StandardBlackKnob;
+typedef MadzineKnob<30> LargeBlackKnob;
+typedef MadzineSnapKnob<26> SnapKnob;
+
+// Draws label text centred in a box of `size`, in the current font,
+// thickened with four offset passes when bold. Returns the area the text
+// covers, which can be wider than the box.
+inline math::Rect drawLabelText(NVGcontext* vg, Vec size, const std::string& text, bool bold) {
+    const float offset = 0.3f;
+    float x = size.x / 2.f;
+    float y = size.y / 2.f;
+    nvgTextAlign(vg, NVG_ALIGN_CENTER | NVG_ALIGN_MIDDLE);
+    if (bold) {
+        nvgText(vg, x - offset, y, text.c_str(), NULL);
+        nvgText(vg, x + offset, y, text.c_str(), NULL);
+        nvgText(vg, x, y - offset, text.c_str(), NULL);
+        nvgText(vg, x, y + offset, text.c_str(), NULL);
+    }
+    nvgText(vg, x, y, text.c_str(), NULL);
+
+    float bounds[4] = {x, y, x, y};
+    nvgTextBounds(vg, x, y, text.c_str(), NULL, bounds);
+    // A pixel for antialiasing, plus the bold offsets.
+    return math::Rect::fromMinMax(Vec(bounds[0], bounds[1]), Vec(bounds[2], bounds[3])).grow(Vec(1.f + (bold ? offset : 0.f)));
+}
+
+struct EnhancedTextLabel : CachedTransparentWidget {
+    std::string text;
+    float fontSize;
+    NVGcolor color;
+    bool bold;
+    math::Rect textBounds;
+
+    EnhancedTextLabel(Vec pos, Vec size, const std::string& text, float fontSize = 12.f,
+                      NVGcolor color = nvgRGB(255, 255, 255), bool bold = true) {
+        box.pos = pos;
+        box.size = size;
+        this->text = text;
+        this->fontSize = fontSize;
+        this->color = color;
+        this->bold = bold;
+    }
+
+    // Measured on the first draw, which then runs again over the whole text.
+    math::Rect cacheBounds() override {
+        return box.zeroPos().expand(textBounds);
+    }
+
+    void drawCached(const DrawArgs &args) override {
+        nvgFontSize(args.vg, fontSize);
+        nvgFontFaceId(args.vg, APP->window->uiFont->handle);
+        nvgFillColor(args.vg, color);
+        textBounds = drawLabelText(args.vg, box.size, text, bold);
+    }
+};
+
+struct WhiteBackgroundBox : Widget {
+    WhiteBackgroundBox(Vec pos, Vec size) {
+        box.pos = pos;
+        box.size = size;
+    }
+
+    void draw(const DrawArgs &args) override {
+        nvgBeginPath(args.vg);
+        nvgRect(args.vg, 0, 0, box.size.x, box.size.y);
+        nvgFillColor(args.vg, nvgRGB(255, 255, 255));
+        nvgFill(args.vg);
+
+        nvgStrokeWidth(args.vg, 1.0f);
+        nvgStrokeColor(args.vg, nvgRGBA(200, 200, 200, 255));
+        nvgStroke(args.vg);
+    }
+};
@@ -0,0 +1,342 @@
+#pragma once
+#include <cmath>
+#include "denormal.hpp"
+
+// Anti-aliasing filters for the oversampled Ripples cores (Pinpple, TWNC).
+//
+// Elliptic lowpass, 0.1 dB ripple up to 20 kHz and 100 dB rejection from the
+// Nyquist frequency of the base rate, one table per supported rate and
+// oversampling factor.
+
+namespace ripples
+{
+struct SOSCoefficients
+{
+    float b[3];
+    float a[2];
+};
+
+template <typename T, int max_num_sections>
+class SOSFilter
+{
+public:
+    SOSFilter()
+    {
+        Init(0);
+    }
+    SOSFilter(int num_sections)
+    {
+        Init(num_sections);
+    }
+    void Init(int num_sections)
+    {
+        num_sections_ = num_sections;
+        Reset();
+    }
+    void Init(int num_sections, const SOSCoefficients* sections)
+    {
+        num_sections_ = num_sections;
+        Reset();
+        SetCoefficients(sections);
+    }
+    void Reset()
+    {
+        for (int n = 0; n < num_sections_; n++)
+        {
+            x_[n][0] = 0.f;
+            x_[n][1] = 0.f;
+            x_[n][2] = 0.f;
+        }
+        x_[num_sections_][0] = 0.f;
+        x_[num_sections_][1] = 0.f;
+        x_[num_sections_][2] = 0.f;
+    }
+    void SetCoefficients(const SOSCoefficients* sections)
+    {
+        for (int n = 0; n < num_sections_; n++)
+        {
+            sections_[n].b[0] = sections[n].b[0];
+            sections_[n].b[1] = sections[n].b[1];
+            sections_[n].b[2] = sections[n].b[2];
+            sections_[n].a[0] = sections[n].a[0];
+            sections_[n].a[1] = sections[n].a[1];
+        }
+    }
+    T Process(T in)
+    {
+        for (int n = 0; n < num_sections_; n++)
+        {
+            x_[n][2] = x_[n][1];
+            x_[n][1] = x_[n][0];
+            x_[n][0] = flushDenormal(in);
+            T out = 0.f;
+            out += sections_[n].b[0] * x_[n][0];
+            out += sections_[n].b[1] * x_[n][1];
+            out += sections_[n].b[2] * x_[n][2];
+            out -= sections_[n].a[0] * x_[n+1][0];
+            out -= sections_[n].a[1] * x_[n+1][1];
+            in = out;
+        }
+        x_[num_sections_][2] = x_[num_sections_][1];
+        x_[num_sections_][1] = x_[num_sections_][0];
+        x_[num_sections_][0] = flushDenormal(in);
+        return x_[num_sections_][0];
+    }
+    // Whether `quiet` holds for every value in the state, so the filter
+    // would output only quiet values from here on with quiet input.
+    template <typename F>
+    bool IsQuiet(F quiet) const
+    {
+        for (int n = 0; n <= num_sections_; n++)
+        {
+            if (!quiet(x_[n][0]) || !quiet(x_[n][1]) || !quiet(x_[n][2]))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+    // Takes over the state of `other`, a filter with the same sections over
+    // another type, passing each stored value through convert().
+    template <typename U, typename F>
+    void CopyState(const SOSFilter<U, max_num_sections>& other, F convert)
+    {
+        for (int n = 0; n <= num_sections_; n++)
+        {
+            x_[n][0] = convert(other.x_[n][0]);
+            x_[n][1] = convert(other.x_[n][1]);
+            x_[n][2] = convert(other.x_[n][2]);
+        }
+    }
+protected:
+    template <typename, int> friend class SOSFilter;
+    int num_sections_;
+    SOSCoefficients sections_[max_num_sections];
+    T x_[max_num_sections + 1][3];
+};
+
+static const SOSCoefficients kFilter44100x2[6] =
+{
+    { {1.79143286e-03,  3.36319763e-03,  1.79143286e-03,  }, {-1.13741805e+00, 3.66252522e-01,  } },
+    { {1.00000000e+00,  1.20715509e+00,  1.00000000e+00,  }, {-9.11547925e-01, 5.12541952e-01,  } },
+    { {1.00000000e+00,  6.02866140e-01,  1.00000000e+00,  }, {-6.39360319e-01, 6.90606291e-01,  } },
+    { {1.00000000e+00,  2.52492791e-01,  1.00000000e+00,  }, {-4.37976426e-01, 8.26943183e-01,  } },
+    { {1.00000000e+00,  7.75110469e-02,  1.00000000e+00,  }, {-3.22059399e-01, 9.15517333e-01,  } },
+    { {1.00000000e+00,  6.25229517e-03,  1.00000000e+00,  }, {-2.73475650e-01, 9.74750328e-01,  } },
+};
+
+static const SOSCoefficients kFilter44100x3[7] =
+{
+    { {2.33490105e-04,  3.85181850e-04,  2.33490105e-04,  }, {-1.46779388e+00, 5.59296808e-01,  } },
+    { {1.00000000e+00,  2.84325800e-01,  1.00000000e+00,  }, {-1.39742510e+00, 6.47278589e-01,  } },
+    { {1.00000000e+00,  -4.81750855e-01, 1.00000000e+00,  }, {-1.30466314e+00, 7.63828957e-01,  } },
+    { {1.00000000e+00,  -8.14468625e-01, 1.00000000e+00,  }, {-1.22921239e+00, 8.60154933e-01,  } },
+    { {1.00000000e+00,  -9.63431645e-01, 1.00000000e+00,  }, {-1.18164528e+00, 9.24280676e-01,  } },
+    { {1.00000000e+00,  -1.03103071e+00, 1.00000000e+00,  }, {-1.15782369e+00, 9.63658019e-01,  } },
+    { {1.00000000e+00,  -1.05757969e+00, 1.00000000e+00,  }, {-1.15253845e+00, 9.89273089e-01,  } },
+};
+
+static const SOSCoefficients kFilter44100x4[7] =
+{
+    { {9.04030987e-05,  1.24784822e-04,  9.04030987e-05,  }, {-1.60481627e+00, 6.56434483e-01,  } },
+    { {1.00000000e+00,  -3.56878584e-01, 1.00000000e+00,  }, {-1.58105325e+00, 7.23024321e-01,  } },
+    { {1.00000000e+00,  -1.02955161e+00, 1.00000000e+00,  }, {-1.54932549e+00, 8.12753315e-01,  } },
+    { {1.00000000e+00,  -1.27718546e+00, 1.00000000e+00,  }, {-1.52341526e+00, 8.88249727e-01,  } },
+    { {1.00000000e+00,  -1.38079905e+00, 1.00000000e+00,  }, {-1.50765892e+00, 9.39194474e-01,  } },
+    { {1.00000000e+00,  -1.42644772e+00, 1.00000000e+00,  }, {-1.50140266e+00, 9.70748307e-01,  } },
+    { {1.00000000e+00,  -1.44414942e+00, 1.00000000e+00,  }, {-1.50394545e+00, 9.91364552e-01,  } },
+};
+
+static const SOSCoefficients kFilter48000x2[6] =
+{
+    { {1.13607815e-03,  2.09710115e-03,  1.13607815e-03,  }, {-1.21931845e+00, 4.08933254e-01,  } },
+    { {1.00000000e+00,  1.04601876e+00,  1.00000000e+00,  }, {-1.03580025e+00, 5.39844154e-01,  } },
+    { {1.00000000e+00,  3.80916327e-01,  1.00000000e+00,  }, {-8.08830338e-01, 7.03595041e-01,  } },
+    { {1.00000000e+00,  1.72815250e-02,  1.00000000e+00,  }, {-6.37029110e-01, 8.32367841e-01,  } },
+    { {1.00000000e+00,  -1.58681120e-01, 1.00000000e+00,  }, {-5.37547766e-01, 9.17642098e-01,  } },
+    { {1.00000000e+00,  -2.29300230e-01, 1.00000000e+00,  }, {-4.97997645e-01, 9.75321067e-01,  } },
+};
+
+static const SOSCoefficients kFilter48000x3[6] =
+{
+    { {1.96007199e-04,  3.15285921e-04,  1.96007199e-04,  }, {-1.49750952e+00, 5.79487424e-01,  } },
+    { {1.00000000e+00,  1.64502383e-01,  1.00000000e+00,  }, {-1.43900370e+00, 6.63196513e-01,  } },
+    { {1.00000000e+00,  -5.92180251e-01, 1.00000000e+00,  }, {-1.36241892e+00, 7.75058824e-01,  } },
+    { {1.00000000e+00,  -9.07488127e-01, 1.00000000e+00,  }, {-1.30223398e+00, 8.69165582e-01,  } },
+    { {1.00000000e+00,  -1.04177534e+00, 1.00000000e+00,  }, {-1.26951947e+00, 9.34679234e-01,  } },
+    { {1.00000000e+00,  -1.09276235e+00, 1.00000000e+00,  }, {-1.26454687e+00, 9.80322986e-01,  } },
+};
+
+static const SOSCoefficients kFilter48000x4[6] =
+{
+    { {7.97745226e-05,  1.05323637e-04,  7.97745226e-05,  }, {-1.62539777e+00, 6.71953386e-01,  } },
+    { {1.00000000e+00,  -4.61725277e-01, 1.00000000e+00,  }, {-1.60770035e+00, 7.35750163e-01,  } },
+    { {1.00000000e+00,  -1.10609534e+00, 1.00000000e+00,  }, {-1.58473590e+00, 8.22190160e-01,  } },
+    { {1.00000000e+00,  -1.33578958e+00, 1.00000000e+00,  }, {-1.56784041e+00, 8.95978666e-01,  } },
+    { {1.00000000e+00,  -1.42778904e+00, 1.00000000e+00,  }, {-1.56181734e+00, 9.47917091e-01,  } },
+    { {1.00000000e+00,  -1.46186839e+00, 1.00000000e+00,  }, {-1.56895474e+00, 9.84315333e-01,  } },
+};
+
+static const SOSCoefficients kFilter88200x1[1] =
+{
+    { {4.47757672e-01,  8.95508014e-01,  4.47757672e-01,  }, {5.33257582e-01,  2.57765775e-01,  } },
+};
+
+static const SOSCoefficients kFilter88200x2[4] =
+{
+    { {2.14367169e-04,  3.44625587e-04,  2.14367169e-04,  }, {-1.51452964e+00, 5.91490852e-01,  } },
+    { {1.00000000e+00,  1.79356588e-01,  1.00000000e+00,  }, {-1.47183540e+00, 6.80572266e-01,  } },
+    { {1.00000000e+00,  -5.38726659e-01, 1.00000000e+00,  }, {-1.43146875e+00, 8.07690724e-01,  } },
+    { {1.00000000e+00,  -7.87020653e-01, 1.00000000e+00,  }, {-1.44140337e+00, 9.35690876e-01,  } },
+};
+
+static const SOSCoefficients kFilter96000x1[1] =
+{
+    { {4.08934230e-01,  8.17859979e-01,  4.08934230e-01,  }, {3.98721201e-01,  2.37007237e-01,  } },
+};
+
+static const SOSCoefficients kFilter96000x2[4] =
+{
+    { {1.61642425e-04,  2.48570126e-04,  1.61642425e-04,  }, {-1.55380069e+00, 6.19246726e-01,  } },
+    { {1.00000000e+00,  -3.58596848e-03, 1.00000000e+00,  }, {-1.52398387e+00, 7.01782723e-01,  } },
+    { {1.00000000e+00,  -7.04289597e-01, 1.00000000e+00,  }, {-1.49925872e+00, 8.20194069e-01,  } },
+    { {1.00000000e+00,  -9.36239381e-01, 1.00000000e+00,  }, {-1.51854777e+00, 9.39912815e-01,  } },
+};
+
+static const SOSCoefficients kFilter176400x1[1] =
+{
+    { {1.95935866e-01,  3.91854451e-01,  1.95935866e-01,  }, {-4.62324074e-01, 2.46050257e-01,  } },
+};
+
+static const SOSCoefficients kFilter192000x1[1] =
+{
+    { {1.74601581e-01,  3.49184661e-01,  1.74601581e-01,  }, {-5.65226924e-01, 2.63614746e-01,  } },
+};
+
+template <typename T>
+class AAFilter
+{
+public:
+    // Picks the cheapest filter that is correct for `sample_rate`.
+    void Init(float sample_rate)
+    {
+        InitFilter(sample_rate, 0);
+    }
+
+    // Same, but prefers `oversampling_factor` (1-4) if the rate has it.
+    void Init(float sample_rate, int oversampling_factor)
+    {
+        InitFilter(sample_rate, oversampling_factor);
+    }
+
+    T ProcessUp(T in)
+    {
+        return up_filter_.Process(in);
+    }
+
+    T ProcessDown(T in)
+    {
+        return down_filter_.Process(in);
+    }
+
+    int GetOversamplingFactor(void)
+    {
+        return oversampling_factor_;
+    }
+
+    template <typename F>
+    bool IsQuiet(F quiet) const
+    {
+        return up_filter_.IsQuiet(quiet) && down_filter_.IsQuiet(quiet);
+    }
+
+    // Take over the upsampling or downsampling state of `other`, initialised
+    // for the same rate and factor, through convert().
+    template <typename U, typename F>
+    void CopyUpState(const AAFilter<U>& other, F convert)
+    {
+        up_filter_.CopyState(other.up_filter_, convert);
+    }
+
+    template <typename U, typename F>
+    void CopyDownState(const AAFilter<U>& other, F convert)
+    {
+        down_filter_.CopyState(other.down_filter_, convert);
+    }
+
+protected:
+    template <typename> friend class AAFilter;
+    struct CascadedSOS
+    {
+        float sample_rate;
+        int oversampling_factor;
+        int num_sections;
+        const SOSCoefficients* coeffs;
+    };
+
+    static constexpr int kMaxNumSections = 7;
+    // The nonlinear cores need at least this much headroom above the audio band.
+    static constexpr float kMinOversampledRate = 132000.f;
+
+    SOSFilter<T, kMaxNumSections> up_filter_;
+    SOSFilter<T, kMaxNumSections> down_filter_;
+    int oversampling_factor_;
+
+    void InitFilter(float sample_rate, int requested_factor)
+    {
+        static const CascadedSOS kFilterBank[] =
+        {
+            { 44100.f, 2, 6, kFilter44100x2 },
+            { 44100.f, 3, 7, kFilter44100x3 },
+            { 44100.f, 4, 7, kFilter44100x4 },
+            { 48000.f, 2, 6, kFilter48000x2 },
+            { 48000.f, 3, 6, kFilter48000x3 },
+            { 48000.f, 4, 6, kFilter48000x4 },
+            { 88200.f, 1, 1, kFilter88200x1 },
+            { 88200.f, 2, 4, kFilter88200x2 },
+            { 96000.f, 1, 1, kFilter96000x1 },
+            { 96000.f, 2, 4, kFilter96000x2 },
+            { 176400.f, 1, 1, kFilter176400x1 },
+            { 192000.f, 1, 1, kFilter192000x1 },
+        };
+        const int kNumFilters = sizeof(kFilterBank) / sizeof(kFilterBank[0]);
+
+        // Rates without a table of their own use the nearest one, so the
+        // passband edge moves with the ratio between the two.
+        float rate = kFilterBank[0].sample_rate;
+        for (int i = 1; i < kNumFilters; i++)
+        {
+            float candidate = kFilterBank[i].sample_rate;
+            if (std::fabs(std::log(candidate / sample_rate)) < std::fabs(std::log(rate / sample_rate)))
+            {
+                rate = candidate;
+            }
+        }
+
+        const CascadedSOS* filter = nullptr;
+        for (int i = 0; i < kNumFilters; i++)
+        {
+            const CascadedSOS& candidate = kFilterBank[i];
+            if (candidate.sample_rate != rate)
+            {
+                continue;
+            }
+            if (candidate.oversampling_factor == requested_factor)
+            {
+                filter = &candidate;
+                break;
+            }
+            // Factors are listed in ascending order, keep the first that is enough.
+            if (!filter || filter->sample_rate * filter->oversampling_factor < kMinOversampledRate)
+            {
+                filter = &candidate;
+            }
+        }
+
+        up_filter_.Init(filter->num_sections, filter->coeffs);
+        down_filter_.Init(filter->num_sections, filter->coeffs);
+        oversampling_factor_ = filter->oversampling_factor;
+    }
+};
+
+}
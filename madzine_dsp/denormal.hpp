@@ -0,0 +1,47 @@
+#pragma once
+#include <rack.hpp>
+#include <cfloat>
+#include <cstdint>
+#include <cstring>
+
+// Flush-to-zero for the state of recursive filters and envelopes.
+//
+// Rack runs modules with FTZ/DAZ set, but a module can't count on that (other
+// hosts, offline renderers, the bench with --no-ftz), and a state that decays
+// into the denormal range after a hit makes every operation on it many times
+// slower on x86. Passing each stored state through flushDenormal() snaps such
+// values to exact zero, so an idle voice costs the same whatever MXCSR says.
+//
+// Built with -DMADZINE_DENORMAL_STATS, every flushed value is counted in
+// denormalFlushCount(), per thread; madzine-bench reports it per module.
+
+inline bool isDenormal(float x) {
+    uint32_t bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+    return (bits & 0x7f800000) == 0 && (bits & 0x007fffff) != 0;
+}
+
+#ifdef MADZINE_DENORMAL_STATS
+inline uint64_t& denormalFlushCount() {
+    static thread_local uint64_t count = 0;
+    return count;
+}
+#endif
+
+inline float flushDenormal(float x) {
+#ifdef MADZINE_DENORMAL_STATS
+    if (isDenormal(x))
+        denormalFlushCount()++;
+#endif
+    return std::fabs(x) < FLT_MIN ? 0.f : x;
+}
+
+inline rack::simd::float_4 flushDenormal(rack::simd::float_4 x) {
+#ifdef MADZINE_DENORMAL_STATS
+    for (int i = 0; i < 4; i++) {
+        if (isDenormal(x[i]))
+            denormalFlushCount()++;
+    }
+#endif
+    return x & (rack::simd::abs(x) >= FLT_MIN);
+}
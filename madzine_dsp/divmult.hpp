@@ -0,0 +1,85 @@
+#pragma once
+#include <cstdint>
+
+// Clock division/multiplication in whole samples.
+//
+// All timing is worked out when a clock edge arrives: a divided edge fixes
+// the sample index of every multiplied step up to the next divided edge, so
+// process() between edges is a compare and an increment. Nothing accumulates
+// in floating point, so step timing is sample-exact however long it runs.
+
+// Samples between incoming clock edges, clamped to 0.01-10 s. Until two edges
+// have been seen the period defaults to 0.5 s.
+struct ClockPeriod {
+    int64_t samplesSinceEdge = -1;
+    int64_t samples = 0;
+
+    void reset() {
+        samplesSinceEdge = -1;
+        samples = 0;
+    }
+
+    int64_t process(bool edge, float sampleRate) {
+        if (edge) {
+            if (samplesSinceEdge > 0) {
+                int64_t minSamples = (int64_t)(0.01f * sampleRate);
+                int64_t maxSamples = (int64_t)(10.0f * sampleRate);
+                samples = samplesSinceEdge < minSamples ? minSamples : (samplesSinceEdge > maxSamples ? maxSamples : samplesSinceEdge);
+            }
+            samplesSinceEdge = 0;
+        }
+        if (samplesSinceEdge >= 0) {
+            samplesSinceEdge++;
+        }
+        return samples > 0 ? samples : (int64_t)(0.5f * sampleRate);
+    }
+};
+
+struct ClockDivMult {
+    int dividerCount = 0;
+    int multiplication = 1;
+    int stepIndex = 0;
+    int64_t dividedSamples = 0;
+    int64_t elapsed = 0;
+    int64_t nextStep = 0;
+
+    // Steps once straight away, then waits for the next clock edge.
+    void reset() {
+        dividerCount = 0;
+        multiplication = 1;
+        stepIndex = 0;
+        dividedSamples = 0;
+        elapsed = 0;
+        nextStep = 0;
+    }
+
+    // Returns true on the sample a divided/multiplied step falls on. Every
+    // `division`-th edge starts a new divided period of `periodSamples *
+    // division` samples, split into `multiplication` steps; step k lands on
+    // the first sample at or after k / multiplication of the period.
+    bool process(bool clock, int64_t periodSamples, int division, int mult) {
+        if (clock) {
+            if (dividerCount == 0) {
+                multiplication = mult;
+                dividedSamples = periodSamples * division;
+                stepIndex = 0;
+                elapsed = 0;
+                nextStep = 0;
+            }
+            if (++dividerCount >= division) {
+                dividerCount = 0;
+            }
+        }
+
+        bool step = (elapsed == nextStep);
+        if (step) {
+            stepIndex++;
+            if (stepIndex < multiplication && dividedSamples > 0)
+                nextStep = (stepIndex * dividedSamples + multiplication - 1) / multiplication;
+            else
+                nextStep = -1;
+        }
+        elapsed++;
+        return step;
+    }
+};
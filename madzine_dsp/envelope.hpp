@@ -0,0 +1,100 @@
+#pragma once
+#include <rack.hpp>
+#include <cmath>
+
+// Envelope shapes shared by the envelope and drum modules.
+
+// Bends a 0-1 ramp. Curvature 0 leaves it linear, towards -1 it rises fast
+// and levels off, towards +1 it starts slow and rises late.
+inline float applyCurve(float x, float curvature) {
+    x = rack::math::clamp(x, 0.0f, 1.0f);
+
+    if (curvature == 0.0f) {
+        return x;
+    }
+
+    float k = curvature;
+    float abs_x = std::abs(x);
+    float denominator = k - 2.0f * k * abs_x + 1.0f;
+
+    if (std::abs(denominator) < 1e-6f) {
+        return x;
+    }
+
+    return (x - k * x) / denominator;
+}
+
+// Decay from 1 to 0 over `totalTime` whose curvature morphs along the way:
+// shapeParam 0 drops fast and tails off, 1 holds and then falls away.
+inline float smoothDecayEnvelope(float t, float totalTime, float shapeParam) {
+    if (t >= totalTime) return 0.f;
+
+    float normalizedT = t / totalTime;
+
+    float frontK = -0.9f + shapeParam * 0.5f;
+    float backK = -1.0f + 1.6f * std::pow(shapeParam, 0.3f);
+
+    float transition = normalizedT * normalizedT * (3.f - 2.f * normalizedT);
+    float k = frontK + (backK - frontK) * transition;
+
+    float absT = std::abs(normalizedT);
+    float denominator = k - 2.f * k * absT + 1.f;
+    if (std::abs(denominator) < 1e-10f) {
+        return 1.f - normalizedT;
+    }
+
+    float curveResult = (normalizedT - k * normalizedT) / denominator;
+    return 1.f - curveResult;
+}
+
+// Triggered 1 ms attack into a smoothDecayEnvelope() decay, 0 to 1, with a
+// 30 ms trigger pulse for lights and trigger outputs.
+struct UnifiedEnvelope {
+    rack::dsp::SchmittTrigger trigTrigger;
+    rack::dsp::PulseGenerator trigPulse;
+    float phase = 0.f;
+    bool gateState = false;
+    static constexpr float ATTACK_TIME = 0.001f;
+
+    void reset() {
+        trigTrigger.reset();
+        trigPulse.reset();
+        phase = 0.f;
+        gateState = false;
+    }
+
+    float process(float sampleTime, float triggerVoltage, float decayTime, float shapeParam) {
+        bool triggered = trigTrigger.process(triggerVoltage, 0.1f, 2.f);
+
+        if (triggered) {
+            phase = 0.f;
+            gateState = true;
+            trigPulse.trigger(0.03f);
+        }
+
+        float envOutput = 0.f;
+
+        if (gateState) {
+            if (phase < ATTACK_TIME) {
+                envOutput = phase / ATTACK_TIME;
+            } else {
+                float decayPhase = phase - ATTACK_TIME;
+
+                if (decayPhase >= decayTime) {
+                    gateState = false;
+                    envOutput = 0.f;
+                } else {
+                    envOutput = smoothDecayEnvelope(decayPhase, decayTime, shapeParam);
+                }
+            }
+
+            phase += sampleTime;
+        }
+
+        return rack::math::clamp(envOutput, 0.f, 1.f);
+    }
+
+    float getTrigger(float sampleTime) {
+        return trigPulse.process(sampleTime) ? 10.0f : 0.0f;
+    }
+};
@@ -0,0 +1,76 @@
+#pragma once
+#include <cstdint>
+
+// Delay line for stepped signals such as sequencer CVs.
+//
+// Instead of every sample it stores only the changes, as (sample, value)
+// events in a ring of CAPACITY, and plays them back at their time plus the
+// delay. The delay is in samples and may be fractional or modulated: an event
+// at sample t shows up at the first sample at or after t + delay. A cursor
+// follows the read point, so a sample costs O(1) however long the delay is,
+// and reset() is O(1) too.
+//
+// If the input changes more than CAPACITY times within one delay time, the
+// oldest events are dropped and the output skips ahead to the oldest kept
+// one.
+
+template <int CAPACITY = 128>
+struct EventDelay {
+    static_assert((CAPACITY & (CAPACITY - 1)) == 0, "CAPACITY must be a power of two");
+
+    void reset(float value = 0.f) {
+        initial = value;
+        first = end = read = 0;
+    }
+
+    float process(float in, float delay) {
+        now++;
+        if (first != end && now - events[(end - 1) & MASK].time >= STALE_AGE) {
+            // Nothing has changed for longer than any delay: forget the
+            // history before the ages can wrap around.
+            initial = events[(end - 1) & MASK].value;
+            first = read = end;
+        }
+
+        float newest = (first != end) ? events[(end - 1) & MASK].value : initial;
+        if (in != newest) {
+            if (end - first == CAPACITY) {
+                if (read == first)
+                    read++;
+                initial = events[first & MASK].value;
+                first++;
+            }
+            events[end & MASK].time = now;
+            events[end & MASK].value = in;
+            end++;
+        }
+
+        while (read != end && age(read) >= delay)
+            read++;
+        while (read != first && age(read - 1) < delay)
+            read--;
+        return (read != first) ? events[(read - 1) & MASK].value : initial;
+    }
+
+private:
+    static const uint32_t MASK = CAPACITY - 1;
+    static const uint32_t STALE_AGE = uint32_t(1) << 30;
+
+    struct Event {
+        uint32_t time;
+        float value;
+    };
+
+    Event events[CAPACITY];
+    // Signal before the oldest kept event.
+    float initial = 0.f;
+    uint32_t now = 0;
+    // Kept events are [first, end); the output is the one before `read`.
+    uint32_t first = 0;
+    uint32_t end = 0;
+    uint32_t read = 0;
+
+    float age(uint32_t index) const {
+        return (float) (now - events[index & MASK].time);
+    }
+};
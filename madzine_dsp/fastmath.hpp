@@ -0,0 +1,139 @@
+#pragma once
+#include <rack.hpp>
+#include <cstdint>
+#include <cstring>
+
+// Polynomial stand-ins for the libm calls on per-sample paths. Each one has
+// a float version and a rack::simd::float_4 version that do the same
+// arithmetic.
+//
+// Error bounds, checked by bench/madzine-fastmath:
+//
+//   fastExp2(x)       relative 3e-7                   x in [-126, 126], clamped outside
+//   fastExp(x)        relative 3e-7 + 8e-8 |x|        x in [-87, 87]
+//   fastPow10(x)      relative 3e-7 + 2e-7 |x|        x in [-37, 37]
+//   fastLog2(x)       absolute 3e-7 + 6e-8 |log2 x|   x positive and normal
+//   fastPow(x, y)     relative 3e-7 (1 + |y log2 x|)  0 for x <= 0
+//   fastSin2pi(x)     absolute 5e-6 + 4e-7 |x|        sin(2 pi x)
+//   fastCos2pi(x)     absolute 5e-6 + 4e-7 |x|        cos(2 pi x)
+//
+// The terms in |x| are the rounding of x itself, or of x times a constant,
+// which no approximation can undo. Sine and cosine take the phase in
+// cycles, as oscillators keep it, so range reduction is one floor().
+
+namespace fastmath_detail {
+
+// 2^f for f in [-0.5, 0.5], minimax for relative error (7.5e-8).
+template <typename T>
+inline T exp2Poly(T f) {
+    return 1.00000007f + f * (0.693146967f + f * (0.240221197f + f * (0.0555071327f + f * (0.00967554133f + f * 0.00132764720f))));
+}
+
+// log2(m) for m in [sqrt(1/2), sqrt(2)): the atanh series in
+// s = (m - 1) / (m + 1), |s| <= 0.172, to s^7 (4e-8).
+template <typename T>
+inline T log2Poly(T m) {
+    T s = (m - 1.f) / (m + 1.f);
+    T s2 = s * s;
+    return s * (2.88539008f + s2 * (0.961796694f + s2 * (0.577078016f + s2 * 0.412198583f)));
+}
+
+// sin(2 pi t) for t in [-0.25, 0.25].
+template <typename T>
+inline T sin2piPoly(T t) {
+    T t2 = t * t;
+    return t * (6.28318531f + t2 * (-41.3417022f + t2 * (81.6052493f + t2 * (-76.7058597f + t2 * 42.0586939f))));
+}
+
+// Bits of sqrt(1/2): log2 splits the mantissa around it.
+static const int32_t SQRT_HALF_BITS = 0x3f3504f3;
+
+} // namespace fastmath_detail
+
+inline float fastExp2(float x) {
+    // std::min/max rather than math::clamp(), whose std::fmin/fmax are libm
+    // calls.
+    x = std::max(-126.f, std::min(x, 126.f));
+    float xi = std::floor(x + 0.5f);
+    int32_t bits = ((int32_t) xi + 127) << 23;
+    float scale;
+    std::memcpy(&scale, &bits, sizeof(scale));
+    return fastmath_detail::exp2Poly(x - xi) * scale;
+}
+
+inline rack::simd::float_4 fastExp2(rack::simd::float_4 x) {
+    x = rack::simd::clamp(x, -126.f, 126.f);
+    rack::simd::float_4 xi = rack::simd::floor(x + 0.5f);
+    // xi is a whole number, so the truncating conversion is exact.
+    rack::simd::int32_4 bits = (rack::simd::int32_4(xi) + rack::simd::int32_4(127)) << 23;
+    return fastmath_detail::exp2Poly(x - xi) * rack::simd::float_4::cast(bits);
+}
+
+inline float fastExp(float x) {
+    return fastExp2(x * 1.44269504f);
+}
+
+inline rack::simd::float_4 fastExp(rack::simd::float_4 x) {
+    return fastExp2(x * 1.44269504f);
+}
+
+inline float fastPow10(float x) {
+    return fastExp2(x * 3.32192809f);
+}
+
+inline rack::simd::float_4 fastPow10(rack::simd::float_4 x) {
+    return fastExp2(x * 3.32192809f);
+}
+
+inline float fastLog2(float x) {
+    int32_t bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+    int32_t e = (bits - fastmath_detail::SQRT_HALF_BITS) >> 23;
+    bits -= e << 23;
+    float m;
+    std::memcpy(&m, &bits, sizeof(m));
+    return (float) e + fastmath_detail::log2Poly(m);
+}
+
+inline rack::simd::float_4 fastLog2(rack::simd::float_4 x) {
+    rack::simd::int32_4 bits = rack::simd::int32_4::cast(x);
+    // Rack's >> is a logical shift, so shift the biased exponent, which is
+    // positive for every positive normal x, and take the bias off after.
+    rack::simd::int32_4 e = ((bits - rack::simd::int32_4(fastmath_detail::SQRT_HALF_BITS - (127 << 23))) >> 23) - rack::simd::int32_4(127);
+    rack::simd::float_4 m = rack::simd::float_4::cast(bits - (e << 23));
+    return rack::simd::float_4(e) + fastmath_detail::log2Poly(m);
+}
+
+inline float fastPow(float x, float y) {
+    if (x <= 0.f)
+        return 0.f;
+    return fastExp2(y * fastLog2(x));
+}
+
+inline rack::simd::float_4 fastPow(rack::simd::float_4 x, rack::simd::float_4 y) {
+    return rack::simd::ifelse(x > 0.f, fastExp2(y * fastLog2(x)), 0.f);
+}
+
+inline float fastSin2pi(float x) {
+    float t = x - std::floor(x + 0.5f);
+    if (t > 0.25f)
+        t = 0.5f - t;
+    else if (t < -0.25f)
+        t = -0.5f - t;
+    return fastmath_detail::sin2piPoly(t);
+}
+
+inline rack::simd::float_4 fastSin2pi(rack::simd::float_4 x) {
+    rack::simd::float_4 t = x - rack::simd::floor(x + 0.5f);
+    t = rack::simd::ifelse(t > 0.25f, 0.5f - t, t);
+    t = rack::simd::ifelse(t < -0.25f, -0.5f - t, t);
+    return fastmath_detail::sin2piPoly(t);
+}
+
+inline float fastCos2pi(float x) {
+    return fastSin2pi(x + 0.25f);
+}
+
+inline rack::simd::float_4 fastCos2pi(rack::simd::float_4 x) {
+    return fastSin2pi(x + 0.25f);
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <rack.hpp>
+
+// Voss-McCartney pink noise: QUALITY white sources, source i redrawn every
+// 2^i samples, summed. Roughly -3 dB/octave over QUALITY octaves below
+// Nyquist; every sample lies within +-QUALITY / 2.
+
+template <int QUALITY = 8>
+struct PinkNoiseGenerator {
+    int frame = -1;
+    float values[QUALITY] = {};
+
+    float process() {
+        int lastFrame = frame;
+        frame++;
+        if (frame >= (1 << QUALITY))
+            frame = 0;
+        int diff = lastFrame ^ frame;
+
+        float sum = 0.f;
+        for (int i = 0; i < QUALITY; i++) {
+            if (diff & (1 << i)) {
+                values[i] = rack::random::uniform() - 0.5f;
+            }
+            sum += values[i];
+        }
+        return sum;
+    }
+};
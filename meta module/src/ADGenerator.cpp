@@ -1,4 +1,6 @@
 #include "plugin.hpp"
+#include "envelope.hpp"
+#include "fastmath.hpp"
 
 struct ADGenerator : Module {
     enum ParamId {
@@ -63,7 +65,7 @@ struct ADGenerator : Module {
         }
         
         float process(float input, float cutoff, float sampleRate) {
-            float f = 2.0f * std::sin(M_PI * cutoff / sampleRate);
+            float f = 2.0f * fastSin2pi(0.5f * cutoff / sampleRate);
             f = clamp(f, 0.0f, 1.0f);
             
             lowpass += f * (input - lowpass);
@@ -115,27 +117,9 @@ struct ADGenerator : Module {
             oldPhaseTime = 0.0f;
         }
         
-        float applyCurve(float x, float curvature) {
-            x = clamp(x, 0.0f, 1.0f);
-            
-            if (curvature == 0.0f) {
-                return x;
-            }
-            
-            float k = curvature;
-            float abs_x = std::abs(x);
-            float denominator = k - 2.0f * k * abs_x + 1.0f;
-            
-            if (std::abs(denominator) < 1e-6f) {
-                return x;
-            }
-            
-            return (x - k * x) / denominator;
-        }
-        
         float processEnvelopeFollower(float triggerVoltage, float sampleTime, float attackTime, float releaseTime, float curve) {
-            attackCoeff = 1.0f - std::exp(-sampleTime / std::max(0.0005f, attackTime * 0.1f));
-            releaseCoeff = 1.0f - std::exp(-sampleTime / std::max(0.001f, releaseTime * 0.5f));
+            attackCoeff = 1.0f - fastExp(-sampleTime / std::max(0.0005f, attackTime * 0.1f));
+            releaseCoeff = 1.0f - fastExp(-sampleTime / std::max(0.001f, releaseTime * 0.5f));
             
             attackCoeff = clamp(attackCoeff, 0.0f, 1.0f);
             releaseCoeff = clamp(releaseCoeff, 0.0f, 1.0f);
@@ -205,8 +189,8 @@ struct ADGenerator : Module {
             float atkOffset = atkAll * 0.5f;
             float decOffset = decAll * 0.5f;
             
-            oldAttackTime = std::pow(10.0f, (attack - 0.5f) * 6.0f) + atkOffset;
-            oldDecayTime = std::pow(10.0f, (decay - 0.5f) * 6.0f) + decOffset;
+            oldAttackTime = fastPow10((attack - 0.5f) * 6.0f) + atkOffset;
+            oldDecayTime = fastPow10((decay - 0.5f) * 6.0f) + decOffset;
             
             oldAttackTime = std::max(0.001f, oldAttackTime);
             oldDecayTime = std::max(0.001f, oldDecayTime);
@@ -259,8 +243,8 @@ struct ADGenerator : Module {
                 float atkOffset = atkAll * 0.5f;
                 float decOffset = decAll * 0.5f;
                 
-                attackTime = std::pow(10.0f, (attack - 0.5f) * 6.0f) + atkOffset;
-                decayTime = std::pow(10.0f, (decay - 0.5f) * 6.0f) + decOffset;
+                attackTime = fastPow10((attack - 0.5f) * 6.0f) + atkOffset;
+                decayTime = fastPow10((decay - 0.5f) * 6.0f) + decOffset;
                 
                 attackTime = std::max(0.001f, attackTime);
                 decayTime = std::max(0.001f, decayTime);
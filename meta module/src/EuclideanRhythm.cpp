@@ -1,4 +1,5 @@
 #include "plugin.hpp"
+#include "divmult.hpp"
 
 struct DivMultParamQuantity : ParamQuantity {
     std::string getDisplayValueString() override {
@@ -111,8 +112,7 @@ struct EuclideanRhythm : Module {
     dsp::SchmittTrigger resetTrigger;
     dsp::SchmittTrigger manualResetTrigger;
     
-    float globalClockSeconds = 0.5f;
-    float secondsSinceLastClock = -1.0f;
+    ClockPeriod clockPeriod;
     
     dsp::PulseGenerator orRedPulse;
     dsp::PulseGenerator orGreenPulse;
@@ -122,13 +122,7 @@ struct EuclideanRhythm : Module {
         int divMultValue = 0;
         int division = 1;
         int multiplication = 1;
-        float dividedClockSeconds = 0.5f;
-        float multipliedClockSeconds = 0.5f;
-        float dividedProgressSeconds = 0.0f;
-        float gateSeconds = 0.0f;
-        int dividerCount = 0;
-        bool shouldStep = false;
-        bool prevMultipliedGate = false;
+        ClockDivMult clock;
         
         int currentStep = 0;
         int length = 16;
@@ -140,10 +134,7 @@ struct EuclideanRhythm : Module {
         dsp::PulseGenerator trigPulse;
 
         void reset() {
-            dividedProgressSeconds = 0.0f;
-            dividerCount = 0;
-            shouldStep = false;
-            prevMultipliedGate = false;
+            clock.reset();
             currentStep = 0;
             for (int i = 0; i < 32; ++i) {
                 pattern[i] = false;
@@ -166,42 +157,6 @@ struct EuclideanRhythm : Module {
             }
         }
         
-        bool processClockDivMult(bool globalClock, float globalClockSeconds, float sampleTime) {
-            dividedClockSeconds = globalClockSeconds * (float)division;
-            multipliedClockSeconds = dividedClockSeconds / (float)multiplication;
-            gateSeconds = std::max(0.001f, multipliedClockSeconds * 0.5f);
-            
-            if (globalClock) {
-                if (dividerCount < 1) {
-                    dividedProgressSeconds = 0.0f;
-                } else {
-                    dividedProgressSeconds += sampleTime;
-                }
-                ++dividerCount;
-                if (dividerCount >= division) {
-                    dividerCount = 0;
-                }
-            } else {
-                dividedProgressSeconds += sampleTime;
-            }
-            
-            shouldStep = false;
-            if (dividedProgressSeconds < dividedClockSeconds) {
-                float multipliedProgressSeconds = dividedProgressSeconds / multipliedClockSeconds;
-                multipliedProgressSeconds -= (float)(int)multipliedProgressSeconds;
-                multipliedProgressSeconds *= multipliedClockSeconds;
-                
-                bool currentMultipliedGate = multipliedProgressSeconds <= gateSeconds;
-                
-                if (currentMultipliedGate && !prevMultipliedGate) {
-                    shouldStep = true;
-                }
-                prevMultipliedGate = currentMultipliedGate;
-            }
-            
-            return shouldStep;
-        }
-        
         void stepTrack() {
             cycleCompleted = false;
             currentStep = (currentStep + 1) % length;
@@ -341,8 +296,7 @@ struct EuclideanRhythm : Module {
     }
 
     void onReset() override {
-        secondsSinceLastClock = -1.0f;
-        globalClockSeconds = 0.5f;
+        clockPeriod.reset();
         for (int i = 0; i < 3; ++i) {
             tracks[i].reset();
         }
@@ -373,17 +327,7 @@ struct EuclideanRhythm : Module {
             return;
         }
         
-        if (globalClockTriggered) {
-            if (secondsSinceLastClock > 0.0f) {
-                globalClockSeconds = secondsSinceLastClock;
-                globalClockSeconds = clamp(globalClockSeconds, 0.01f, 10.0f);
-            }
-            secondsSinceLastClock = 0.0f;
-        }
-        
-        if (secondsSinceLastClock >= 0.0f) {
-            secondsSinceLastClock += args.sampleTime;
-        }
+        int64_t clockPeriodSamples = clockPeriod.process(globalClockTriggered, args.sampleRate);
 
         for (int i = 0; i < 3; ++i) {
             TrackState& track = tracks[i];
@@ -418,7 +362,7 @@ struct EuclideanRhythm : Module {
 
             generateEuclideanRhythm(track.pattern, track.length, track.fill, track.shift);
 
-            bool trackClockTrigger = track.processClockDivMult(globalClockTriggered, globalClockSeconds, args.sampleTime);
+            bool trackClockTrigger = track.clock.process(globalClockTriggered, clockPeriodSamples, track.division, track.multiplication);
 
             if (trackClockTrigger && globalClockActive) {
                 track.stepTrack();
@@ -1,4 +1,7 @@
 #include "plugin.hpp"
+#include "divmult.hpp"
+#include "envelope.hpp"
+#include "fastmath.hpp"
 
 struct DensityParamQuantity : ParamQuantity {
     std::string getDisplayValueString() override {
@@ -116,13 +119,7 @@ struct MADDY : Module {
         int divMultValue = 0;
         int division = 1;
         int multiplication = 1;
-        float dividedClockSeconds = 0.5f;
-        float multipliedClockSeconds = 0.5f;
-        float dividedProgressSeconds = 0.0f;
-        float gateSeconds = 0.0f;
-        int dividerCount = 0;
-        bool shouldStep = false;
-        bool prevMultipliedGate = false;
+        ClockDivMult clock;
         
         int currentStep = 0;
         int length = 16;
@@ -151,10 +148,7 @@ struct MADDY : Module {
         bool justTriggered = false;
 
         void reset() {
-            dividedProgressSeconds = 0.0f;
-            dividerCount = 0;
-            shouldStep = false;
-            prevMultipliedGate = false;
+            clock.reset();
             currentStep = 0;
             shift = 0;
             for (int i = 0; i < 32; ++i) {
@@ -170,24 +164,6 @@ struct MADDY : Module {
             justTriggered = false;
         }
         
-        float applyCurve(float x, float curvature) {
-            x = clamp(x, 0.0f, 1.0f);
-            
-            if (curvature == 0.0f) {
-                return x;
-            }
-            
-            float k = curvature;
-            float abs_x = std::abs(x);
-            float denominator = k - 2.0f * k * abs_x + 1.0f;
-            
-            if (std::abs(denominator) < 1e-6f) {
-                return x;
-            }
-            
-            return (x - k * x) / denominator;
-        }
-        
         void updateDivMult(int divMultParam) {
             divMultValue = divMultParam;
             if (divMultValue > 0) {
@@ -202,42 +178,6 @@ struct MADDY : Module {
             }
         }
         
-        bool processClockDivMult(bool globalClock, float globalClockSeconds, float sampleTime) {
-            dividedClockSeconds = globalClockSeconds * (float)division;
-            multipliedClockSeconds = dividedClockSeconds / (float)multiplication;
-            gateSeconds = std::max(0.001f, multipliedClockSeconds * 0.5f);
-            
-            if (globalClock) {
-                if (dividerCount < 1) {
-                    dividedProgressSeconds = 0.0f;
-                } else {
-                    dividedProgressSeconds += sampleTime;
-                }
-                ++dividerCount;
-                if (dividerCount >= division) {
-                    dividerCount = 0;
-                }
-            } else {
-                dividedProgressSeconds += sampleTime;
-            }
-            
-            shouldStep = false;
-            if (dividedProgressSeconds < dividedClockSeconds) {
-                float multipliedProgressSeconds = dividedProgressSeconds / multipliedClockSeconds;
-                multipliedProgressSeconds -= (float)(int)multipliedProgressSeconds;
-                multipliedProgressSeconds *= multipliedClockSeconds;
-                
-                bool currentMultipliedGate = multipliedProgressSeconds <= gateSeconds;
-                
-                if (currentMultipliedGate && !prevMultipliedGate) {
-                    shouldStep = true;
-                }
-                prevMultipliedGate = currentMultipliedGate;
-            }
-            
-            return shouldStep;
-        }
-        
         void stepTrack() {
                currentStep = (currentStep + 1) % length;
                gateState = pattern[currentStep];
@@ -373,7 +313,7 @@ struct MADDY : Module {
     };
     ChainedSequence chain12, chain23, chain123;
 
-    float globalClockSeconds = 0.5f;
+    int64_t clockPeriodSamples = 0;
     bool internalClockTriggered = false;
     bool patternClockTriggered = false;
     
@@ -382,6 +322,13 @@ struct MADDY : Module {
     dsp::PulseGenerator gateOutPulse;
     
     int currentStep = 0, sequenceLength = 16, stepToKnobMapping[64];
+    // Chaos draws from its own generator. The seed is saved with the patch
+    // and restored on reset, so the same variations play back.
+    random::Xoroshiro128Plus mappingRng;
+    uint64_t mappingSeed = 0;
+    // What the current table was built from.
+    float mappingDensity = -1.0f, mappingChaos = -1.0f;
+    int mappingStyle = -1;
     float previousVoltage = -999.0f;
     int modeValue = 1;
     int clockSourceValue = 0;
@@ -454,12 +401,38 @@ struct MADDY : Module {
         int chain123_indices[] = {0, 1, 0, 2};
         chain123.setTrackIndices(chain123_indices, 4);
         
+        mappingSeed = random::u64();
+        seedMapping();
         generateMapping();
     }
 
+    void seedMapping() {
+        mappingRng.seed(mappingSeed, 0x9e3779b97f4a7c15ull);
+    }
+
+    float chaosUniform() {
+        return (mappingRng() >> 40) / 16777216.f;
+    }
+
+    uint32_t chaosU32() {
+        return (uint32_t) (mappingRng() >> 32);
+    }
+
+    // Clock edges only rebuild the table if density, chaos or style moved
+    // since it was built, or chaos is up and re-rolls it every step.
+    void updateMapping() {
+        float density = params[DENSITY_PARAM].getValue();
+        float chaos = params[CHAOS_PARAM].getValue();
+        if (chaos > 0.0f || density != mappingDensity || chaos != mappingChaos || modeValue != mappingStyle)
+            generateMapping();
+    }
+
     void generateMapping() {
         float density = params[DENSITY_PARAM].getValue();
         float chaos = params[CHAOS_PARAM].getValue();
+        mappingDensity = density;
+        mappingChaos = chaos;
+        mappingStyle = modeValue;
         
         if (density < 0.2f) {
             sequenceLength = 8 + (int)(density * 20);
@@ -474,7 +447,7 @@ struct MADDY : Module {
         
         if (chaos > 0.0f) {
             float chaosRange = chaos * sequenceLength * 0.5f;
-            float randomOffset = (random::uniform() - 0.5f) * 2.0f * chaosRange;
+            float randomOffset = (chaosUniform() - 0.5f) * 2.0f * chaosRange;
             sequenceLength += (int)randomOffset;
             sequenceLength = clamp(sequenceLength, 4, 64);
         }
@@ -508,8 +481,8 @@ struct MADDY : Module {
         if (chaos > 0.3f) {
             int chaosSteps = (int)(chaos * sequenceLength * 0.3f);
             for (int i = 0; i < chaosSteps; i++) {
-                int randomStep = random::u32() % sequenceLength;
-                stepToKnobMapping[randomStep] = random::u32() % 5;
+                int randomStep = chaosU32() % sequenceLength;
+                stepToKnobMapping[randomStep] = chaosU32() % 5;
             }
         }
     }
@@ -518,7 +491,7 @@ struct MADDY : Module {
         phase = 0.0f;
         swingPhase = 0.0f;
         isSwingBeat = false;
-        globalClockSeconds = 0.5f;
+        clockPeriodSamples = 0;
         for (int i = 0; i < 3; ++i) {
             tracks[i].reset();
         }
@@ -527,12 +500,14 @@ struct MADDY : Module {
         chain123.reset();
         
         currentStep = 0;
+        seedMapping();
         generateMapping();
         previousVoltage = -999.0f;
     }
 
     json_t* dataToJson() override {
         json_t* rootJ = json_object();
+        json_object_set_new(rootJ, "mappingSeed", json_integer((long long) mappingSeed));
         json_object_set_new(rootJ, "modeValue", json_integer(modeValue));
         json_object_set_new(rootJ, "clockSourceValue", json_integer(clockSourceValue));
         
@@ -552,6 +527,12 @@ struct MADDY : Module {
     }
 
     void dataFromJson(json_t* rootJ) override {
+        json_t* seedJ = json_object_get(rootJ, "mappingSeed");
+        if (seedJ) {
+            mappingSeed = (uint64_t) json_integer_value(seedJ);
+            seedMapping();
+        }
+        
         json_t* modeJ = json_object_get(rootJ, "modeValue");
         if (modeJ) {
             modeValue = json_integer_value(modeJ);
@@ -585,7 +566,7 @@ struct MADDY : Module {
 
     void process(const ProcessArgs& args) override {
         float freqParam = params[FREQ_PARAM].getValue();
-        float freq = std::pow(2.0f, freqParam) * 1.0f;
+        float freq = fastExp2(freqParam) * 1.0f;
         
         float swingParam = params[SWING_PARAM].getValue();
         float swing = clamp(swingParam, 0.0f, 1.0f);
@@ -610,7 +591,7 @@ struct MADDY : Module {
             phase -= phaseThreshold;
             clockPulse.trigger(0.001f);
             internalClockTriggered = true;
-            globalClockSeconds = phaseThreshold / freq;
+            clockPeriodSamples = (int64_t)std::round(phaseThreshold / freq * args.sampleRate);
             isSwingBeat = !isSwingBeat;
         }
         
@@ -636,7 +617,7 @@ struct MADDY : Module {
 
             generateMADDYEuclideanRhythm(track.pattern, track.length, track.fill, track.shift);
 
-            bool trackClockTrigger = track.processClockDivMult(internalClockTriggered, globalClockSeconds, args.sampleTime);
+            bool trackClockTrigger = track.clock.process(internalClockTriggered, clockPeriodSamples, track.division, track.multiplication);
 
             if (trackClockTrigger) {
                 track.stepTrack();
@@ -732,7 +713,7 @@ struct MADDY : Module {
         
         if (patternClockTriggered) {
             currentStep = (currentStep + 1) % sequenceLength;
-            generateMapping();
+            updateMapping();
             
             int newActiveKnob = stepToKnobMapping[currentStep];
             float newVoltage = params[K1_PARAM + newActiveKnob].getValue();
@@ -1,4 +1,5 @@
 #include "plugin.hpp"
+#include "eventdelay.hpp"
 
 struct DensityParamQuantity : ParamQuantity {
     std::string getDisplayValueString() override {
@@ -52,6 +53,13 @@ struct PPaTTTerning : Module {
     dsp::PulseGenerator gateOutPulse, gate2OutPulse;
     
     int currentStep = 0, sequenceLength = 16, stepToKnobMapping[64];
+    // Chaos draws from its own generator. The seed is saved with the patch
+    // and restored on reset, so the same variations play back.
+    random::Xoroshiro128Plus mappingRng;
+    uint64_t mappingSeed = 0;
+    // What the current table was built from.
+    float mappingDensity = -1.0f, mappingChaos = -1.0f;
+    int mappingStyle = -1;
     float previousVoltage = -999.0f;
     int styleMode = 1;
     
@@ -59,9 +67,7 @@ struct PPaTTTerning : Module {
     float cvHistory[MAX_DELAY];
     int historyIndex = 0, track2Delay = 1;
     
-    static const int CVD_BUFFER_SIZE = 192000;
-    float cvdBuffer[CVD_BUFFER_SIZE];
-    int cvdWriteIndex = 0;
+    EventDelay<> cvdDelay;
     float sampleRate = 44100.0f;
     
     PPaTTTerning() {
@@ -95,7 +101,8 @@ struct PPaTTTerning : Module {
         configLight(DELAY_LIGHT_BLUE, "Delay Blue");
         
         for (int i = 0; i < MAX_DELAY; i++) cvHistory[i] = 0.0f;
-        for (int i = 0; i < CVD_BUFFER_SIZE; i++) cvdBuffer[i] = 0.0f;
+        mappingSeed = random::u64();
+        seedMapping();
         generateMapping();
     }
     
@@ -105,12 +112,19 @@ struct PPaTTTerning : Module {
 
     json_t* dataToJson() override {
         json_t* rootJ = json_object();
+        json_object_set_new(rootJ, "mappingSeed", json_integer((long long) mappingSeed));
         json_object_set_new(rootJ, "track2Delay", json_integer(track2Delay));
         json_object_set_new(rootJ, "styleMode", json_integer(styleMode));
         return rootJ;
     }
 
     void dataFromJson(json_t* rootJ) override {
+        json_t* seedJ = json_object_get(rootJ, "mappingSeed");
+        if (seedJ) {
+            mappingSeed = (uint64_t) json_integer_value(seedJ);
+            seedMapping();
+        }
+        
         json_t* t2 = json_object_get(rootJ, "track2Delay");
         if (t2) {
             track2Delay = clamp((int)json_integer_value(t2), 0, 5);
@@ -122,10 +136,34 @@ struct PPaTTTerning : Module {
         }
     }
 
+    void seedMapping() {
+        mappingRng.seed(mappingSeed, 0x9e3779b97f4a7c15ull);
+    }
+    
+    float chaosUniform() {
+        return (mappingRng() >> 40) / 16777216.f;
+    }
+    
+    uint32_t chaosU32() {
+        return (uint32_t) (mappingRng() >> 32);
+    }
+    
+    // Clock edges only rebuild the table if density, chaos or style moved
+    // since it was built, or chaos is up and re-rolls it every step.
+    void updateMapping() {
+        float density = params[DENSITY_PARAM].getValue();
+        float chaos = params[CHAOS_PARAM].getValue();
+        if (chaos > 0.0f || density != mappingDensity || chaos != mappingChaos || styleMode != mappingStyle)
+            generateMapping();
+    }
+    
     void generateMapping() {
         int style = styleMode;
         float density = params[DENSITY_PARAM].getValue();
         float chaos = params[CHAOS_PARAM].getValue();
+        mappingDensity = density;
+        mappingChaos = chaos;
+        mappingStyle = styleMode;
         
         if (density < 0.2f) {
             sequenceLength = 8 + (int)(density * 20);
@@ -140,7 +178,7 @@ struct PPaTTTerning : Module {
         
         if (chaos > 0.0f) {
             float chaosRange = chaos * sequenceLength * 0.5f;
-            float randomOffset = (random::uniform() - 0.5f) * 2.0f * chaosRange;
+            float randomOffset = (chaosUniform() - 0.5f) * 2.0f * chaosRange;
             sequenceLength += (int)randomOffset;
             sequenceLength = clamp(sequenceLength, 4, 64);
         }
@@ -189,8 +227,8 @@ struct PPaTTTerning : Module {
         if (chaos > 0.3f) {
             int chaosSteps = (int)(chaos * sequenceLength * 0.3f);
             for (int i = 0; i < chaosSteps; i++) {
-                int randomStep = random::u32() % sequenceLength;
-                stepToKnobMapping[randomStep] = random::u32() % 5;
+                int randomStep = chaosU32() % sequenceLength;
+                stepToKnobMapping[randomStep] = chaosU32() % 5;
             }
         }
     }
@@ -198,12 +236,12 @@ struct PPaTTTerning : Module {
     void process(const ProcessArgs& args) override {
         if (resetTrigger.process(inputs[RESET_INPUT].getVoltage())) {
             currentStep = 0;
+            seedMapping();
             generateMapping();
             previousVoltage = -999.0f;
             for (int i = 0; i < MAX_DELAY; i++) cvHistory[i] = 0.0f;
-            for (int i = 0; i < CVD_BUFFER_SIZE; i++) cvdBuffer[i] = 0.0f;
+            cvdDelay.reset();
             historyIndex = 0;
-            cvdWriteIndex = 0;
         }
         
         if (styleTrigger.process(params[STYLE_PARAM].getValue())) {
@@ -231,7 +269,7 @@ struct PPaTTTerning : Module {
             cvHistory[historyIndex] = voltage;
             
             currentStep = (currentStep + 1) % sequenceLength;
-            generateMapping();
+            updateMapping();
             
             int newActiveKnob = stepToKnobMapping[currentStep];
             float newVoltage = params[K1_PARAM + newActiveKnob].getValue();
@@ -263,20 +301,9 @@ struct PPaTTTerning : Module {
             delayTimeMs = (cvdCV / 10.0f) * knobValue * 1000.0f;
         }
         
-        if (delayTimeMs <= 0.001f) {
-            outputs[CV2_OUTPUT].setVoltage(shiftRegisterCV);
-        } else {
-            cvdBuffer[cvdWriteIndex] = shiftRegisterCV;
-            cvdWriteIndex = (cvdWriteIndex + 1) % CVD_BUFFER_SIZE;
-            
-            int delaySamples = (int)(delayTimeMs * sampleRate / 1000.0f);
-            delaySamples = clamp(delaySamples, 0, CVD_BUFFER_SIZE - 1);
-            
-            int readIndex = (cvdWriteIndex - delaySamples + CVD_BUFFER_SIZE) % CVD_BUFFER_SIZE;
-            float delayedCV = cvdBuffer[readIndex];
-            
-            outputs[CV2_OUTPUT].setVoltage(delayedCV);
-        }
+        // Recorded even while bypassed, so turning CVD up plays back real history.
+        float delayedCV = cvdDelay.process(shiftRegisterCV, delayTimeMs * sampleRate / 1000.0f);
+        outputs[CV2_OUTPUT].setVoltage(delayTimeMs <= 0.001f ? shiftRegisterCV : delayedCV);
         
         outputs[TRIG2_OUTPUT].setVoltage(gate2OutPulse.process(args.sampleTime) ? 10.0f : 0.0f);
     }
@@ -1,4 +1,5 @@
 #include "plugin.hpp"
+#include "envelope.hpp"
 
 struct QQ : Module {
     enum ParamIds {
@@ -91,27 +92,6 @@ struct QQ : Module {
         configLight(TRACK3_TRIG_LIGHT, "Track 3 Trigger");
     }
 
-    float smoothDecayEnvelope(float t, float totalTime, float shapeParam) {
-        if (t >= totalTime) return 0.f;
-        
-        float normalizedT = t / totalTime;
-        
-        float frontK = -0.9f + shapeParam * 0.5f;
-        float backK = -1.0f + 1.6f * std::pow(shapeParam, 0.3f);
-        
-        float transition = normalizedT * normalizedT * (3.f - 2.f * normalizedT);
-        float k = frontK + (backK - frontK) * transition;
-        
-        float absT = std::abs(normalizedT);
-        float denominator = k - 2.f * k * absT + 1.f;
-        if (std::abs(denominator) < 1e-10f) {
-            return 1.f - normalizedT;
-        }
-        
-        float curveResult = (normalizedT - k * normalizedT) / denominator;
-        return 1.f - curveResult;
-    }
-
     void process(const ProcessArgs& args) override {
         for (int i = 0; i < 3; i++) {
             bool triggered = tracks[i].trigTrigger.process(inputs[TRACK1_TRIG_INPUT + i].getVoltage(), 0.1f, 2.f);
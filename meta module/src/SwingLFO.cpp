@@ -1,4 +1,5 @@
 #include "plugin.hpp"
+#include "fastmath.hpp"
 
 struct SwingLFO : Module {
     enum ParamId {
@@ -92,7 +93,7 @@ struct SwingLFO : Module {
         if (inputs[FREQ_CV_INPUT].isConnected()) {
             freqCV = inputs[FREQ_CV_INPUT].getVoltage() * freqCVAttenuation;
         }
-        float freq = std::pow(2.0f, freqParam + freqCV) * 1.0f;
+        float freq = fastExp2(freqParam + freqCV) * 1.0f;
         
         float swingParam = params[SWING_PARAM].getValue();
         float swingCV = 0.0f;
@@ -1,4 +1,8 @@
 #include "plugin.hpp"
+#include "divmult.hpp"
+#include "envelope.hpp"
+#include "fastmath.hpp"
+#include "noise.hpp"
 
 static const float kFreqKnobMin = 20.f;
 static const float kFreqKnobMax = 20000.f;
@@ -51,100 +55,6 @@ void generateTechnoEuclideanRhythm(bool pattern[], int length, int fill, int shi
     }
 }
 
-template <int QUALITY = 8>
-struct PinkNoiseGenerator {
-    int frame = -1;
-    float values[QUALITY] = {};
-
-    float process() {
-        int lastFrame = frame;
-        frame++;
-        if (frame >= (1 << QUALITY))
-            frame = 0;
-        int diff = lastFrame ^ frame;
-
-        float sum = 0.f;
-        for (int i = 0; i < QUALITY; i++) {
-            if (diff & (1 << i)) {
-                values[i] = random::uniform() - 0.5f;
-            }
-            sum += values[i];
-        }
-        return sum;
-    }
-};
-
-struct UnifiedEnvelope {
-    dsp::SchmittTrigger trigTrigger;
-    dsp::PulseGenerator trigPulse;
-    float phase = 0.f;
-    bool gateState = false;
-    static constexpr float ATTACK_TIME = 0.001f;
-    
-    void reset() {
-        trigTrigger.reset();
-        trigPulse.reset();
-        phase = 0.f;
-        gateState = false;
-    }
-    
-    float smoothDecayEnvelope(float t, float totalTime, float shapeParam) {
-        if (t >= totalTime) return 0.f;
-        
-        float normalizedT = t / totalTime;
-        
-        float frontK = -0.9f + shapeParam * 0.5f;
-        float backK = -1.0f + 1.6f * std::pow(shapeParam, 0.3f);
-        
-        float transition = normalizedT * normalizedT * (3.f - 2.f * normalizedT);
-        float k = frontK + (backK - frontK) * transition;
-        
-        float absT = std::abs(normalizedT);
-        float denominator = k - 2.f * k * absT + 1.f;
-        if (std::abs(denominator) < 1e-10f) {
-            return 1.f - normalizedT;
-        }
-        
-        float curveResult = (normalizedT - k * normalizedT) / denominator;
-        return 1.f - curveResult;
-    }
-    
-    float process(float sampleTime, float triggerVoltage, float decayTime, float shapeParam) {
-        bool triggered = trigTrigger.process(triggerVoltage, 0.1f, 2.f);
-        
-        if (triggered) {
-            phase = 0.f;
-            gateState = true;
-            trigPulse.trigger(0.03f);
-        }
-        
-        float envOutput = 0.f;
-        
-        if (gateState) {
-            if (phase < ATTACK_TIME) {
-                envOutput = phase / ATTACK_TIME;
-            } else {
-                float decayPhase = phase - ATTACK_TIME;
-                
-                if (decayPhase >= decayTime) {
-                    gateState = false;
-                    envOutput = 0.f;
-                } else {
-                    envOutput = smoothDecayEnvelope(decayPhase, decayTime, shapeParam);
-                }
-            }
-            
-            phase += sampleTime;
-        }
-        
-        return clamp(envOutput, 0.f, 1.f);
-    }
-    
-    float getTrigger(float sampleTime) {
-        return trigPulse.process(sampleTime) ? 10.0f : 0.0f;
-    }
-};
-
 struct SimpleLPG {
     dsp::SchmittTrigger trigger;
     dsp::BiquadFilter lpf;
@@ -184,7 +94,7 @@ struct SimpleSineVCO {
     }
     
     float process(float freq_hz, float fm_cv) {
-        float modulated_freq = freq_hz * std::pow(2.0f, fm_cv);
+        float modulated_freq = freq_hz * fastExp2(fm_cv);
         modulated_freq = clamp(modulated_freq, 1.0f, sampleRate * 0.45f);
         
         float delta_phase = modulated_freq / sampleRate;
@@ -194,7 +104,7 @@ struct SimpleSineVCO {
             phase -= 1.0f;
         }
         
-        float sine_wave = std::sin(2.0f * M_PI * phase);
+        float sine_wave = fastSin2pi(phase);
         
         return sine_wave * 5.0f;
     }
@@ -248,8 +158,7 @@ struct TWNC : Module {
     dsp::SchmittTrigger resetTrigger;
     dsp::SchmittTrigger manualResetTrigger;
     
-    float globalClockSeconds = 0.5f;
-    float secondsSinceLastClock = -1.0f;
+    ClockPeriod clockPeriod;
     
     dsp::PulseGenerator track1FlashPulse;
     dsp::PulseGenerator track2FlashPulse;
@@ -294,13 +203,7 @@ struct TWNC : Module {
         int divMultValue = 0;
         int division = 1;
         int multiplication = 1;
-        float dividedClockSeconds = 0.5f;
-        float multipliedClockSeconds = 0.5f;
-        float dividedProgressSeconds = 0.0f;
-        float gateSeconds = 0.0f;
-        int dividerCount = 0;
-        bool shouldStep = false;
-        bool prevMultipliedGate = false;
+        ClockDivMult clock;
         
         int currentStep = 0;
         int length = 16;
@@ -314,10 +217,7 @@ struct TWNC : Module {
         UnifiedEnvelope vcaEnvelope;
 
         void reset() {
-            dividedProgressSeconds = 0.0f;
-            dividerCount = 0;
-            shouldStep = false;
-            prevMultipliedGate = false;
+            clock.reset();
             currentStep = 0;
             for (int i = 0; i < 32; ++i) {
                 pattern[i] = false;
@@ -357,42 +257,6 @@ struct TWNC : Module {
             }
         }
         
-        bool processClockDivMult(bool globalClock, float globalClockSeconds, float sampleTime) {
-            dividedClockSeconds = globalClockSeconds * (float)division;
-            multipliedClockSeconds = dividedClockSeconds / (float)multiplication;
-            gateSeconds = std::max(0.001f, multipliedClockSeconds * 0.5f);
-            
-            if (globalClock) {
-                if (dividerCount < 1) {
-                    dividedProgressSeconds = 0.0f;
-                } else {
-                    dividedProgressSeconds += sampleTime;
-                }
-                ++dividerCount;
-                if (dividerCount >= division) {
-                    dividerCount = 0;
-                }
-            } else {
-                dividedProgressSeconds += sampleTime;
-            }
-            
-            shouldStep = false;
-            if (dividedProgressSeconds < dividedClockSeconds) {
-                float multipliedProgressSeconds = dividedProgressSeconds / multipliedClockSeconds;
-                multipliedProgressSeconds -= (float)(int)multipliedProgressSeconds;
-                multipliedProgressSeconds *= multipliedClockSeconds;
-                
-                bool currentMultipliedGate = multipliedProgressSeconds <= gateSeconds;
-                
-                if (currentMultipliedGate && !prevMultipliedGate) {
-                    shouldStep = true;
-                }
-                prevMultipliedGate = currentMultipliedGate;
-            }
-            
-            return shouldStep;
-        }
-        
         void stepTrack() {
             currentStep = (currentStep + 1) % length;
             gateState = pattern[currentStep];
@@ -484,8 +348,7 @@ struct TWNC : Module {
     }
 
     void onReset() override {
-        secondsSinceLastClock = -1.0f;
-        globalClockSeconds = 0.5f;
+        clockPeriod.reset();
         for (int i = 0; i < 2; ++i) {
             tracks[i].reset();
         }
@@ -517,17 +380,7 @@ struct TWNC : Module {
             return;
         }
         
-        if (globalClockTriggered) {
-            if (secondsSinceLastClock > 0.0f) {
-                globalClockSeconds = secondsSinceLastClock;
-                globalClockSeconds = clamp(globalClockSeconds, 0.01f, 10.0f);
-            }
-            secondsSinceLastClock = 0.0f;
-        }
-        
-        if (secondsSinceLastClock >= 0.0f) {
-            secondsSinceLastClock += args.sampleTime;
-        }
+        int64_t clockPeriodSamples = clockPeriod.process(globalClockTriggered, args.sampleRate);
 
         int globalLength = (int)std::round(params[GLOBAL_LENGTH_PARAM].getValue());
         globalLength = clamp(globalLength, 1, 32);
@@ -561,7 +414,7 @@ struct TWNC : Module {
 
             generateTechnoEuclideanRhythm(track.pattern, track.length, track.fill, track.shift);
 
-            bool trackClockTrigger = track.processClockDivMult(globalClockTriggered, globalClockSeconds, args.sampleTime);
+            bool trackClockTrigger = track.clock.process(globalClockTriggered, clockPeriodSamples, track.division, track.multiplication);
 
             if (trackClockTrigger && globalClockActive) {
                 track.stepTrack();
@@ -599,7 +452,7 @@ struct TWNC : Module {
                 if (inputs[DRUM_FREQ_CV_INPUT].isConnected()) {
                     freqParam += inputs[DRUM_FREQ_CV_INPUT].getVoltage();
                 }
-                freqParam = std::pow(2.0f, freqParam);
+                freqParam = fastExp2(freqParam);
                 float envelopeFM = envelopeOutput * fmAmount * 4.0f;
                 float totalFM = envelopeFM + processedFM;
                 
@@ -649,7 +502,7 @@ struct TWNC : Module {
                 if (inputs[HATS_FREQ_CV_INPUT].isConnected()) {
                     freqParam += inputs[HATS_FREQ_CV_INPUT].getVoltage();
                 }
-                freqParam = std::pow(2.0f, freqParam);
+                freqParam = fastExp2(freqParam);
                 float audioOutput = sineVCO2.process(freqParam, noiseBlend);
                 
                 float vcaEnvelopeOutput = track.vcaEnvelope.process(args.sampleTime, triggerOutput, decayParam * 0.5f, shapeParam);
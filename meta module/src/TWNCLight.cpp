@@ -1,4 +1,6 @@
 #include "plugin.hpp"
+#include "divmult.hpp"
+#include "envelope.hpp"
 
 struct TWNCLightDivMultParamQuantity : ParamQuantity {
     std::string getDisplayValueString() override {
@@ -48,77 +50,6 @@ void generateTWNCLightEuclideanRhythm(bool pattern[], int length, int fill, int
     }
 }
 
-struct UnifiedEnvelope {
-    dsp::SchmittTrigger trigTrigger;
-    dsp::PulseGenerator trigPulse;
-    float phase = 0.f;
-    bool gateState = false;
-    static constexpr float ATTACK_TIME = 0.001f;
-    
-    void reset() {
-        trigTrigger.reset();
-        trigPulse.reset();
-        phase = 0.f;
-        gateState = false;
-    }
-    
-    float smoothDecayEnvelope(float t, float totalTime, float shapeParam) {
-        if (t >= totalTime) return 0.f;
-        
-        float normalizedT = t / totalTime;
-        
-        float frontK = -0.9f + shapeParam * 0.5f;
-        float backK = -1.0f + 1.6f * std::pow(shapeParam, 0.3f);
-        
-        float transition = normalizedT * normalizedT * (3.f - 2.f * normalizedT);
-        float k = frontK + (backK - frontK) * transition;
-        
-        float absT = std::abs(normalizedT);
-        float denominator = k - 2.f * k * absT + 1.f;
-        if (std::abs(denominator) < 1e-10f) {
-            return 1.f - normalizedT;
-        }
-        
-        float curveResult = (normalizedT - k * normalizedT) / denominator;
-        return 1.f - curveResult;
-    }
-    
-    float process(float sampleTime, float triggerVoltage, float decayTime, float shapeParam) {
-        bool triggered = trigTrigger.process(triggerVoltage, 0.1f, 2.f);
-        
-        if (triggered) {
-            phase = 0.f;
-            gateState = true;
-            trigPulse.trigger(0.03f);
-        }
-        
-        float envOutput = 0.f;
-        
-        if (gateState) {
-            if (phase < ATTACK_TIME) {
-                envOutput = phase / ATTACK_TIME;
-            } else {
-                float decayPhase = phase - ATTACK_TIME;
-                
-                if (decayPhase >= decayTime) {
-                    gateState = false;
-                    envOutput = 0.f;
-                } else {
-                    envOutput = smoothDecayEnvelope(decayPhase, decayTime, shapeParam);
-                }
-            }
-            
-            phase += sampleTime;
-        }
-        
-        return clamp(envOutput, 0.f, 1.f);
-    }
-    
-    float getTrigger(float sampleTime) {
-        return trigPulse.process(sampleTime) ? 10.0f : 0.0f;
-    }
-};
-
 struct TWNCLight : Module {
     enum ParamId {
         GLOBAL_LENGTH_PARAM,
@@ -153,8 +84,7 @@ struct TWNCLight : Module {
 
     dsp::SchmittTrigger clockTrigger;
     
-    float globalClockSeconds = 0.5f;
-    float secondsSinceLastClock = -1.0f;
+    ClockPeriod clockPeriod;
     int globalClockCount = 0;
 
     struct QuarterNoteClock {
@@ -189,13 +119,7 @@ struct TWNCLight : Module {
         int divMultValue = 0;
         int division = 1;
         int multiplication = 1;
-        float dividedClockSeconds = 0.5f;
-        float multipliedClockSeconds = 0.5f;
-        float dividedProgressSeconds = 0.0f;
-        float gateSeconds = 0.0f;
-        int dividerCount = 0;
-        bool shouldStep = false;
-        bool prevMultipliedGate = false;
+        ClockDivMult clock;
         
         int currentStep = 0;
         int length = 16;
@@ -209,10 +133,7 @@ struct TWNCLight : Module {
         UnifiedEnvelope vcaEnvelope;
 
         void reset() {
-            dividedProgressSeconds = 0.0f;
-            dividerCount = 0;
-            shouldStep = false;
-            prevMultipliedGate = false;
+            clock.reset();
             currentStep = 0;
             for (int i = 0; i < 32; ++i) {
                 pattern[i] = false;
@@ -226,10 +147,7 @@ struct TWNCLight : Module {
             int newDivMultValue = divMultParam;
             if (newDivMultValue != divMultValue) {
                 divMultValue = newDivMultValue;
-                dividedProgressSeconds = 0.0f;
-                dividerCount = 0;
-                shouldStep = false;
-                prevMultipliedGate = false;
+                clock.reset();
             }
             
             switch (divMultParam) {
@@ -260,42 +178,6 @@ struct TWNCLight : Module {
             }
         }
         
-        bool processClockDivMult(bool globalClock, float globalClockSeconds, float sampleTime) {
-            dividedClockSeconds = globalClockSeconds * (float)division;
-            multipliedClockSeconds = dividedClockSeconds / (float)multiplication;
-            gateSeconds = std::max(0.001f, multipliedClockSeconds * 0.5f);
-            
-            if (globalClock) {
-                if (dividerCount < 1) {
-                    dividedProgressSeconds = 0.0f;
-                } else {
-                    dividedProgressSeconds += sampleTime;
-                }
-                ++dividerCount;
-                if (dividerCount >= division) {
-                    dividerCount = 0;
-                }
-            } else {
-                dividedProgressSeconds += sampleTime;
-            }
-            
-            shouldStep = false;
-            if (dividedProgressSeconds < dividedClockSeconds) {
-                float multipliedProgressSeconds = dividedProgressSeconds / multipliedClockSeconds;
-                multipliedProgressSeconds -= (float)(int)multipliedProgressSeconds;
-                multipliedProgressSeconds *= multipliedClockSeconds;
-                
-                bool currentMultipliedGate = multipliedProgressSeconds <= gateSeconds;
-                
-                if (currentMultipliedGate && !prevMultipliedGate) {
-                    shouldStep = true;
-                }
-                prevMultipliedGate = currentMultipliedGate;
-            }
-            
-            return shouldStep;
-        }
-        
         void stepTrack() {
             currentStep = (currentStep + 1) % length;
             gateState = pattern[currentStep];
@@ -307,6 +189,9 @@ struct TWNCLight : Module {
     TrackState tracks[2];
     QuarterNoteClock quarterClock;
     UnifiedEnvelope mainVCA;
+    // Hats fire three clocks after each accent.
+    int hatsDelayCounter = 0;
+    bool hatsDelayActive = false;
 
     TWNCLight() {
         config(PARAMS_LEN, INPUTS_LEN, OUTPUTS_LEN, LIGHTS_LEN);
@@ -361,14 +246,15 @@ struct TWNCLight : Module {
     }
 
     void onReset() override {
-        secondsSinceLastClock = -1.0f;
-        globalClockSeconds = 0.5f;
+        clockPeriod.reset();
         globalClockCount = 0;
         for (int i = 0; i < 2; ++i) {
             tracks[i].reset();
         }
         quarterClock.reset();
         mainVCA.reset();
+        hatsDelayCounter = 0;
+        hatsDelayActive = false;
     }
 
     void process(const ProcessArgs& args) override {
@@ -391,17 +277,7 @@ struct TWNCLight : Module {
             }
         }
         
-        if (globalClockTriggered) {
-            if (secondsSinceLastClock > 0.0f) {
-                globalClockSeconds = secondsSinceLastClock;
-                globalClockSeconds = clamp(globalClockSeconds, 0.01f, 10.0f);
-            }
-            secondsSinceLastClock = 0.0f;
-        }
-        
-        if (secondsSinceLastClock >= 0.0f) {
-            secondsSinceLastClock += args.sampleTime;
-        }
+        int64_t clockPeriodSamples = clockPeriod.process(globalClockTriggered, args.sampleRate);
 
         int globalLength = (int)std::round(params[GLOBAL_LENGTH_PARAM].getValue());
         globalLength = clamp(globalLength, 1, 32);
@@ -410,9 +286,6 @@ struct TWNCLight : Module {
         bool vcaTriggered = quarterClock.processStep(globalClockTriggered, globalLength, vcaShift);
         float vcaTrigger = quarterClock.getTrigger(args.sampleTime);
         
-        static int hatsDelayCounter = 0;
-        static bool hatsDelayActive = false;
-
         if (vcaTriggered) {
             hatsDelayCounter = 3;
             hatsDelayActive = true;
@@ -446,14 +319,14 @@ struct TWNCLight : Module {
             track.shift = 0;
             generateTWNCLightEuclideanRhythm(track.pattern, track.length, track.fill, track.shift);
 
-            bool trackClockTrigger = track.processClockDivMult(globalClockTriggered, globalClockSeconds, args.sampleTime);
-
+            // Track 2 divides the delayed hats trigger instead of the clock.
             if (i == 1) {
-                bool delayedClockTrigger = track.processClockDivMult(hatsManualTrigger, globalClockSeconds, args.sampleTime);
+                bool delayedClockTrigger = track.clock.process(hatsManualTrigger, clockPeriodSamples, track.division, track.multiplication);
                 if (delayedClockTrigger && globalClockActive) {
                     track.stepTrack();
                 }
             } else {
+                bool trackClockTrigger = track.clock.process(globalClockTriggered, clockPeriodSamples, track.division, track.multiplication);
                 if (trackClockTrigger && globalClockActive) {
                     track.stepTrack();
                 }